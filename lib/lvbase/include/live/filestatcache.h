@@ -0,0 +1 @@
+#include "../../src/filestatcache.h"
@@ -0,0 +1 @@
+#include "../../src/flatmap.h"
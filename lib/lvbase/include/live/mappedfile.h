@@ -0,0 +1 @@
+#include "../../src/mappedfile.h"
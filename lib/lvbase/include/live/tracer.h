@@ -0,0 +1 @@
+#include "../../src/tracer.h"
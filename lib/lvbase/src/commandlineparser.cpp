@@ -31,6 +31,7 @@ class CommandLineParserPrivate{
 public:
     std::vector<CommandLineParser::Option*> options;
     std::string              header;
+    std::string              usage;
     std::string              version;
 
     std::vector<std::string> arguments;
@@ -98,6 +99,7 @@ CommandLineParser::CommandLineParser(const std::string &header)
     : m_d(new CommandLineParserPrivate)
 {
     m_d->header     = header;
+    m_d->usage      = "livekeys [options...] script.qml [args ...]";
     m_helpOption    = addFlag({"-h", "--help"},    "Displays this information and exits.");
     m_versionOption = addFlag({"-v", "--version"}, "Displays version information and exits.");
 }
@@ -175,6 +177,13 @@ CommandLineParser::Option *CommandLineParser::findOptionByShortName(const std::s
     return 0;
 }
 
+/**
+ * \brief Sets the usage line shown in the help string, i.e. "livekeys [options...] script.qml [args ...]"
+ */
+void CommandLineParser::setUsage(const std::string &usage){
+    m_d->usage = usage;
+}
+
 /**
  * \brief Represents a string containing all of the pre-set options, their names, descriptions, types etc.
  *
@@ -182,7 +191,7 @@ CommandLineParser::Option *CommandLineParser::findOptionByShortName(const std::s
  */
 std::string CommandLineParser::helpString() const{
     std::stringstream base;
-    base << "\n" << m_d->header << "\n\n" << "Usage:\n\n   livekeys [options...] script.qml [args ...]\n\nOptions:\n\n";
+    base << "\n" << m_d->header << "\n\n" << "Usage:\n\n   " << m_d->usage << "\n\nOptions:\n\n";
     for ( auto it = m_d->options.begin(); it != m_d->options.end(); ++it ){
         for ( auto nameIt = (*it)->shortNames.begin(); nameIt != (*it)->shortNames.end(); ++nameIt ){
             base << std::string("  ") << "-" << *nameIt << ((*it)->type != "" ? " <" + (*it)->type + ">" : "");
@@ -61,6 +61,7 @@ public:
 
     const std::vector<std::string>& arguments() const;
 
+    void setUsage(const std::string& usage);
     std::string helpString() const;
     std::vector<std::string> optionNames(Option* option) const;
 
@@ -16,6 +16,10 @@
 #include "fileio.h"
 #include "live/exception.h"
 #include "live/visuallog.h"
+#include "live/mlnodetojson.h"
+#include "filestatcache.h"
+#include "path.h"
+#include <cstdio>
 #include <fstream>
 #include <istream>
 
@@ -27,6 +31,28 @@ FileIOInterface::FileIOInterface(){
 FileIOInterface::~FileIOInterface(){
 }
 
+/**
+ * \brief Serializes \p content to json and writes it to \p path
+ *
+ * The default implementation goes through writeToFile. Implementations that write to disk can stream
+ * the json instead.
+ */
+bool FileIOInterface::writeJsonToFile(const std::string &path, const MLNode &content){
+    std::string result;
+    ml::toJson(content, result);
+    return writeToFile(path, result);
+}
+
+/**
+ * \brief Writes \p content to \p path, for files that may be read while they are being replaced
+ *
+ * The default implementation goes through writeToFile. Implementations that write to disk replace
+ * the file atomically.
+ */
+bool FileIOInterface::replaceFile(const std::string &path, const char *content, size_t length){
+    return writeToFile(path, content, length);
+}
+
 FileIO::FileIO(){
 }
 
@@ -66,6 +92,45 @@ bool FileIO::writeToFile(const std::string &path, const char *content, size_t le
     outStream.write(content, static_cast<int>(length));
     outStream.close();
 
+    if ( FileStatCache* cache = FileStatCache::active() )
+        cache->invalidate(path);
+
+    return true;
+}
+
+/**
+ * \brief Streams \p content as json to \p path, atomically replacing any existing file
+ */
+bool FileIO::writeJsonToFile(const std::string &path, const MLNode &content){
+    ml::toJsonFile(content, path);
+    return true;
+}
+
+/**
+ * \brief Writes \p content to a temporary file next to \p path, then renames it over \p path
+ *
+ * Readers, including ones that map the file, see either the previous file or the complete new one.
+ */
+bool FileIO::replaceFile(const std::string &path, const char *content, size_t length){
+    std::string tempPath = Path::temporarySiblingPath(path);
+
+    FILE* file = std::fopen(tempPath.c_str(), "wbx");
+    if ( !file ){
+        THROW_EXCEPTION(lv::Exception, Utf8("Failed to open file for writing: %").format(tempPath), lv::Exception::toCode("~File"));
+    }
+
+    bool writeFailed = length > 0 && std::fwrite(content, 1, length, file) != length;
+    if ( std::fclose(file) != 0 || writeFailed ){
+        std::remove(tempPath.c_str());
+        THROW_EXCEPTION(lv::Exception, Utf8("Failed to write file: %").format(tempPath), lv::Exception::toCode("~File"));
+    }
+
+    try{
+        Path::rename(tempPath, path);
+    } catch ( std::exception& e ){
+        std::remove(tempPath.c_str());
+        THROW_EXCEPTION(lv::Exception, Utf8("Failed to replace file %: %").format(path, e.what()), lv::Exception::toCode("~File"));
+    }
     return true;
 }
 
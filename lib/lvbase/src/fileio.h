@@ -22,6 +22,8 @@
 
 namespace lv{
 
+class MLNode;
+
 class LV_BASE_EXPORT FileIOInterface{
 
 public:
@@ -34,6 +36,8 @@ public:
     virtual std::string readFromFile(const std::string& path) = 0;
     virtual bool writeToFile(const std::string& path, const std::string& content) = 0;
     virtual bool writeToFile(const std::string& path, const char* content, size_t length) = 0;
+    virtual bool writeJsonToFile(const std::string& path, const MLNode& content);
+    virtual bool replaceFile(const std::string& path, const char* content, size_t length);
 };
 
 class LV_BASE_EXPORT FileIO : public FileIOInterface{
@@ -45,6 +49,8 @@ public:
     std::string readFromFile(const std::string& path) override;
     bool writeToFile(const std::string& path, const std::string& content) override;
     bool writeToFile(const std::string& path, const char* content, size_t length) override;
+    bool writeJsonToFile(const std::string& path, const MLNode& content) override;
+    bool replaceFile(const std::string& path, const char* content, size_t length) override;
 
 };
 
@@ -0,0 +1,419 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 Dinu SV.
+** This file is part of Livekeys Application.
+**
+** GNU Lesser General Public License Usage
+** This file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+****************************************************************************/
+
+#include "filestatcache.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+#if defined(__GNUC__) && !defined(__llvm__) && !defined(__INTEL_COMPILER)
+#  if(__GNUC__ > 7)
+#    include <filesystem>
+     namespace fs = std::filesystem;
+#  else
+#    include <experimental/filesystem>
+     namespace fs = std::experimental::filesystem;
+#  endif
+#else
+#  include <filesystem>
+   namespace fs = std::filesystem;
+#endif
+
+#ifdef PLATFORM_OS_LINUX
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+/**
+ * \class lv::FileStatCache
+ * \brief Caches file system metadata queried through lv::Path
+ *
+ * While a cache is active on a thread (see FileStatCache::Scope), Path::exists, Path::isDir, Path::isFile,
+ * Path::lastModified and Path::fileSize are answered from the cache, and each path is queried
+ * from the file system at most once. Writes done through lv::Path and lv::FileIO invalidate
+ * the affected entries.
+ *
+ * External changes are not seen unless the watcher is enabled, which on Linux uses inotify on
+ * the directories of the cached paths.
+ *
+ * \ingroup lvbase
+ */
+
+namespace lv{
+
+namespace{
+
+// Each thread activates its own cache, so workers compiling in parallel don't overwrite each
+// other's scope. Tasks handed to other threads have to activate the cache explicitly.
+FileStatCache*& activeStatCache(){
+    thread_local FileStatCache* cache = nullptr;
+    return cache;
+}
+
+bool isUnderPath(const std::string& path, const std::string& root){
+    if ( root.empty() )
+        return false;
+    if ( path.size() <= root.size() || path.compare(0, root.size(), root) != 0 )
+        return false;
+    char c = path[root.size()];
+    return c == '/' || c == '\\' || root.back() == '/' || root.back() == '\\';
+}
+
+} // namespace
+
+/// \private
+class FileStatCachePrivate{
+
+public:
+    class Entry{
+    public:
+        fs::file_type  type;
+        std::int64_t   lastModifiedMs;
+        std::uintmax_t size;
+    };
+
+    FileStatCachePrivate() : hits(0), misses(0), generation(0), watcherFd(-1){
+        wakeFds[0] = -1;
+        wakeFds[1] = -1;
+    }
+
+    Entry entry(const std::string& path);
+    Entry load(const std::string& path);
+    void  eraseWithAncestors(const std::string& path);
+
+    void watch(const std::string& path);
+    void runWatcher();
+    void stopWatcher();
+
+    std::mutex mutex;
+    std::unordered_map<std::string, Entry> entries;
+    std::atomic<size_t> hits;
+    std::atomic<size_t> misses;
+    std::uint64_t generation; // bumped on every invalidation, guarded by mutex
+
+    int                                  watcherFd;
+    int                                  wakeFds[2];
+    std::thread                          watcherThread;
+    std::unordered_map<int, std::string> watchedDirectories;
+    std::unordered_set<std::string>      watchedPaths;
+};
+
+FileStatCachePrivate::Entry FileStatCachePrivate::entry(const std::string &path){
+    std::uint64_t loadGeneration;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(path);
+        if ( it != entries.end() ){
+            ++hits;
+            return it->second;
+        }
+        ++misses;
+
+        // Watch before querying, so a change that lands while the query is in flight is seen
+        // by the watcher and bumps the generation instead of being lost.
+        if ( watcherFd != -1 )
+            watch(path);
+        loadGeneration = generation;
+    }
+
+    Entry e = load(path);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if ( generation == loadGeneration )
+        entries[path] = e;
+    return e;
+}
+
+FileStatCachePrivate::Entry FileStatCachePrivate::load(const std::string &path){
+    Entry e;
+    e.lastModifiedMs = 0;
+    e.size = 0;
+
+    std::error_code ec;
+    e.type = fs::status(path, ec).type();
+    if ( ec && e.type != fs::file_type::not_found )
+        e.type = fs::file_type::not_found;
+
+    if ( e.type != fs::file_type::not_found ){
+        auto t = fs::last_write_time(path, ec);
+        if ( !ec ){
+            auto st = std::chrono::time_point_cast<std::chrono::system_clock::duration>(
+                t - decltype(t)::clock::now() + std::chrono::system_clock::now()
+            );
+            e.lastModifiedMs = std::chrono::time_point_cast<std::chrono::milliseconds>(st).time_since_epoch().count();
+        }
+        if ( e.type == fs::file_type::regular ){
+            std::uintmax_t size = fs::file_size(path, ec);
+            if ( !ec )
+                e.size = size;
+        }
+    }
+    return e;
+}
+
+void FileStatCachePrivate::eraseWithAncestors(const std::string &path){
+    entries.erase(path);
+    fs::path current(path);
+    while ( current.has_relative_path() ){
+        fs::path parent = current.parent_path();
+        if ( parent == current || parent.empty() )
+            break;
+        entries.erase(parent.string());
+        current = parent;
+    }
+}
+
+/** Watches the closest existing directory that contains \p path. Expects the mutex to be locked. */
+void FileStatCachePrivate::watch(const std::string &path){
+#ifdef PLATFORM_OS_LINUX
+    fs::path dir = fs::path(path).parent_path();
+    std::error_code ec;
+    while ( !dir.empty() && !fs::is_directory(dir, ec) ){
+        fs::path parent = dir.parent_path();
+        if ( parent == dir )
+            return;
+        dir = parent;
+    }
+    if ( dir.empty() )
+        return;
+
+    std::string dirPath = dir.string();
+    if ( watchedPaths.find(dirPath) != watchedPaths.end() )
+        return;
+
+    int wd = inotify_add_watch(
+        watcherFd, dirPath.c_str(),
+        IN_CREATE | IN_DELETE | IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE |
+        IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF
+    );
+    if ( wd >= 0 ){
+        watchedDirectories[wd] = dirPath;
+        watchedPaths.insert(dirPath);
+    }
+#else
+    MARK_UNUSED(path);
+#endif
+}
+
+void FileStatCachePrivate::runWatcher(){
+#ifdef PLATFORM_OS_LINUX
+    alignas(inotify_event) char buffer[16 * 1024];
+
+    pollfd fds[2];
+    fds[0].fd = watcherFd;
+    fds[0].events = POLLIN;
+    fds[1].fd = wakeFds[0];
+    fds[1].events = POLLIN;
+
+    while ( true ){
+        if ( poll(fds, 2, -1) < 0 )
+            continue;
+        if ( fds[1].revents )
+            return;
+        if ( !(fds[0].revents & POLLIN) )
+            continue;
+
+        ssize_t length = read(watcherFd, buffer, sizeof(buffer));
+        if ( length <= 0 )
+            continue;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for ( char* ptr = buffer; ptr < buffer + length; ){
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(ptr);
+            ptr += sizeof(inotify_event) + event->len;
+
+            ++generation;
+            if ( event->mask & IN_Q_OVERFLOW ){
+                entries.clear();
+                continue;
+            }
+
+            auto dirIt = watchedDirectories.find(event->wd);
+            if ( dirIt == watchedDirectories.end() )
+                continue;
+
+            std::string changed = event->len > 0 ? dirIt->second + "/" + event->name : dirIt->second;
+
+            eraseWithAncestors(changed);
+            for ( auto it = entries.begin(); it != entries.end(); ){
+                if ( isUnderPath(it->first, changed) ){
+                    it = entries.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+
+            if ( event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED) ){
+                watchedPaths.erase(dirIt->second);
+                watchedDirectories.erase(dirIt);
+            }
+        }
+    }
+#endif
+}
+
+void FileStatCachePrivate::stopWatcher(){
+#ifdef PLATFORM_OS_LINUX
+    if ( watcherFd == -1 )
+        return;
+
+    char c = 0;
+    if ( write(wakeFds[1], &c, 1) == 1 && watcherThread.joinable() )
+        watcherThread.join();
+
+    close(watcherFd);
+    close(wakeFds[0]);
+    close(wakeFds[1]);
+    watcherFd = -1;
+#endif
+}
+
+
+// class FileStatCache
+// ----------------------------------------------------------------------------
+
+FileStatCache::FileStatCache()
+    : m_d(new FileStatCachePrivate)
+{
+}
+
+FileStatCache::~FileStatCache(){
+    if ( activeStatCache() == this )
+        activeStatCache() = nullptr;
+    m_d->stopWatcher();
+    delete m_d;
+}
+
+bool FileStatCache::exists(const std::string &path){
+    return m_d->entry(path).type != fs::file_type::not_found;
+}
+
+bool FileStatCache::isDir(const std::string &path){
+    return m_d->entry(path).type == fs::file_type::directory;
+}
+
+bool FileStatCache::isFile(const std::string &path){
+    return m_d->entry(path).type == fs::file_type::regular;
+}
+
+/** Last modified time in milliseconds since epoch, 0 if the path does not exist */
+std::int64_t FileStatCache::lastModifiedMs(const std::string &path){
+    return m_d->entry(path).lastModifiedMs;
+}
+
+/** File size in bytes, 0 if the path is not a regular file */
+std::uintmax_t FileStatCache::fileSize(const std::string &path){
+    return m_d->entry(path).size;
+}
+
+/** Drops the entry for \p path and for its parent directories */
+void FileStatCache::invalidate(const std::string &path){
+    std::lock_guard<std::mutex> lock(m_d->mutex);
+    ++m_d->generation;
+    m_d->eraseWithAncestors(path);
+}
+
+/** Drops the entries for \p path, everything under it, and its parent directories */
+void FileStatCache::invalidateTree(const std::string &path){
+    std::lock_guard<std::mutex> lock(m_d->mutex);
+    ++m_d->generation;
+    m_d->eraseWithAncestors(path);
+    for ( auto it = m_d->entries.begin(); it != m_d->entries.end(); ){
+        if ( isUnderPath(it->first, path) ){
+            it = m_d->entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void FileStatCache::clear(){
+    std::lock_guard<std::mutex> lock(m_d->mutex);
+    ++m_d->generation;
+    m_d->entries.clear();
+}
+
+/**
+ * \brief Starts watching cached paths for external changes
+ *
+ * Returns false if watching is not supported on this platform or could not be started.
+ */
+bool FileStatCache::enableWatcher(){
+#ifdef PLATFORM_OS_LINUX
+    std::lock_guard<std::mutex> lock(m_d->mutex);
+    if ( m_d->watcherFd != -1 )
+        return true;
+
+    int fd = inotify_init1(IN_CLOEXEC);
+    if ( fd < 0 )
+        return false;
+    if ( pipe(m_d->wakeFds) != 0 ){
+        close(fd);
+        return false;
+    }
+
+    m_d->watcherFd = fd;
+    for ( auto it = m_d->entries.begin(); it != m_d->entries.end(); ++it )
+        m_d->watch(it->first);
+
+    m_d->watcherThread = std::thread(&FileStatCachePrivate::runWatcher, m_d);
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool FileStatCache::isWatching() const{
+    return m_d->watcherFd != -1;
+}
+
+size_t FileStatCache::hits() const{
+    return m_d->hits;
+}
+
+size_t FileStatCache::misses() const{
+    return m_d->misses;
+}
+
+/** Returns the cache used by lv::Path queries on the calling thread, or nullptr if there's none active */
+FileStatCache *FileStatCache::active(){
+    return activeStatCache();
+}
+
+
+// class FileStatCache::Scope
+// ----------------------------------------------------------------------------
+
+FileStatCache::Scope::Scope(FileStatCache *cache)
+    : m_previous(nullptr)
+    , m_activated(cache != nullptr)
+{
+    if ( m_activated ){
+        m_previous = activeStatCache();
+        activeStatCache() = cache;
+    }
+}
+
+FileStatCache::Scope::~Scope(){
+    if ( m_activated )
+        activeStatCache() = m_previous;
+}
+
+}// namespace
@@ -0,0 +1,79 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 Dinu SV.
+** This file is part of Livekeys Application.
+**
+** GNU Lesser General Public License Usage
+** This file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+****************************************************************************/
+
+#ifndef LVFILESTATCACHE_H
+#define LVFILESTATCACHE_H
+
+#include "live/lvbaseglobal.h"
+
+#include <string>
+#include <cstdint>
+
+namespace lv{
+
+class FileStatCachePrivate;
+class LV_BASE_EXPORT FileStatCache{
+
+    DISABLE_COPY(FileStatCache);
+
+public:
+    /**
+     * \class lv::FileStatCache::Scope
+     * \brief Activates a cache for Path queries until the scope ends
+     *
+     * The previously active cache is restored on exit. A null cache leaves the active cache unchanged.
+     */
+    class LV_BASE_EXPORT Scope{
+
+        DISABLE_COPY(Scope);
+
+    public:
+        Scope(FileStatCache* cache);
+        ~Scope();
+
+    private:
+        FileStatCache* m_previous;
+        bool           m_activated;
+    };
+
+public:
+    FileStatCache();
+    ~FileStatCache();
+
+    bool exists(const std::string& path);
+    bool isDir(const std::string& path);
+    bool isFile(const std::string& path);
+    std::int64_t lastModifiedMs(const std::string& path);
+    std::uintmax_t fileSize(const std::string& path);
+
+    void invalidate(const std::string& path);
+    void invalidateTree(const std::string& path);
+    void clear();
+
+    bool enableWatcher();
+    bool isWatching() const;
+
+    size_t hits() const;
+    size_t misses() const;
+
+    static FileStatCache* active();
+
+private:
+    FileStatCachePrivate* m_d;
+};
+
+}// namespace
+
+#endif // LVFILESTATCACHE_H
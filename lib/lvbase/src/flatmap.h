@@ -0,0 +1,219 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 Dinu SV.
+** This file is part of Livekeys Application.
+**
+** GNU Lesser General Public License Usage
+** This file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+****************************************************************************/
+
+#ifndef LVFLATMAP_H
+#define LVFLATMAP_H
+
+#include <vector>
+#include <utility>
+#include <functional>
+#include <algorithm>
+#include <stdexcept>
+#include <initializer_list>
+
+namespace lv{
+
+/**
+ * \class lv::FlatMap
+ * \brief Associative container that keeps its key-value pairs sorted in a single vector
+ *
+ * Provides the subset of the std::map interface used throughout the libraries, with the same iteration
+ * order. Lookups are binary searches over contiguous memory, and the whole map takes a single allocation
+ * instead of one node per entry, which suits the small objects read from json files.
+ *
+ * Unlike std::map, inserting or erasing invalidates iterators and references to other entries.
+ *
+ * \ingroup lvbase
+ */
+template<typename Key, typename T, typename Compare = std::less<Key>, typename Allocator = std::allocator<std::pair<Key, T> > >
+class FlatMap{
+
+public:
+    typedef Key                                       key_type;
+    typedef T                                         mapped_type;
+    typedef std::pair<Key, T>                         value_type;
+    typedef Compare                                   key_compare;
+    typedef Allocator                                 allocator_type;
+    typedef std::vector<value_type, Allocator>        container_type;
+    typedef typename container_type::size_type        size_type;
+    typedef typename container_type::difference_type  difference_type;
+    typedef typename container_type::iterator         iterator;
+    typedef typename container_type::const_iterator   const_iterator;
+    typedef value_type&                               reference;
+    typedef const value_type&                         const_reference;
+
+public:
+    FlatMap(){}
+    FlatMap(std::initializer_list<value_type> init);
+
+    iterator begin(){ return m_data.begin(); }
+    iterator end(){ return m_data.end(); }
+    const_iterator begin() const{ return m_data.begin(); }
+    const_iterator end() const{ return m_data.end(); }
+    const_iterator cbegin() const{ return m_data.cbegin(); }
+    const_iterator cend() const{ return m_data.cend(); }
+
+    bool empty() const{ return m_data.empty(); }
+    size_type size() const{ return m_data.size(); }
+    size_type capacity() const{ return m_data.capacity(); }
+    void reserve(size_type size){ m_data.reserve(size); }
+    void shrink_to_fit(){ m_data.shrink_to_fit(); }
+    void clear(){ m_data.clear(); }
+
+    iterator lower_bound(const Key& key);
+    const_iterator lower_bound(const Key& key) const;
+    iterator find(const Key& key);
+    const_iterator find(const Key& key) const;
+    size_type count(const Key& key) const{ return find(key) == end() ? 0 : 1; }
+
+    T& at(const Key& key);
+    const T& at(const Key& key) const;
+    T& operator[](const Key& key);
+    T& operator[](Key&& key);
+
+    std::pair<iterator, bool> insert(const value_type& value);
+    std::pair<iterator, bool> insert(value_type&& value);
+    template<typename... Args> std::pair<iterator, bool> emplace(Args&&... args);
+
+    iterator erase(const_iterator position){ return m_data.erase(position); }
+    size_type erase(const Key& key);
+
+    bool operator == (const FlatMap& other) const{ return m_data == other.m_data; }
+    bool operator != (const FlatMap& other) const{ return m_data != other.m_data; }
+
+private:
+    bool isKeyAt(const_iterator it, const Key& key) const{
+        return it != m_data.end() && !m_compare(key, it->first);
+    }
+    iterator insertAt(iterator it, value_type&& value);
+
+    container_type m_data;
+    Compare        m_compare;
+};
+
+template<typename Key, typename T, typename Compare, typename Allocator>
+FlatMap<Key, T, Compare, Allocator>::FlatMap(std::initializer_list<value_type> init){
+    m_data.reserve(init.size());
+    for ( auto it = init.begin(); it != init.end(); ++it )
+        insert(*it);
+}
+
+template<typename Key, typename T, typename Compare, typename Allocator>
+typename FlatMap<Key, T, Compare, Allocator>::iterator FlatMap<Key, T, Compare, Allocator>::lower_bound(const Key &key){
+    return std::lower_bound(m_data.begin(), m_data.end(), key, [this](const value_type& v, const Key& k){
+        return m_compare(v.first, k);
+    });
+}
+
+template<typename Key, typename T, typename Compare, typename Allocator>
+typename FlatMap<Key, T, Compare, Allocator>::const_iterator FlatMap<Key, T, Compare, Allocator>::lower_bound(const Key &key) const{
+    return std::lower_bound(m_data.begin(), m_data.end(), key, [this](const value_type& v, const Key& k){
+        return m_compare(v.first, k);
+    });
+}
+
+template<typename Key, typename T, typename Compare, typename Allocator>
+typename FlatMap<Key, T, Compare, Allocator>::iterator FlatMap<Key, T, Compare, Allocator>::find(const Key &key){
+    iterator it = lower_bound(key);
+    return isKeyAt(it, key) ? it : m_data.end();
+}
+
+template<typename Key, typename T, typename Compare, typename Allocator>
+typename FlatMap<Key, T, Compare, Allocator>::const_iterator FlatMap<Key, T, Compare, Allocator>::find(const Key &key) const{
+    const_iterator it = lower_bound(key);
+    return isKeyAt(it, key) ? it : m_data.end();
+}
+
+template<typename Key, typename T, typename Compare, typename Allocator>
+T &FlatMap<Key, T, Compare, Allocator>::at(const Key &key){
+    iterator it = find(key);
+    if ( it == m_data.end() )
+        throw std::out_of_range("FlatMap::at: key not found");
+    return it->second;
+}
+
+template<typename Key, typename T, typename Compare, typename Allocator>
+const T &FlatMap<Key, T, Compare, Allocator>::at(const Key &key) const{
+    const_iterator it = find(key);
+    if ( it == m_data.end() )
+        throw std::out_of_range("FlatMap::at: key not found");
+    return it->second;
+}
+
+template<typename Key, typename T, typename Compare, typename Allocator>
+T &FlatMap<Key, T, Compare, Allocator>::operator[](const Key &key){
+    iterator it = lower_bound(key);
+    if ( isKeyAt(it, key) )
+        return it->second;
+    return insertAt(it, value_type(key, T()))->second;
+}
+
+template<typename Key, typename T, typename Compare, typename Allocator>
+T &FlatMap<Key, T, Compare, Allocator>::operator[](Key &&key){
+    iterator it = lower_bound(key);
+    if ( isKeyAt(it, key) )
+        return it->second;
+    return insertAt(it, value_type(std::move(key), T()))->second;
+}
+
+template<typename Key, typename T, typename Compare, typename Allocator>
+std::pair<typename FlatMap<Key, T, Compare, Allocator>::iterator, bool> FlatMap<Key, T, Compare, Allocator>::insert(const value_type &value){
+    return emplace(value);
+}
+
+template<typename Key, typename T, typename Compare, typename Allocator>
+std::pair<typename FlatMap<Key, T, Compare, Allocator>::iterator, bool> FlatMap<Key, T, Compare, Allocator>::insert(value_type &&value){
+    return emplace(std::move(value));
+}
+
+/**
+ * Inserts the pair constructed from \p args, unless the key already exists. Keys that come in sorted order,
+ * as they do when reading back serialized maps, are appended without a search.
+ */
+template<typename Key, typename T, typename Compare, typename Allocator>
+template<typename... Args>
+std::pair<typename FlatMap<Key, T, Compare, Allocator>::iterator, bool> FlatMap<Key, T, Compare, Allocator>::emplace(Args&&... args){
+    value_type value(std::forward<Args>(args)...);
+    if ( m_data.empty() || m_compare(m_data.back().first, value.first) )
+        return std::make_pair(insertAt(m_data.end(), std::move(value)), true);
+
+    iterator it = lower_bound(value.first);
+    if ( isKeyAt(it, value.first) )
+        return std::make_pair(it, false);
+    return std::make_pair(insertAt(it, std::move(value)), true);
+}
+
+/** Inserts at \p it, starting with room for a few entries instead of growing one at a time */
+template<typename Key, typename T, typename Compare, typename Allocator>
+typename FlatMap<Key, T, Compare, Allocator>::iterator FlatMap<Key, T, Compare, Allocator>::insertAt(iterator it, value_type &&value){
+    if ( m_data.capacity() == 0 ){
+        m_data.reserve(4);
+        it = m_data.begin();
+    }
+    return m_data.insert(it, std::move(value));
+}
+
+template<typename Key, typename T, typename Compare, typename Allocator>
+typename FlatMap<Key, T, Compare, Allocator>::size_type FlatMap<Key, T, Compare, Allocator>::erase(const Key &key){
+    iterator it = find(key);
+    if ( it == m_data.end() )
+        return 0;
+    m_data.erase(it);
+    return 1;
+}
+
+}// namespace
+
+#endif // LVFLATMAP_H
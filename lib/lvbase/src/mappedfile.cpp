@@ -0,0 +1,146 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 Dinu SV.
+** This file is part of Livekeys Application.
+**
+** GNU Lesser General Public License Usage
+** This file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+****************************************************************************/
+
+#include "mappedfile.h"
+#include "live/exception.h"
+#include "live/utf8.h"
+
+#ifdef PLATFORM_OS_WIN
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/**
+ * \class lv::MappedFile
+ * \brief Read-only memory mapping of a file
+ *
+ * The file contents are available through data() for as long as the object is alive.
+ * Empty files are not mapped, and data() returns nullptr for them.
+ *
+ * \ingroup lvbase
+ */
+
+namespace lv{
+
+/// \private
+class MappedFilePrivate{
+public:
+    MappedFilePrivate(const std::string& p) : path(p), data(nullptr), size(0){}
+
+    std::string path;
+    const char* data;
+    size_t      size;
+#ifdef PLATFORM_OS_WIN
+    HANDLE      file;
+    HANDLE      mapping;
+#endif
+};
+
+MappedFile::MappedFile(const std::string &path)
+    : m_d(new MappedFilePrivate(path))
+{
+}
+
+MappedFile::~MappedFile(){
+#ifdef PLATFORM_OS_WIN
+    if ( m_d->data )
+        UnmapViewOfFile(m_d->data);
+    if ( m_d->mapping )
+        CloseHandle(m_d->mapping);
+    if ( m_d->file != INVALID_HANDLE_VALUE )
+        CloseHandle(m_d->file);
+#else
+    if ( m_d->data )
+        munmap(const_cast<char*>(m_d->data), m_d->size);
+#endif
+    delete m_d;
+}
+
+/**
+ * \brief Maps the file at \p path in memory
+ *
+ * Throws an lv::Exception if the file cannot be opened or mapped.
+ */
+MappedFile::Ptr MappedFile::open(const std::string &path){
+    MappedFile::Ptr mf(new MappedFile(path));
+
+#ifdef PLATFORM_OS_WIN
+    mf->m_d->mapping = nullptr;
+    mf->m_d->file = CreateFileA(
+        path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr
+    );
+    if ( mf->m_d->file == INVALID_HANDLE_VALUE )
+        THROW_EXCEPTION(lv::Exception, Utf8("Failed to open file for mapping: %").format(path), lv::Exception::toCode("~File"));
+
+    LARGE_INTEGER size;
+    if ( !GetFileSizeEx(mf->m_d->file, &size) )
+        THROW_EXCEPTION(lv::Exception, Utf8("Failed to get file size: %").format(path), lv::Exception::toCode("~File"));
+    mf->m_d->size = static_cast<size_t>(size.QuadPart);
+    if ( mf->m_d->size == 0 )
+        return mf;
+
+    mf->m_d->mapping = CreateFileMappingA(mf->m_d->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if ( !mf->m_d->mapping )
+        THROW_EXCEPTION(lv::Exception, Utf8("Failed to map file: %").format(path), lv::Exception::toCode("~File"));
+
+    mf->m_d->data = static_cast<const char*>(MapViewOfFile(mf->m_d->mapping, FILE_MAP_READ, 0, 0, 0));
+    if ( !mf->m_d->data )
+        THROW_EXCEPTION(lv::Exception, Utf8("Failed to map file: %").format(path), lv::Exception::toCode("~File"));
+#else
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if ( fd < 0 )
+        THROW_EXCEPTION(lv::Exception, Utf8("Failed to open file for mapping: %").format(path), lv::Exception::toCode("~File"));
+
+    struct stat st;
+    if ( fstat(fd, &st) != 0 ){
+        close(fd);
+        THROW_EXCEPTION(lv::Exception, Utf8("Failed to get file size: %").format(path), lv::Exception::toCode("~File"));
+    }
+
+    mf->m_d->size = static_cast<size_t>(st.st_size);
+    if ( mf->m_d->size == 0 ){
+        close(fd);
+        return mf;
+    }
+
+    void* data = mmap(nullptr, mf->m_d->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if ( data == MAP_FAILED ){
+        mf->m_d->size = 0;
+        THROW_EXCEPTION(lv::Exception, Utf8("Failed to map file: %").format(path), lv::Exception::toCode("~File"));
+    }
+    mf->m_d->data = static_cast<const char*>(data);
+#endif
+
+    return mf;
+}
+
+const char *MappedFile::data() const{
+    return m_d->data;
+}
+
+size_t MappedFile::size() const{
+    return m_d->size;
+}
+
+const std::string &MappedFile::path() const{
+    return m_d->path;
+}
+
+}// namespace
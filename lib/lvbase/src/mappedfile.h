@@ -0,0 +1,52 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 Dinu SV.
+** This file is part of Livekeys Application.
+**
+** GNU Lesser General Public License Usage
+** This file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+****************************************************************************/
+
+#ifndef LVMAPPEDFILE_H
+#define LVMAPPEDFILE_H
+
+#include "live/lvbaseglobal.h"
+
+#include <string>
+#include <memory>
+
+namespace lv{
+
+class MappedFilePrivate;
+class LV_BASE_EXPORT MappedFile{
+
+    DISABLE_COPY(MappedFile);
+
+public:
+    typedef std::shared_ptr<MappedFile>       Ptr;
+    typedef std::shared_ptr<const MappedFile> ConstPtr;
+
+public:
+    ~MappedFile();
+
+    static Ptr open(const std::string& path);
+
+    const char* data() const;
+    size_t size() const;
+    const std::string& path() const;
+
+private:
+    MappedFile(const std::string& path);
+
+    MappedFilePrivate* m_d;
+};
+
+}// namespace
+
+#endif // LVMAPPEDFILE_H
@@ -95,6 +95,8 @@ namespace lv{
   *
   * <b>Objects</b> are simply collections (maps) of string-MLNode pairs, where each MLNode can be accessed by its key i.e. its name.
   * There are several examples above on how to construct a simple object. Object type supports a map-like indexing access, as well as iteration.
+  * Pairs are kept sorted by key in a single vector (\sa FlatMap), so iteration follows key order, and adding or removing keys
+  * invalidates references to the object's other values.
   *
   *
   * ##### MLNode to JSON
@@ -104,9 +106,11 @@ namespace lv{
   * void toJson(const MLNode& n, std::string& result);
   * void fromJson(const std::string& data, MLNode& n);
   * void fromJson(const char* data, MLNode& n);
+  * void fromJsonInsitu(char* data, MLNode& n);
   * ```
   * We are able to convert in both directions, from an MLNode to a JSON string, and vice versa (noting that the JSON string
-  * can be either a standard string or a char array.
+  * can be either a standard string or a char array. When the buffer can be discarded, fromJsonInsitu parses it in place
+  * and is faster.
   *
   * Converting the following object
   * ```
@@ -917,6 +921,15 @@ MLNode::MLNode(const MLNode::StringType &value)
 {
 }
 
+/**
+ * \brief Constructor of String MLNode, taking over the contents of \p value.
+*/
+MLNode::MLNode(MLNode::StringType &&value)
+    : m_type(Type::String)
+    , m_value(std::move(value))
+{
+}
+
 /**
  * \brief Constructor of a generic MLNode of a given type.
 */
@@ -1028,17 +1041,6 @@ MLNode::MLNode(const MLNode &other)
     }
 }
 
-/**
- * \brief Move constructor of the MLNode type.
- */
-MLNode::MLNode(MLNode &&other)
-    : m_type(other.m_type)
-    , m_value(other.m_value)
-{
-    other.m_type  = MLNode::Type::Null;
-    other.m_value = {};
-}
-
 /**
  * \brief Destructor of MLNode type.
  *
@@ -1415,6 +1417,21 @@ int MLNode::size() const{
     }
 }
 
+/**
+ * \brief Reserves storage for \p size elements in an Array or Object MLNode.
+ *
+ * If not one of those types, an exception is thrown.
+ */
+void MLNode::reserve(int size){
+    if ( m_type == Type::Array ){
+        m_value.asArray->reserve(static_cast<size_t>(size));
+    } else if ( m_type == Type::Object ){
+        m_value.asObject->reserve(static_cast<size_t>(size));
+    } else {
+        THROW_EXCEPTION(InvalidMLTypeException, "Node is not of array or object type. Cannot reserve.", 0);
+    }
+}
+
 /**
  * \brief Returns an indicator that the given key is found in our Object MLNode.
  *
@@ -18,6 +18,7 @@
 
 #include "live/exception.h"
 #include "live/bytebuffer.h"
+#include "live/flatmap.h"
 
 #include <map>
 #include <sstream>
@@ -101,8 +102,8 @@ public:
     typedef std::string                  StringType;
     /** Vector of MLNodes */
     typedef std::vector<MLNode>          ArrayType;
-    /** Map of string-MLNode pairs */
-    typedef std::map<StringType, MLNode> ObjectType;
+    /** Map of string-MLNode pairs, kept sorted by key in a single vector */
+    typedef FlatMap<StringType, MLNode>  ObjectType;
     /** Byte type i.e. char */
     typedef char                         ByteType;
     /** BytesType */
@@ -348,6 +349,7 @@ public:
         MLValue(const BytesType& bytes) : asBytes(new BytesType(bytes)){}
         MLValue(MLNode::ByteType* bytes, size_t size) : asBytes(new BytesType(bytes, size)){}
         MLValue(const StringType& str) : asString(new StringType(str)){}
+        MLValue(StringType&& str) : asString(new StringType(std::move(str))){}
         MLValue(BoolType boolVal) : asBool(boolVal){}
         MLValue(IntType intVal) : asInt(intVal){}
         MLValue(FloatType floatVal) : asFloat(floatVal){}
@@ -360,6 +362,7 @@ public:
     MLNode(std::nullptr_t);
     MLNode(const char* value);
     MLNode(const StringType& value);
+    MLNode(StringType&& value);
     MLNode(MLNode::Type value);
     MLNode(int value);
     MLNode(IntType value);
@@ -371,7 +374,7 @@ public:
     MLNode(const ArrayType& value);
     MLNode(const ObjectType& value);
     MLNode(const MLNode& other);
-    MLNode(MLNode&& other);
+    MLNode(MLNode&& other) noexcept;
     ~MLNode();
 
     const MLNode& operator[](const StringType& reference) const;
@@ -379,7 +382,8 @@ public:
     const MLNode& operator[](int index) const;
     MLNode& operator[](int index);
 
-    MLNode& operator=(MLNode other);
+    MLNode& operator=(const MLNode& other);
+    MLNode& operator=(MLNode&& other) noexcept;
 
     void append(const MLNode& value);
 
@@ -397,6 +401,7 @@ public:
     const ObjectType& asObject() const;
 
     int size() const;
+    void reserve(int size);
     bool hasKey(const StringType& key) const;
     void remove(const StringType& key);
     void remove(int key);
@@ -434,12 +439,34 @@ inline MLNode::MLValue::MLValue(MLNode::Type t){
     }
 }
 
+/**
+ * \brief Move constructor of the MLNode type.
+ */
+inline MLNode::MLNode(MLNode &&other) noexcept
+    : m_type(other.m_type)
+    , m_value(other.m_value)
+{
+    other.m_type  = MLNode::Type::Null;
+    other.m_value = {};
+}
+
+/**
+ * \brief Copy assignment operator of MLNode.
+ */
+inline MLNode &MLNode::operator=(const MLNode& other){
+    return *this = MLNode(other);
+}
+
 /**
  * \brief Assignment operator of MLNode implementing move semantics.
+ *
+ * \p other is moved out first, so assigning a node from one of its own children releases the
+ * previous value together with the emptied child.
  */
-inline MLNode &MLNode::operator=(MLNode other){
-    std::swap(m_type, other.m_type);
-    std::swap(m_value, other.m_value);
+inline MLNode &MLNode::operator=(MLNode&& other) noexcept{
+    MLNode moved(std::move(other));
+    std::swap(m_type, moved.m_type);
+    std::swap(m_value, moved.m_value);
 
     return *this;
 }
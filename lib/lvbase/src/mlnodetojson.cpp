@@ -15,10 +15,13 @@
 
 #include "mlnodetojson.h"
 #include "live/exception.h"
-#include <list>
+#include "live/path.h"
+#include <cstdio>
+#include <vector>
 
 #include "rapidjson/reader.h"
 #include "rapidjson/writer.h"
+#include "rapidjson/filewritestream.h"
 #include "rapidjson/error/en.h"
 
 using namespace rapidjson;
@@ -31,7 +34,7 @@ namespace{
 class MLNodeTrace{
 
 private:
-    std::list<MLNode*> path;
+    std::vector<MLNode*> path;
     std::string lastKey;
 
 public:
@@ -39,35 +42,35 @@ public:
         path.push_back(r);
     }
 
-    template<typename T> MLNode* insert(const T& value){
-        if ( path.back()->type() == MLNode::Object ){
-            (*path.back())[lastKey] = value;
-            return &(*path.back())[lastKey];
-        } else if ( path.back()->type() == MLNode::Array ){
-            MLNode* br = path.back();
-            br->append(value);
-
-            MLNode* ret = &((*br)[br->size() - 1]);
-            return ret;
+    MLNode* insert(MLNode&& value){
+        MLNode* parent = path.back();
+        if ( parent->type() == MLNode::Object ){
+            MLNode& slot = (*parent)[lastKey];
+            slot = std::move(value);
+            return &slot;
+        } else if ( parent->type() == MLNode::Array ){
+            MLNode::ArrayType& a = parent->asArray();
+            a.push_back(std::move(value));
+            return &a.back();
         } else {
-            (*path.back()) = value;
-            return &(*path.back());
+            *parent = std::move(value);
+            return parent;
         }
     }
 
-    bool Null() { insert(MLNode::Null); return true; }
-    bool Bool(bool b) { insert(b); return true; }
-    bool Int(int i) { insert(i); return true; }
-    bool Uint(unsigned u) { insert(static_cast<MLNode::IntType>(u)); return true; }
-    bool Int64(int64_t i) { insert(static_cast<MLNode::IntType>(i)); return true; }
-    bool Uint64(uint64_t u) { insert(static_cast<MLNode::IntType>(u)); return true; }
-    bool Double(double d) { insert(d); return true; }
-    bool RawNumber(const char* str, SizeType, bool) {
-        insert(str);
+    bool Null() { insert(MLNode()); return true; }
+    bool Bool(bool b) { insert(MLNode(b)); return true; }
+    bool Int(int i) { insert(MLNode(i)); return true; }
+    bool Uint(unsigned u) { insert(MLNode(static_cast<MLNode::IntType>(u))); return true; }
+    bool Int64(int64_t i) { insert(MLNode(static_cast<MLNode::IntType>(i))); return true; }
+    bool Uint64(uint64_t u) { insert(MLNode(static_cast<MLNode::IntType>(u))); return true; }
+    bool Double(double d) { insert(MLNode(d)); return true; }
+    bool RawNumber(const char* str, SizeType length, bool) {
+        insert(MLNode(MLNode::StringType(str, length)));
         return true;
     }
-    bool String(const char* str, SizeType, bool) {
-        insert(str);
+    bool String(const char* str, SizeType length, bool) {
+        insert(MLNode(MLNode::StringType(str, length)));
         return true;
     }
 
@@ -75,8 +78,8 @@ public:
         path.push_back(insert(MLNode(MLNode::Object)));
         return true;
     }
-    bool Key(const char* str, SizeType, bool) {
-        lastKey = str;
+    bool Key(const char* str, SizeType length, bool) {
+        lastKey.assign(str, length);
         return true;
     }
     bool EndObject(SizeType){
@@ -96,7 +99,30 @@ public:
     }
 };
 
-void recurseSerialize(const MLNode& n, rapidjson::Writer<rapidjson::StringBuffer>& writer){
+void throwParseError(const ParseResult& pr){
+    std::string errorMessage = GetParseError_En(pr.Code());
+    THROW_EXCEPTION(
+        lv::Exception,
+        Utf8("Failed to parse json with error: '%' at offset %.").format(errorMessage, pr.Offset()),
+        Exception::toCode("json")
+    );
+}
+
+/// Output stream appending to a std::string, so serialized json does not go through an extra buffer
+class StringOutputStream{
+public:
+    typedef char Ch;
+
+    StringOutputStream(std::string& output) : m_output(output){}
+
+    void Put(char c){ m_output.push_back(c); }
+    void Flush(){}
+
+private:
+    std::string& m_output;
+};
+
+template<typename W> void recurseSerialize(const MLNode& n, W& writer){
     switch( n.type() ){
     case MLNode::Null:
         writer.Null();
@@ -105,7 +131,7 @@ void recurseSerialize(const MLNode& n, rapidjson::Writer<rapidjson::StringBuffer
         writer.StartObject();
         const MLNode::ObjectType& o = n.asObject();
         for ( auto it = o.begin(); it != o.end(); ++it ){
-            writer.Key(it->first.c_str());
+            writer.Key(it->first.c_str(), static_cast<rapidjson::SizeType>(it->first.length()));
             recurseSerialize(it->second, writer);
         }
         writer.EndObject();
@@ -144,48 +170,101 @@ void recurseSerialize(const MLNode& n, rapidjson::Writer<rapidjson::StringBuffer
 
 } // namespace
 
+/**
+ * \brief Serializes \p n into \p result
+ *
+ * The json is written directly into \p result, replacing its contents but keeping its capacity, so the
+ * same string can be reused as a buffer across calls.
+ */
 void toJson(const MLNode &n, std::string &result){
-    StringBuffer s;
-    Writer<StringBuffer> writer(s);
+    result.clear();
+    StringOutputStream s(result);
+    Writer<StringOutputStream> writer(s);
 
     recurseSerialize(n, writer);
+}
+
+/**
+ * \brief Serializes \p n straight to the file at \p path
+ *
+ * The json is streamed through a fixed size buffer into a temporary file next to \p path, which then
+ * replaces \p path. Readers see either the previous file or the complete new one, and concurrent
+ * writers, including ones in other processes, each replace it with a complete file.
+ */
+void toJsonFile(const MLNode &n, const std::string &path){
+    std::string tempPath = Path::temporarySiblingPath(path);
+
+    // 'x' fails instead of reusing a temporary file left over by another writer
+    FILE* file = std::fopen(tempPath.c_str(), "wbx");
+    if ( !file ){
+        THROW_EXCEPTION(lv::Exception, Utf8("Failed to open file for writing: %").format(tempPath), lv::Exception::toCode("~File"));
+    }
+
+    char buffer[65536];
+    FileWriteStream s(file, buffer, sizeof(buffer));
+    Writer<FileWriteStream> writer(s);
 
-    result = s.GetString();
+    try{
+        recurseSerialize(n, writer);
+    } catch ( ... ){
+        std::fclose(file);
+        std::remove(tempPath.c_str());
+        throw;
+    }
+    s.Flush();
+
+    bool writeFailed = std::ferror(file) != 0;
+    if ( std::fclose(file) != 0 || writeFailed ){
+        std::remove(tempPath.c_str());
+        THROW_EXCEPTION(lv::Exception, Utf8("Failed to write file: %").format(tempPath), lv::Exception::toCode("~File"));
+    }
+
+    try{
+        Path::rename(tempPath, path);
+    } catch ( std::exception& e ){
+        std::remove(tempPath.c_str());
+        THROW_EXCEPTION(lv::Exception, Utf8("Failed to replace file %: %").format(path, e.what()), lv::Exception::toCode("~File"));
+    }
 }
 
 void fromJson(const std::string &data, MLNode &n){
+    fromJson(data.c_str(), n);
+}
+
+void fromJson(const char *data, MLNode &n){
     MLNodeTrace handler(&n);
 
     Reader reader;
-    StringStream ss(data.c_str());
+    StringStream ss(data);
 
     ParseResult pr = reader.Parse(ss, handler);
-    if ( !pr ){
-        std::string errorMessage = GetParseError_En(pr.Code());
-        THROW_EXCEPTION(
-            lv::Exception,
-            Utf8("Failed to parse json with error: '%' at offset %.").format(errorMessage, pr.Offset()),
-            Exception::toCode("json")
-        );
-    }
+    if ( !pr )
+        throwParseError(pr);
 }
 
-void fromJson(const char *data, MLNode &n){
+/**
+ * \brief Parses the null-terminated json in \p data into \p n, using \p data as scratch space
+ *
+ * Strings are unescaped in place, so the buffer is modified and its contents are not valid json
+ * afterwards. This saves copying each string into the parser's stack before it's added to \p n,
+ * which makes this the faster choice when the caller owns the buffer, like when reading a file.
+ */
+void fromJsonInsitu(char *data, MLNode &n){
     MLNodeTrace handler(&n);
 
     Reader reader;
-    StringStream ss(data);
+    InsituStringStream ss(data);
 
+    ParseResult pr = reader.Parse<kParseInsituFlag>(ss, handler);
+    if ( !pr )
+        throwParseError(pr);
+}
 
-    ParseResult pr = reader.Parse(ss, handler);
-    if ( !pr ){
-        std::string errorMessage = GetParseError_En(pr.Code());
-        THROW_EXCEPTION(
-            lv::Exception,
-            Utf8("Failed to parse json with error: '%' at offset %.").format(errorMessage, pr.Offset()),
-            Exception::toCode("json")
-        );
-    }
+/**
+ * \brief Parses \p data in place into \p n. The contents of \p data are modified.
+ */
+void fromJsonInsitu(std::string &data, MLNode &n){
+    fromJsonInsitu(&data[0], n);
 }
 
 }// namespace ml
@@ -25,8 +25,11 @@ namespace lv{
 namespace ml{
 
 void LV_BASE_EXPORT toJson(const MLNode& n, std::string& result);
+void LV_BASE_EXPORT toJsonFile(const MLNode& n, const std::string& path);
 void LV_BASE_EXPORT fromJson(const std::string& data, MLNode& n);
 void LV_BASE_EXPORT fromJson(const char* data, MLNode& n);
+void LV_BASE_EXPORT fromJsonInsitu(char* data, MLNode& n);
+void LV_BASE_EXPORT fromJsonInsitu(std::string& data, MLNode& n);
 
 //void LV_BASE_EXPORT toJson(const MLNode& n, QJsonValue& result);
 //void LV_BASE_EXPORT toJson(const MLNode& n, QByteArray& result);
@@ -102,7 +102,7 @@ Module::Ptr Module::createFromPath(const std::string &path){
             instream.read(&buffer[0], static_cast<std::streamsize>(size));
 
             MLNode m;
-            ml::fromJson(buffer, m);
+            ml::fromJsonInsitu(buffer, m);
 
             return createFromNode(moduleDirPath, modulePath, m);
         } catch ( lv::Exception& e ){
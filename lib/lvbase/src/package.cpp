@@ -114,7 +114,7 @@ Package::Ptr Package::createFromPath(const std::string &path){
         instream.read(&buffer[0], size);
 
         MLNode m;
-        ml::fromJson(buffer, m);
+        ml::fromJsonInsitu(buffer, m);
         return createFromNode(packageDirPath, packagePath, m);
 
     } catch ( lv::Exception& e ){
@@ -22,6 +22,7 @@
 #include "live/libraryloadpath.h"
 #include "live/visuallog.h"
 #include "live/utf8.h"
+#include "live/tracer.h"
 
 #include <list>
 #include <iostream>
@@ -31,6 +32,8 @@ namespace lv{
 
 namespace{
 
+    VisualLog::Handle packageGraphLog("lvbase-packagegraph");
+
     std::vector<std::string> splitString(const std::string &text, char sep) {
         std::vector<std::string> tokens;
         size_t start = 0, end = 0;
@@ -41,6 +44,47 @@ namespace{
         tokens.push_back(text.substr(start));
         return tokens;
     }
+
+    template<typename T, typename DependenciesFunction>
+    PackageGraph::CyclesResult<T> findCycle(const T& start, DependenciesFunction dependencies){
+        std::vector<T> stack;
+        std::unordered_map<T, T> parents;
+
+        stack.push_back(start);
+        while ( !stack.empty() ){
+            T current = stack.back();
+            stack.pop_back();
+
+            for ( const T& next : dependencies(current) ){
+                if ( next == start ){
+                    std::list<T> path;
+                    path.push_front(start);
+                    for ( T it = current; it != start; it = parents[it] )
+                        path.push_front(it);
+                    path.push_front(start);
+                    return PackageGraph::CyclesResult<T>(PackageGraph::CyclesResult<T>::Found, path);
+                }
+                if ( parents.find(next) == parents.end() ){
+                    parents.insert(std::make_pair(next, current));
+                    stack.push_back(next);
+                }
+            }
+        }
+        return PackageGraph::CyclesResult<T>(PackageGraph::CyclesResult<T>::NotFound);
+    }
+
+    const std::list<Package::Ptr>& packageDependencies(const Package::Ptr& p){
+        return p->context()->dependencies;
+    }
+    const std::list<Package::Ptr>& packageDependents(const Package::Ptr& p){
+        return p->context()->dependents;
+    }
+    const std::list<Module::Ptr>& moduleDependencies(const Module::Ptr& m){
+        return m->context()->localDependencies;
+    }
+    const std::list<Module::Ptr>& moduleDependents(const Module::Ptr& m){
+        return m->context()->localDependents;
+    }
 }
 
 /// \private
@@ -53,6 +97,32 @@ public:
 
     std::list<Package::Ptr> runningPackages;
     PaletteContainer* paletteContainer;
+
+    PackageGraph::TopologicalOrder<Package::Ptr> packageOrder;
+    PackageGraph::TopologicalOrder<Module::Ptr>  moduleOrder;
+
+    /** Parsed package for each probed path, null if the path has no package */
+    std::unordered_map<std::string, Package::Ptr> packagesByPath;
+    /** Result of each findPackage lookup for the current import paths, null if not found */
+    std::unordered_map<std::string, Package::Ptr> packageResolutions;
+
+    Package::Ptr packageAt(const std::string& path){
+        auto it = packagesByPath.find(path);
+        if ( it != packagesByPath.end() )
+            return it->second;
+
+        Package::Ptr p = Package::existsIn(path) ? Package::createFromPath(path) : nullptr;
+        packagesByPath[path] = p;
+        return p;
+    }
+
+    void removeFromOrder(const Package::Ptr& p){
+        packageOrder.remove(p);
+        if ( p->context() ){
+            for ( auto it = p->context()->modules.begin(); it != p->context()->modules.end(); ++it )
+                moduleOrder.remove(it->second);
+        }
+    }
 };
 
 /**
@@ -61,6 +131,10 @@ public:
  *
  * It also stores all the libraries, stores in the LibraryNode structure.
  * We also check for dependency cycles on multiple levels: modules, packages, Elements files
+ *
+ * Packages and modules are kept in a topological order that is updated incrementally with each
+ * dependency, so cycle checks only visit the affected part of the graph. The order is available
+ * through topologicalPackages() and topologicalModules().
  * \ingroup lvbase
  */
 
@@ -82,6 +156,7 @@ PackageGraph::~PackageGraph(){
 
 /** Loads package in the graph and makes necessary checks */
 void PackageGraph::loadPackage(const Package::Ptr &p, bool addLibraries){
+    LV_TRACE_SCOPE_DETAIL("package", "PackageGraph::loadPackage", p->name());
     auto it = m_d->packages.find(p->nameScope());
     if ( it == m_d->packages.end() ){
         p->assignContext(this);
@@ -94,8 +169,9 @@ void PackageGraph::loadPackage(const Package::Ptr &p, bool addLibraries){
         }
 
         m_d->packages[p->nameScope()] = p;
+        m_d->packageOrder.insert(p);
 
-        vlog("lvbase-packagegraph").v() << "Loaded package \'" + p->nameScope() << "\' [" + p->version().toString() + "]";
+        vlog_if(packageGraphLog, Verbose) << "Loaded package \'" + p->nameScope() << "\' [" + p->version().toString() + "]";
 
     } else {
         Package::Ptr existingPackage = it->second;
@@ -110,12 +186,14 @@ void PackageGraph::loadPackage(const Package::Ptr &p, bool addLibraries){
         }
 
         if ( newVersion > oldVersion ){
-            vlog("lvbase-packagegraph").v() <<
+            vlog_if(packageGraphLog, Verbose) <<
                 "Replaced package \'" << p->nameScope() << "\' from [" << existingPackage->version().toString() << "] to [" <<
                 p->version().toString() << "]";
 
             p->assignContext(this);
             m_d->packages[p->nameScope()] = p;
+            m_d->removeFromOrder(existingPackage);
+            m_d->packageOrder.insert(p);
 
             if ( addLibraries ){
                 for ( auto it = p->libraries().begin(); it != p->libraries().end(); ++it ){
@@ -178,10 +256,9 @@ void PackageGraph::addDependency(const Package::Ptr &package, const Package::Ptr
         }
     }
     if ( !hasDependency(package, dependsOn ) ){
-        package->context()->dependencies.push_back(dependsOn);
-        dependsOn->context()->dependents.push_back(package);
-
-        PackageGraph::CyclesResult<Package::Ptr> cr = checkCycles(package);
+        PackageGraph::CyclesResult<Package::Ptr> cr = m_d->packageOrder.addDependency(
+            package, dependsOn, &packageDependencies, &packageDependents
+        );
         if ( cr.found() ){
             std::stringstream ss;
 
@@ -195,21 +272,11 @@ void PackageGraph::addDependency(const Package::Ptr &package, const Package::Ptr
                 ss << n->nameScope() << "[" << n->version().toString() << "]";
             }
 
-            for ( auto it = package->context()->dependencies.begin(); it != package->context()->dependencies.end(); ++it ){
-                if ( *it == dependsOn ){
-                    package->context()->dependencies.erase(it);
-                    break;
-                }
-            }
-            for ( auto it = dependsOn->context()->dependents.begin(); it != dependsOn->context()->dependents.end(); ++it ){
-                if ( *it == package ){
-                    dependsOn->context()->dependents.erase(it);
-                    break;
-                }
-            }
-
             THROW_EXCEPTION(lv::Exception, "Package dependency cycle found: "  + ss.str(), lv::Exception::toCode("Cycle"));
         }
+
+        package->context()->dependencies.push_back(dependsOn);
+        dependsOn->context()->dependents.push_back(package);
     }
 
 }
@@ -220,15 +287,7 @@ PackageGraph::CyclesResult<Package::Ptr> PackageGraph::checkCycles(const Package
     if ( it == m_d->packages.end() && p->nameScope() != ".")
         THROW_EXCEPTION(lv::Exception, "Failed to find package for cycles: " + p->nameScope(), 2);
 
-    std::list<Package::Ptr> path;
-    path.push_back(p);
-
-    for ( auto it = p->context()->dependencies.begin(); it != p->context()->dependencies.end(); ++it ){
-        PackageGraph::CyclesResult<Package::Ptr> cr = checkCycles(p, *it, path);
-        if ( cr.found() )
-            return cr;
-    }
-    return PackageGraph::CyclesResult<Package::Ptr>(PackageGraph::CyclesResult<Package::Ptr>::NotFound);
+    return findCycle(p, &packageDependencies);
 }
 
 /** Check if there are cycles between modules, starting from the given module */
@@ -236,45 +295,7 @@ PackageGraph::CyclesResult<Module::Ptr> PackageGraph::checkCycles(const Module::
     if ( p->context() == nullptr || p->context()->packageGraph != this )
         THROW_EXCEPTION(lv::Exception, "Failed to find loaded module for cycles: " + p->name(), 2);
 
-    std::list<Module::Ptr> path;
-    path.push_back(p);
-
-    for ( auto it = p->context()->localDependencies.begin(); it != p->context()->localDependencies.end(); ++it ){
-        PackageGraph::CyclesResult<Module::Ptr> cr = checkCycles(p, *it, path);
-        if ( cr.found() )
-            return cr;
-    }
-    return PackageGraph::CyclesResult<Module::Ptr>(PackageGraph::CyclesResult<Module::Ptr>::NotFound);
-}
-
-PackageGraph::CyclesResult<Package::Ptr> PackageGraph::checkCycles(
-        const Package::Ptr &p, Package::Ptr current, std::list<Package::Ptr> path)
-{
-    path.push_back(current);
-    if ( current.get() == p.get() )
-        return PackageGraph::CyclesResult<Package::Ptr>(PackageGraph::CyclesResult<Package::Ptr>::Found, path);
-
-    for ( auto it = current->context()->dependencies.begin(); it != current->context()->dependencies.end(); ++it ){
-        PackageGraph::CyclesResult<Package::Ptr> cr = checkCycles(p, *it, path);
-        if ( cr.found() )
-            return cr;
-    }
-    return PackageGraph::CyclesResult<Package::Ptr>(PackageGraph::CyclesResult<Package::Ptr>::NotFound);
-}
-
-PackageGraph::CyclesResult<Module::Ptr> PackageGraph::checkCycles(
-        const Module::Ptr &p, Module::Ptr current, std::list<Module::Ptr> path)
-{
-    path.push_back(current);
-    if ( current.get() == p.get() )
-        return PackageGraph::CyclesResult<Module::Ptr>(PackageGraph::CyclesResult<Module::Ptr>::Found, path);
-
-    for ( auto it = current->context()->localDependencies.begin(); it != current->context()->localDependencies.end(); ++it ){
-        PackageGraph::CyclesResult<Module::Ptr> cr = checkCycles(p, *it, path);
-        if ( cr.found() )
-            return cr;
-    }
-    return PackageGraph::CyclesResult<Module::Ptr>(PackageGraph::CyclesResult<Module::Ptr>::NotFound);
+    return findCycle(p, &moduleDependencies);
 }
 
 /**
@@ -302,7 +323,7 @@ void PackageGraph::addLibrary(const Package::Library &lib){
         libnode->loaded  = false;
         m_d->libraries[lib.name.data()] = libnode;
 
-        vlog("lvbase-packagegraph").d() << "Added library \'" << lib.name.data() << "\' [" + lib.version.toString() << "]";
+        vlog_if(packageGraphLog, Debug) << "Added library \'" << lib.name.data() << "\' [" + lib.version.toString() << "]";
 
     } else {
         PackageGraph::LibraryNode* libnode = it->second;
@@ -342,7 +363,7 @@ void PackageGraph::addLibrary(const Package::Library &lib){
                     "flags than older library \'" + oldVersion.toString() + "\', ", 10);
             }
 
-            vlog("lvbase-packagegraph").d() <<
+            vlog_if(packageGraphLog, Debug) <<
                 "Replaced library \'" << lib.name.data() << "\' from [" << libnode->library.version.toString() << "] to [" <<
                 lib.version.toString() << "]";
 
@@ -375,6 +396,8 @@ void PackageGraph::loadLibraries(){
  */
 void PackageGraph::clearPackages(){
     m_d->packages.clear();
+    m_d->packageOrder.clear();
+    m_d->moduleOrder.clear();
 }
 
 /**
@@ -421,53 +444,57 @@ std::string PackageGraph::toString() const{
 
 /**
  * \brief Finds the package according to the given reference
+ *
+ * Results, including missing packages, are cached until the import paths change or
+ * clearPackageCache() is called.
  */
 Package::Ptr PackageGraph::findPackage(Package::Reference ref) const{
-    std::vector<std::string> paths = packageImportPaths();
-    for ( auto it = paths.begin(); it != paths.end(); ++it ){
-        std::string path = *it + "/" + ref.name.replaceAll(".", "/").data();
-        if ( Package::existsIn(path) ){
-            Package::Ptr p = Package::createFromPath(path);
-            if ( p->version().majorNumber() == ref.version.majorNumber() && p->version() > ref.version ){
-                return p;
-            }
-        }
+    std::string resolutionKey = ref.name.data() + "@" + ref.version.toString();
+    auto resolutionIt = m_d->packageResolutions.find(resolutionKey);
+    if ( resolutionIt != m_d->packageResolutions.end() )
+        return resolutionIt->second;
 
-        std::string pathMajor = path + "." + std::to_string(ref.version.majorNumber());
-        if ( Package::existsIn(pathMajor) ){
-            Package::Ptr p = Package::createFromPath(path);
-            if ( p->version().majorNumber() == ref.version.majorNumber() && p->version() > ref.version ){
-                return p;
-            }
-        }
+    Package::Ptr foundPackage(nullptr);
 
+    const std::vector<std::string>& paths = packageImportPaths();
+    for ( auto it = paths.begin(); it != paths.end() && !foundPackage; ++it ){
+        std::string path = *it + "/" + ref.name.replaceAll(".", "/").data();
+        std::string pathMajor = path + "." + std::to_string(ref.version.majorNumber());
         std::string pathMajorMinor = pathMajor + "." + std::to_string(ref.version.minorNumber());
-        if ( Package::existsIn(pathMajorMinor) ){
-            Package::Ptr p = Package::createFromPath(path);
-            if ( p->version().majorNumber() == ref.version.majorNumber() && p->version() > ref.version ){
-                return p;
+
+        for ( const std::string& candidatePath : {path, pathMajor, pathMajorMinor} ){
+            Package::Ptr p = m_d->packageAt(candidatePath);
+            if ( p && p->version().majorNumber() == ref.version.majorNumber() && p->version() > ref.version ){
+                foundPackage = p;
+                break;
             }
         }
     }
 
-    return Package::Ptr(nullptr);
+    m_d->packageResolutions[resolutionKey] = foundPackage;
+    return foundPackage;
 }
 
 /**
  * \brief Finds the package with the given name and the highest version in the package import paths
+ *
+ * Results, including missing packages, are cached until the import paths change or
+ * clearPackageCache() is called.
  */
 Package::Ptr PackageGraph::findPackage(const std::string &packageName) const{
+    auto resolutionIt = m_d->packageResolutions.find(packageName);
+    if ( resolutionIt != m_d->packageResolutions.end() )
+        return resolutionIt->second;
+
     Package::Ptr foundPackage(nullptr);
 
     std::string packageNameScope = packageName;
     Utf8::replaceAll(packageNameScope, ".", "/");
 
-    std::vector<std::string> paths = packageImportPaths();
+    const std::vector<std::string>& paths = packageImportPaths();
     for ( auto it = paths.begin(); it != paths.end(); ++it ){
-        std::string path = *it + "/" + packageNameScope;
-        if ( Package::existsIn(path) ){
-            Package::Ptr p = Package::createFromPath(path);
-
+        Package::Ptr p = m_d->packageAt(*it + "/" + packageNameScope);
+        if ( p ){
             if ( foundPackage == nullptr ){
                 foundPackage = p;
             } else if ( p->version() > foundPackage->version() ){
@@ -475,10 +502,21 @@ Package::Ptr PackageGraph::findPackage(const std::string &packageName) const{
             }
         }
     }
-    
+
+    m_d->packageResolutions[packageName] = foundPackage;
     return foundPackage;
 }
 
+/**
+ * \brief Drops cached package manifests and findPackage results
+ *
+ * Needs to be called when packages are added, removed or updated within the import paths.
+ */
+void PackageGraph::clearPackageCache(){
+    m_d->packagesByPath.clear();
+    m_d->packageResolutions.clear();
+}
+
 Package::Ptr PackageGraph::findLoadedPackage(const std::string &packageName){
     PackageGraphPrivate* d = m_d;
     auto it = d->packages.find(packageName); // find in loaded packages
@@ -527,6 +565,8 @@ const std::vector<std::string> &PackageGraph::packageImportPaths() const{
 
 /** Package import paths setter */
 void PackageGraph::setPackageImportPaths(const std::vector<std::string> &paths){
+    if ( m_d->packageImportPaths != paths )
+        m_d->packageResolutions.clear();
     m_d->packageImportPaths = paths;
 }
 
@@ -582,6 +622,8 @@ Module::Ptr PackageGraph::createRunningModule(const std::string &modulePath){
     package->context()->modules["."] = module;
 
     addRunningPackage(package);
+    m_d->packageOrder.insert(package);
+    m_d->moduleOrder.insert(module);
 
     return module;
 }
@@ -608,6 +650,48 @@ void PackageGraph::loadRunningPackageAndModule(const Package::Ptr &package, cons
     } else {
         addRunningPackage(package);
     }
+
+    m_d->packageOrder.insert(package);
+    m_d->moduleOrder.insert(module);
+}
+
+/**
+ * \brief Returns the loaded packages, with each package placed after the packages it depends on
+ */
+const std::vector<Package::Ptr> &PackageGraph::topologicalPackages() const{
+    return m_d->packageOrder.nodes();
+}
+
+/**
+ * \brief Returns the loaded modules, with each module placed after the modules it depends on
+ *
+ * Modules are grouped by package following topologicalPackages(), so modules from a package
+ * always come after the modules of the packages it depends on.
+ */
+std::vector<Module::Ptr> PackageGraph::topologicalModules() const{
+    std::unordered_map<Package*, std::vector<Module::Ptr> > packageModules;
+    std::vector<Package*> unorderedPackages;
+
+    for ( const Module::Ptr& m : m_d->moduleOrder.nodes() ){
+        Package::Ptr p = m->context() ? m->context()->packageUnwrapped() : nullptr;
+        auto& modules = packageModules[p.get()];
+        if ( modules.empty() && !m_d->packageOrder.contains(p) )
+            unorderedPackages.push_back(p.get());
+        modules.push_back(m);
+    }
+
+    std::vector<Module::Ptr> result;
+    result.reserve(m_d->moduleOrder.nodes().size());
+    for ( Package* p : unorderedPackages ){
+        auto& modules = packageModules[p];
+        result.insert(result.end(), modules.begin(), modules.end());
+    }
+    for ( const Package::Ptr& p : m_d->packageOrder.nodes() ){
+        auto it = packageModules.find(p.get());
+        if ( it != packageModules.end() )
+            result.insert(result.end(), it->second.begin(), it->second.end());
+    }
+    return result;
 }
 
 /**
@@ -621,6 +705,7 @@ Module::Ptr PackageGraph::loadModule(const std::string &importSegment, Module::P
  * \brief Loads module given split-up import segments
  */
 Module::Ptr PackageGraph::loadModule(const std::vector<std::string> &importSegments, Module::Ptr requestingModule){
+    LV_TRACE_SCOPE_DETAIL("package", "PackageGraph::loadModule", importSegments.empty() ? std::string() : importSegments.front());
     PackageGraphPrivate* d = m_d;
 
     if ( importSegments.empty() )
@@ -695,8 +780,9 @@ Module::Ptr PackageGraph::loadModule(const std::vector<std::string> &importSegme
         for ( auto it = module->dependencies().begin(); it != module->dependencies().end(); ++it )
             addDependency(module, *it);
 
-        vlog("lvbase-packagegraph").v() << "Loaded module: " << importId;
+        vlog_if(packageGraphLog, Verbose) << "Loaded module: " << importId;
         foundPackage->context()->modules[importId] = module;
+        m_d->moduleOrder.insert(module);
 
         return module;
     }
@@ -744,10 +830,9 @@ void PackageGraph::addDependency(const Module::Ptr& module, const Module::Ptr& d
     if ( pkgModule.get() == pkgDepends.get() ){ // within the same package
 
         if ( !hasDependency(module, dependsOn) ){
-            module->context()->localDependencies.push_back(dependsOn);
-            dependsOn->context()->localDependents.push_back(module);
-
-            PackageGraph::CyclesResult<Module::Ptr> cr = checkCycles(module);
+            PackageGraph::CyclesResult<Module::Ptr> cr = m_d->moduleOrder.addDependency(
+                module, dependsOn, &moduleDependencies, &moduleDependents
+            );
             if ( cr.found() ){
                 std::stringstream ss;
 
@@ -758,21 +843,11 @@ void PackageGraph::addDependency(const Module::Ptr& module, const Module::Ptr& d
                     ss << n->name();
                 }
 
-                for ( auto it = module->context()->localDependencies.begin(); it != module->context()->localDependencies.end(); ++it ){
-                    if ( *it == dependsOn ){
-                        module->context()->localDependencies.erase(it);
-                        break;
-                    }
-                }
-                for ( auto it = dependsOn->context()->localDependents.begin(); it != dependsOn->context()->localDependents.end(); ++it ){
-                    if ( *it == module ){
-                        dependsOn->context()->localDependents.erase(it);
-                        break;
-                    }
-                }
-
                 THROW_EXCEPTION(lv::Exception, "Module dependency cycle found: "  + ss.str(), Exception::toCode("Cycle"));
             }
+
+            module->context()->localDependencies.push_back(dependsOn);
+            dependsOn->context()->localDependents.push_back(module);
         }
 
     } else { // add package dependency instead
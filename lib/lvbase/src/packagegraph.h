@@ -23,6 +23,9 @@
 #include <vector>
 #include <list>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
 
 namespace lv{
 
@@ -72,6 +75,59 @@ public:
         std::list<T> m_path;
     };
 
+    /**
+     * \private
+     * \brief Incrementally maintained topological order of a dependency graph
+     *
+     * Dependencies are always placed before their dependents. New edges are checked with the
+     * Pearce-Kelly algorithm, so only the region of the order affected by the new edge is visited,
+     * and the cycle path is reconstructed only when a cycle is actually found.
+     */
+    template<typename T>
+    class TopologicalOrder{
+
+    public:
+        /** Appends the node at the end of the order if it's not tracked yet */
+        void insert(const T& node){
+            if ( m_index.find(node) == m_index.end() ){
+                m_index[node] = m_nodes.size();
+                m_nodes.push_back(node);
+            }
+        }
+
+        /** Removes the node from the order */
+        void remove(const T& node){
+            auto it = m_index.find(node);
+            if ( it == m_index.end() )
+                return;
+            size_t index = it->second;
+            m_index.erase(it);
+            m_nodes.erase(m_nodes.begin() + static_cast<std::ptrdiff_t>(index));
+            for ( size_t i = index; i < m_nodes.size(); ++i )
+                m_index[m_nodes[i]] = i;
+        }
+
+        /** Removes all nodes */
+        void clear(){
+            m_nodes.clear();
+            m_index.clear();
+        }
+
+        bool contains(const T& node) const{ return m_index.find(node) != m_index.end(); }
+
+        /** Tracked nodes, with each dependency placed before its dependents */
+        const std::vector<T>& nodes() const{ return m_nodes; }
+
+        template<typename DependenciesFunction, typename DependentsFunction>
+        CyclesResult<T> addDependency(
+            const T& node, const T& dependsOn, DependenciesFunction dependencies, DependentsFunction dependents
+        );
+
+    private:
+        std::vector<T> m_nodes;
+        std::unordered_map<T, size_t> m_index;
+    };
+
 public:
     PackageGraph();
     virtual ~PackageGraph();
@@ -93,6 +149,7 @@ public:
 
     Package::Ptr findPackage(Package::Reference ref) const;
     Package::Ptr findPackage(const std::string& packageName) const;
+    void clearPackageCache();
 
     Package::Ptr findLoadedPackage(const std::string& name);
     Package::ConstPtr findLoadedPackage(const std::string& name) const;
@@ -111,6 +168,9 @@ public:
     Module::Ptr createRunningModule(const std::string& path);
     void loadRunningPackageAndModule(const Package::Ptr& package, const Module::Ptr& plugin);
 
+    const std::vector<Package::Ptr>& topologicalPackages() const;
+    std::vector<Module::Ptr> topologicalModules() const;
+
     Module::Ptr loadModule(const std::string& importSegment, Module::Ptr requestingPlugin = nullptr);
     Module::Ptr loadModule(const std::vector<std::string>& importSegment, Module::Ptr requestingPlugin = nullptr);
     void addDependency(const Module::Ptr& plugin, const std::string& pluginDependency);
@@ -124,15 +184,115 @@ private:
     bool hasDependency(const Package::Ptr& package, const Package::Ptr& dependency);
     bool hasDependency(const Module::Ptr& plugin, const Module::Ptr& dependency);
 
-    PackageGraph::CyclesResult<Package::Ptr> checkCycles(const Package::Ptr &p, Package::Ptr current, std::list<Package::Ptr> path);
-    PackageGraph::CyclesResult<Module::Ptr> checkCycles(const Module::Ptr &p, Module::Ptr current, std::list<Module::Ptr> path);
-
     std::string toString(Package::Ptr package, const std::string& indent) const;
     std::string toStringRecurse(Package::Ptr package, const std::string& indent) const;
 
     PackageGraphPrivate* m_d;
 };
 
+/**
+ * \brief Updates the order for a new edge where \p node depends on \p dependsOn.
+ *
+ * Needs to be called before the edge is added to the graph. \p dependencies and \p dependents return
+ * the current adjacency lists of a node. If the edge would create a cycle, the order is left unchanged
+ * and the result contains the cycle path, starting and ending with \p node.
+ */
+template<typename T>
+template<typename DependenciesFunction, typename DependentsFunction>
+PackageGraph::CyclesResult<T> PackageGraph::TopologicalOrder<T>::addDependency(
+    const T &node, const T &dependsOn, DependenciesFunction dependencies, DependentsFunction dependents)
+{
+    insert(dependsOn);
+    insert(node);
+
+    if ( node == dependsOn )
+        return CyclesResult<T>(CyclesResult<T>::Found, std::list<T>{node, node});
+
+    size_t lowerBound = m_index[node];
+    size_t upperBound = m_index[dependsOn];
+    if ( upperBound < lowerBound )
+        return CyclesResult<T>(CyclesResult<T>::NotFound);
+
+    // collect dependents of node placed before dependsOn, if dependsOn is among them we have a cycle
+
+    std::vector<T> stack;
+    std::vector<T> forward;
+    std::unordered_map<T, T> forwardParents;
+
+    stack.push_back(node);
+    forwardParents.insert(std::make_pair(node, node));
+    while ( !stack.empty() ){
+        T current = stack.back();
+        stack.pop_back();
+        forward.push_back(current);
+
+        for ( const T& next : dependents(current) ){
+            if ( next == dependsOn ){
+                std::list<T> path;
+                path.push_back(node);
+                path.push_back(dependsOn);
+                for ( T it = current; it != node; it = forwardParents[it] )
+                    path.push_back(it);
+                path.push_back(node);
+                return CyclesResult<T>(CyclesResult<T>::Found, path);
+            }
+
+            auto nextIndex = m_index.find(next);
+            if ( nextIndex != m_index.end() && nextIndex->second < upperBound && forwardParents.find(next) == forwardParents.end() ){
+                forwardParents.insert(std::make_pair(next, current));
+                stack.push_back(next);
+            }
+        }
+    }
+
+    // collect dependencies of dependsOn placed after node
+
+    std::vector<T> backward;
+    std::unordered_set<T> backwardVisited;
+
+    stack.push_back(dependsOn);
+    backwardVisited.insert(dependsOn);
+    while ( !stack.empty() ){
+        T current = stack.back();
+        stack.pop_back();
+        backward.push_back(current);
+
+        for ( const T& next : dependencies(current) ){
+            auto nextIndex = m_index.find(next);
+            if ( nextIndex != m_index.end() && nextIndex->second > lowerBound && backwardVisited.find(next) == backwardVisited.end() ){
+                backwardVisited.insert(next);
+                stack.push_back(next);
+            }
+        }
+    }
+
+    // reassign the slots of both regions, moving dependencies in front of dependents
+
+    auto byIndex = [this](const T& a, const T& b){ return m_index[a] < m_index[b]; };
+    std::sort(forward.begin(), forward.end(), byIndex);
+    std::sort(backward.begin(), backward.end(), byIndex);
+
+    std::vector<size_t> slots;
+    slots.reserve(forward.size() + backward.size());
+    for ( const T& n : backward )
+        slots.push_back(m_index[n]);
+    for ( const T& n : forward )
+        slots.push_back(m_index[n]);
+    std::sort(slots.begin(), slots.end());
+
+    size_t slot = 0;
+    for ( const T& n : backward ){
+        m_nodes[slots[slot]] = n;
+        m_index[n] = slots[slot++];
+    }
+    for ( const T& n : forward ){
+        m_nodes[slots[slot]] = n;
+        m_index[n] = slots[slot++];
+    }
+
+    return CyclesResult<T>(CyclesResult<T>::NotFound);
+}
+
 }// namespace
 
 #endif // LVPACKAGEGRAPH_H
@@ -1,5 +1,6 @@
 #include "path.h"
 #include "live/visuallog.h"
+#include "filestatcache.h"
 
 #if defined(__GNUC__) && !defined(__llvm__) && !defined(__INTEL_COMPILER)
 #  if(__GNUC__ > 7)
@@ -14,6 +15,25 @@
    namespace fs = std::filesystem;
 #endif
 
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#ifdef PLATFORM_OS_LINUX
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <linux/fs.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#elif defined(PLATFORM_OS_WIN)
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
 namespace lv{
 
 // Helpers
@@ -21,6 +41,69 @@ namespace lv{
 
 namespace{
 
+class ResolveCache{
+public:
+    std::mutex mutex;
+    std::unordered_map<std::string, std::string> paths;
+
+    static ResolveCache& instance(){
+        static ResolveCache cache;
+        return cache;
+    }
+};
+
+/**
+ * Copies the file contents as a reflink (FICLONE) or in kernel (copy_file_range) where the
+ * file system supports it. Returns false if neither is available, in which case the caller
+ * falls back to a regular copy.
+ */
+bool copyFileInKernel(const std::string& from, const std::string& to){
+#ifdef PLATFORM_OS_LINUX
+    int in = ::open(from.c_str(), O_RDONLY | O_CLOEXEC);
+    if ( in < 0 )
+        return false;
+
+    struct stat st;
+    if ( fstat(in, &st) != 0 ){
+        close(in);
+        return false;
+    }
+
+    int out = ::open(to.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, st.st_mode & 0777);
+    if ( out < 0 ){
+        close(in);
+        return false;
+    }
+
+    bool copied = false;
+#ifdef FICLONE
+    copied = ioctl(out, FICLONE, in) == 0;
+#endif
+    if ( !copied ){
+        off_t remaining = st.st_size;
+        copied = true;
+        while ( remaining > 0 ){
+            ssize_t written = copy_file_range(in, nullptr, out, nullptr, static_cast<size_t>(remaining), 0);
+            if ( written < 0 && errno == EINTR )
+                continue;
+            if ( written <= 0 ){
+                copied = false;
+                break;
+            }
+            remaining -= written;
+        }
+    }
+
+    close(in);
+    close(out);
+    return copied;
+#else
+    MARK_UNUSED(from);
+    MARK_UNUSED(to);
+    return false;
+#endif
+}
+
 template <typename TP> std::chrono::system_clock::time_point toTimePoint(TP tp){
     return std::chrono::time_point_cast<std::chrono::system_clock::duration>(
         tp - TP::clock::now() + std::chrono::system_clock::now()
@@ -43,28 +126,64 @@ std::string Path::temporaryDirectory(){
     return fs::temp_directory_path().string();
 }
 
+/**
+ * \brief Returns a path next to \p p for writing a file that later replaces \p p
+ *
+ * The name contains the process id, the calling thread and a counter, so writers in different
+ * processes or threads never share the same temporary file.
+ */
+std::string Path::temporarySiblingPath(const std::string &p){
+    static std::atomic<unsigned int> index(0);
+#ifdef PLATFORM_OS_WIN
+    int processId = _getpid();
+#else
+    int processId = static_cast<int>(getpid());
+#endif
+    size_t threadId = std::hash<std::thread::id>()(std::this_thread::get_id());
+    return p + ".tmp" + std::to_string(processId) + "-" + std::to_string(threadId) + "-" + std::to_string(++index);
+}
+
 bool Path::exists(const std::string &s){
+    FileStatCache* cache = FileStatCache::active();
+    if ( cache )
+        return cache->exists(s);
     return fs::exists(s);
 }
 
 bool Path::createDirectory(const std::string &p){
-    return fs::create_directory(p);
+    bool result = fs::create_directory(p);
+    if ( FileStatCache* cache = FileStatCache::active() )
+        cache->invalidate(p);
+    return result;
 }
 
 bool Path::createDirectories(const std::string &p){
-    return fs::create_directories(p);
+    bool result = fs::create_directories(p);
+    if ( FileStatCache* cache = FileStatCache::active() )
+        cache->invalidateTree(p);
+    return result;
 }
 
 bool Path::isDir(const std::string &p){
+    FileStatCache* cache = FileStatCache::active();
+    if ( cache )
+        return cache->isDir(p);
     return fs::is_directory(p);
 }
 
 bool Path::remove(const std::string &p){
-    return fs::remove_all(p);
+    bool result = fs::remove_all(p);
+    if ( FileStatCache* cache = FileStatCache::active() )
+        cache->invalidateTree(p);
+    return result;
 }
 
 void Path::rename(const std::string &from, const std::string &to){
     fs::rename(from, to);
+    if ( FileStatCache* cache = FileStatCache::active() ){
+        cache->invalidateTree(from);
+        cache->invalidateTree(to);
+    }
 }
 
 /**
@@ -82,7 +201,10 @@ bool Path::copyFile(const std::string &from, const std::string &to, int options)
     if ( options & Path::UpdateExisting )
         sendOpts |= fs::copy_options::update_existing;
 
-    return fs::copy_file(from, to, sendOpts);
+    bool result = fs::copy_file(from, to, sendOpts);
+    if ( FileStatCache* cache = FileStatCache::active() )
+        cache->invalidate(to);
+    return result;
 }
 
 /**
@@ -104,6 +226,43 @@ void Path::copyRecursive(const std::string &from, const std::string &to, int opt
         sendOpts |= fs::copy_options::update_existing;
 
     fs::copy(from, to, sendOpts);
+    if ( FileStatCache* cache = FileStatCache::active() )
+        cache->invalidateTree(to);
+}
+
+/**
+ * \brief Copies file \p from to \p to, unless \p to has the same size and modification time.
+ *
+ * The copy receives the modification time of \p from, so an unchanged file is skipped by the
+ * next sync. On Linux the contents are cloned or copied in kernel when the file system allows.
+ * Returns true if the file was copied.
+ */
+bool Path::syncFile(const std::string &from, const std::string &to){
+    std::error_code ec;
+    if ( !fs::is_regular_file(from, ec) )
+        THROW_EXCEPTION(lv::Exception, Utf8("Path is not a file: %").format(from), lv::Exception::toCode("~File"));
+
+    std::uintmax_t fromSize = fs::file_size(from);
+    auto fromTime = fs::last_write_time(from);
+
+    if ( fs::is_regular_file(to, ec) ){
+        std::uintmax_t toSize = fs::file_size(to, ec);
+        if ( !ec && toSize == fromSize ){
+            auto toTime = fs::last_write_time(to, ec);
+            if ( !ec && toTime == fromTime )
+                return false;
+        }
+    }
+
+    // remove first, so a link at the destination is replaced instead of written through
+    fs::remove(to, ec);
+    if ( !copyFileInKernel(from, to) )
+        fs::copy_file(from, to, fs::copy_options::overwrite_existing);
+    fs::last_write_time(to, fromTime);
+
+    if ( FileStatCache* cache = FileStatCache::active() )
+        cache->invalidate(to);
+    return true;
 }
 
 std::string Path::join(const std::string &p1, const std::string &p2){
@@ -156,6 +315,63 @@ std::string Path::resolve(const std::string &p){
     return "";
 }
 
+/**
+ * \brief Same as Path::resolve, but caches the canonical path for the lifetime of the process.
+ *
+ * Only successful resolves are cached. Use invalidateResolveCache or clearResolveCache when
+ * paths are moved, removed or relinked.
+ */
+std::string Path::resolveCached(const std::string &p){
+    // key on the absolute path, so relative paths don't go stale when the working directory changes
+    std::string key = Path::absolutePath(p);
+
+    ResolveCache& cache = ResolveCache::instance();
+    {
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        auto it = cache.paths.find(key);
+        if ( it != cache.paths.end() )
+            return it->second;
+    }
+
+    std::string res = Path::resolve(key);
+
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    cache.paths[key] = res;
+    return res;
+}
+
+/**
+ * \brief Removes cached resolves of \p p, and of all the paths under \p p.
+ */
+void Path::invalidateResolveCache(const std::string &p){
+    std::string root = Path::absolutePath(p);
+
+    ResolveCache& cache = ResolveCache::instance();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+
+    auto isUnder = [&root](const std::string& path){
+        return path.compare(0, root.size(), root) == 0 &&
+              (path.size() == root.size() || path[root.size()] == '/' || path[root.size()] == Path::separator);
+    };
+
+    for ( auto it = cache.paths.begin(); it != cache.paths.end(); ){
+        if ( isUnder(it->first) || isUnder(it->second) ){
+            it = cache.paths.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+/**
+ * \brief Clears all cached resolves.
+ */
+void Path::clearResolveCache(){
+    ResolveCache& cache = ResolveCache::instance();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    cache.paths.clear();
+}
+
 std::string Path::rootPath(const std::string &p){
     return fs::path(p).root_path().string();
 }
@@ -178,6 +394,9 @@ bool Path::isAbsolute(const std::string &p){
 }
 
 bool Path::isFile(const std::string &p){
+    FileStatCache* cache = FileStatCache::active();
+    if ( cache )
+        return cache->isFile(p);
     return fs::is_regular_file(p);
 }
 
@@ -262,10 +481,12 @@ void Path::setPermissions(const std::string &p, int value){
 
 void Path::createSymlink(const std::string &link, const std::string &path){
     if ( Path::isDir(path) ){
-        return fs::create_directory_symlink(path, link);
+        fs::create_directory_symlink(path, link);
     } else {
-        return fs::create_symlink(path, link);
+        fs::create_symlink(path, link);
     }
+    if ( FileStatCache* cache = FileStatCache::active() )
+        cache->invalidate(link);
 }
 
 bool Path::isSymlink(const std::string &p){
@@ -310,11 +531,28 @@ std::string Path::relativePath(const std::string &referencePath, const std::stri
 }
 
 DateTime Path::lastModified(const std::string &path){
+    FileStatCache* cache = FileStatCache::active();
+    if ( cache && cache->exists(path) )
+        return DateTime::createFromMs(cache->lastModifiedMs(path));
+
     std::chrono::system_clock::time_point t = toTimePoint(fs::last_write_time(path));
     auto ms = std::chrono::time_point_cast<std::chrono::milliseconds>(t).time_since_epoch().count();
     return DateTime::createFromMs(ms);
 }
 
+/**
+ * \brief Returns the size in bytes of the file at \p path, or 0 if \p path is not a regular file.
+ */
+std::uintmax_t Path::fileSize(const std::string &path){
+    FileStatCache* cache = FileStatCache::active();
+    if ( cache )
+        return cache->fileSize(path);
+
+    std::error_code ec;
+    std::uintmax_t size = fs::file_size(path, ec);
+    return ec ? 0 : size;
+}
+
 Path::Path(){
 }
 
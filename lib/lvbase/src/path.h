@@ -6,6 +6,7 @@
 #include "live/datetime.h"
 
 #include <vector>
+#include <cstdint>
 
 namespace lv{
 
@@ -22,6 +23,7 @@ public:
 
 public:
     static std::string temporaryDirectory();
+    static std::string temporarySiblingPath(const std::string& p);
     static bool exists(const std::string& s);
 
     static bool createDirectory(const std::string& p);
@@ -33,6 +35,7 @@ public:
 
     static bool copyFile(const std::string& from, const std::string& to, int options = Path::OverwriteExisting);
     static void copyRecursive(const std::string& from, const std::string& to, int options = Path::OverwriteExisting);
+    static bool syncFile(const std::string& from, const std::string& to);
 
     static std::string join(const std::string& p1, const std::string& p2);
     template <typename... Paths>
@@ -48,6 +51,9 @@ public:
     static std::string parent(const std::string& p);
     static std::string absolutePath(const std::string& p);
     static std::string resolve(const std::string& p);
+    static std::string resolveCached(const std::string& p);
+    static void invalidateResolveCache(const std::string& p);
+    static void clearResolveCache();
     static std::string rootPath(const std::string& p);
     static std::string toUnixSeparator(const std::string& p);
     static bool isRelative(const std::string& p);
@@ -70,6 +76,7 @@ public:
     static std::string relativePath(const std::string& referencePath, const std::string& path);
 
     static DateTime lastModified(const std::string& path);
+    static std::uintmax_t fileSize(const std::string& path);
 
 private:
     Path();
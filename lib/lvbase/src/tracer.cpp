@@ -0,0 +1,195 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 Dinu SV.
+** This file is part of Livekeys Application.
+**
+** GNU Lesser General Public License Usage
+** This file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+****************************************************************************/
+
+#include "tracer.h"
+#include "live/mlnode.h"
+#include "live/mlnodetojson.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * \class lv::Tracer
+ * \brief Records timed events in the chrome://tracing (Perfetto) json format
+ *
+ * Events are recorded through the LV_TRACE_SCOPE and LV_TRACE_SCOPE_DETAIL macros, which expand to
+ * nothing unless the libraries are built with LV_ENABLE_TRACING. When compiled in, events are only
+ * recorded between Tracer::start() and Tracer::stop().
+ *
+ * \ingroup lvbase
+ */
+
+namespace lv{
+
+namespace{
+
+class TraceEvent{
+public:
+    const char*  category;
+    const char*  name;
+    std::string  detail;
+    std::int64_t start;
+    std::int64_t duration;
+    int          thread;
+};
+
+class TraceData{
+public:
+    TraceData() : recording(false){}
+
+    int threadIndex(){
+        auto id = std::this_thread::get_id();
+        auto it = threads.find(id);
+        if ( it != threads.end() )
+            return it->second;
+        int index = static_cast<int>(threads.size()) + 1;
+        threads[id] = index;
+        return index;
+    }
+
+    std::atomic<bool>                        recording;
+    std::mutex                               mutex;
+    std::vector<TraceEvent>                  events;
+    std::unordered_map<std::thread::id, int> threads;
+};
+
+TraceData& traceData(){
+    static TraceData data;
+    return data;
+}
+
+} // namespace
+
+/** Starts recording events. Events recorded previously are kept until clear() is called. */
+void Tracer::start(){
+    traceData().recording = true;
+}
+
+void Tracer::stop(){
+    traceData().recording = false;
+}
+
+bool Tracer::isRecording(){
+    return traceData().recording;
+}
+
+void Tracer::clear(){
+    TraceData& data = traceData();
+    std::lock_guard<std::mutex> lock(data.mutex);
+    data.events.clear();
+}
+
+size_t Tracer::totalEvents(){
+    TraceData& data = traceData();
+    std::lock_guard<std::mutex> lock(data.mutex);
+    return data.events.size();
+}
+
+/** Adds a complete event. \p category and \p name are expected to be string literals. */
+void Tracer::addEvent(const char *category, const char *name, const std::string &detail, int64_t startUs, int64_t durationUs){
+    TraceData& data = traceData();
+    std::lock_guard<std::mutex> lock(data.mutex);
+    TraceEvent ev;
+    ev.category = category;
+    ev.name     = name;
+    ev.detail   = detail;
+    ev.start    = startUs;
+    ev.duration = durationUs;
+    ev.thread   = data.threadIndex();
+    data.events.push_back(ev);
+}
+
+/** Monotonic time in microseconds, used as the event timestamp */
+int64_t Tracer::nowUs(){
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+}
+
+namespace{
+
+MLNode traceToMLNode(){
+    TraceData& data = traceData();
+
+    MLNode events(MLNode::Array);
+    {
+        std::lock_guard<std::mutex> lock(data.mutex);
+        for ( const TraceEvent& ev : data.events ){
+            MLNode event(MLNode::Object);
+            event["name"] = ev.name;
+            event["cat"]  = ev.category;
+            event["ph"]   = "X";
+            event["ts"]   = static_cast<MLNode::IntType>(ev.start);
+            event["dur"]  = static_cast<MLNode::IntType>(ev.duration);
+            event["pid"]  = 1;
+            event["tid"]  = ev.thread;
+            if ( !ev.detail.empty() ){
+                MLNode args(MLNode::Object);
+                args["detail"] = ev.detail;
+                event["args"] = args;
+            }
+            events.append(event);
+        }
+    }
+
+    MLNode root(MLNode::Object);
+    root["traceEvents"] = events;
+    root["displayTimeUnit"] = "ms";
+    return root;
+}
+
+} // namespace
+
+void Tracer::toJson(std::string &result){
+    ml::toJson(traceToMLNode(), result);
+}
+
+/** Writes the recorded events to \p path, to be opened in chrome://tracing or Perfetto */
+void Tracer::save(const std::string &path){
+    ml::toJsonFile(traceToMLNode(), path);
+}
+
+
+// class Tracer::Scope
+// ----------------------------------------------------------------------------
+
+Tracer::Scope::Scope(const char *category, const char *name)
+    : m_category(category)
+    , m_name(name)
+    , m_start(Tracer::isRecording() ? Tracer::nowUs() : -1)
+{
+}
+
+Tracer::Scope::Scope(const char *category, const char *name, const std::string &detail)
+    : m_category(category)
+    , m_name(name)
+    , m_start(-1)
+{
+    if ( Tracer::isRecording() ){
+        m_detail = detail;
+        m_start = Tracer::nowUs();
+    }
+}
+
+Tracer::Scope::~Scope(){
+    if ( m_start >= 0 && Tracer::isRecording() )
+        Tracer::addEvent(m_category, m_name, m_detail, m_start, Tracer::nowUs() - m_start);
+}
+
+}// namespace
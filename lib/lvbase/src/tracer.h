@@ -0,0 +1,82 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 Dinu SV.
+** This file is part of Livekeys Application.
+**
+** GNU Lesser General Public License Usage
+** This file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+****************************************************************************/
+
+#ifndef LVTRACER_H
+#define LVTRACER_H
+
+#include "live/lvbaseglobal.h"
+
+#include <string>
+#include <cstdint>
+
+#ifdef LV_ENABLE_TRACING
+#define LV_TRACE_CONCAT_IMPL(a, b) a##b
+#define LV_TRACE_CONCAT(a, b) LV_TRACE_CONCAT_IMPL(a, b)
+#define LV_TRACE_SCOPE(category, name) \
+    lv::Tracer::Scope LV_TRACE_CONCAT(lvTraceScope, __LINE__)(category, name)
+#define LV_TRACE_SCOPE_DETAIL(category, name, detail) \
+    lv::Tracer::Scope LV_TRACE_CONCAT(lvTraceScope, __LINE__)(category, name, detail)
+#else
+#define LV_TRACE_SCOPE(category, name)
+#define LV_TRACE_SCOPE_DETAIL(category, name, detail)
+#endif
+
+namespace lv{
+
+class LV_BASE_EXPORT Tracer{
+
+    DISABLE_COPY(Tracer);
+
+public:
+    /**
+     * \class lv::Tracer::Scope
+     * \brief Records the time from construction to destruction as a single trace event
+     */
+    class LV_BASE_EXPORT Scope{
+
+        DISABLE_COPY(Scope);
+
+    public:
+        Scope(const char* category, const char* name);
+        Scope(const char* category, const char* name, const std::string& detail);
+        ~Scope();
+
+    private:
+        const char*  m_category;
+        const char*  m_name;
+        std::string  m_detail;
+        std::int64_t m_start;
+    };
+
+public:
+    static void start();
+    static void stop();
+    static bool isRecording();
+    static void clear();
+
+    static size_t totalEvents();
+    static void addEvent(const char* category, const char* name, const std::string& detail, std::int64_t startUs, std::int64_t durationUs);
+    static std::int64_t nowUs();
+
+    static void toJson(std::string& result);
+    static void save(const std::string& path);
+
+private:
+    Tracer();
+};
+
+}// namespace
+
+#endif // LVTRACER_H
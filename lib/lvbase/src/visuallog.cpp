@@ -20,6 +20,14 @@
 #include <unordered_map>
 #include <fstream>
 #include <list>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 
 /**
@@ -79,6 +87,7 @@
  * * toView - if the log messages should be passed to view
  * * logObjects - set flags for places where we should log objects
  * * prefix - formatted message prefix, depends on preset values (explained below)
+ * * async - if console and file output should be written from a background thread
  *
  * These settings can also be modified through the command line arguments (see --help).
  * We can output our logged messages in several ways: `Console`, `View`, `File` and `Extensions`. It's important to mention
@@ -89,6 +98,11 @@
  * to an external listener, be it a file or a network listener. If object logging isn't enabled, or the object isn't in the correct form, we once again default
  * to a console display.
  *
+ * With `async` enabled, console and file lines are queued in a bounded ring buffer and written in batches by a
+ * background thread, which also formats the prefix and timestamp. Producers never block: when the buffer is full,
+ * messages are dropped and counted (\sa droppedMessages). View and extension transports are still called
+ * synchronously. Use flushPending() to wait for queued messages to be written.
+ *
  * \ingroup lvbase
  */
 
@@ -160,19 +174,24 @@ public:
     );
 
     void closeFile();
+    void closeFileUnlocked();
 
 public:
     std::string        m_name;
     VisualLog::MessageInfo::Level m_applicationLevel;
     VisualLog::MessageInfo::Level m_defaultLevel;
     std::string        m_filePath;
-    int            m_output;
-    int            m_logObjects;
-    bool           m_logDaily;
+    std::atomic<int>  m_output;
+    int               m_logObjects;
+    std::atomic<bool> m_logDaily;
+
+    // guards the file state, which is used by the asynchronous writer thread as well
+    std::mutex     m_fileMutex;
     std::ofstream* m_logFile;
     std::string    m_logFilePath;
     DateTime       m_lastLog;
     std::string    m_prefix;
+    bool           m_async;
 
     std::list<std::shared_ptr<VisualLog::Transport> > m_transports;
 };
@@ -192,6 +211,7 @@ VisualLog::Configuration::Configuration(
     , m_logObjects(VisualLog::File | VisualLog::Extensions)
     , m_logDaily(dailyFile)
     , m_logFile(nullptr)
+    , m_async(false)
     , m_transports()
 {}
 
@@ -200,16 +220,22 @@ VisualLog::Configuration::Configuration(const std::string &name, const VisualLog
     , m_applicationLevel(other.m_applicationLevel)
     , m_defaultLevel(other.m_defaultLevel)
     , m_filePath(other.m_filePath)
-    , m_output(other.m_output)
+    , m_output(other.m_output.load())
     , m_logObjects(other.m_logObjects)
-    , m_logDaily(other.m_logDaily)
-    , m_logFile(other.m_logFile)
+    , m_logDaily(other.m_logDaily.load())
+    , m_logFile(nullptr)
     , m_prefix(other.m_prefix)
+    , m_async(other.m_async)
     , m_transports(other.m_transports)
 {
 }
 
 void VisualLog::Configuration::closeFile(){
+    std::lock_guard<std::mutex> lock(m_fileMutex);
+    closeFileUnlocked();
+}
+
+void VisualLog::Configuration::closeFileUnlocked(){
     if ( m_logFile != nullptr ){
         m_logFile->close();
         delete m_logFile;
@@ -282,6 +308,7 @@ int VisualLog::ConfigurationContainer::addConfiguration(const std::string &key,
 
     m_configurations.push_back(configuration);
     m_configurationMap[key] = configuration;
+    ++VisualLog::m_configurationGeneration;
 
     return static_cast<int>(m_configurations.size());
 }
@@ -312,6 +339,279 @@ int VisualLog::ConfigurationContainer::configurationCount() const{
     return static_cast<int>(m_configurations.size());
 }
 
+// VisualLog::AsyncWriter
+// ---------------------------------------------------------------------
+
+/// \private
+class VisualLog::AsyncWriter{
+
+public:
+    /// \private
+    class Entry{
+    public:
+        Entry()
+            : configuration(nullptr)
+            , output(0)
+            , level(VisualLog::MessageInfo::Info)
+            , location(nullptr)
+            , stamp(nullptr)
+            , stampMs(0)
+            , expandPrefix(false)
+        {}
+
+        VisualLog::Configuration*     configuration;
+        int                           output;
+        VisualLog::MessageInfo::Level level;
+        VisualLog::SourceLocation*    location;
+        DateTime*                     stamp;
+        std::int64_t                  stampMs;
+        bool                          expandPrefix;
+        std::string                   data;
+    };
+
+    static const size_t Capacity = 4096;
+    static const size_t MaxBatch = 256;
+
+    AsyncWriter();
+    ~AsyncWriter();
+
+    void push(Entry& entry);
+    void waitForWritten();
+    size_t dropped() const{ return m_dropped; }
+
+private:
+    /// \private
+    class Slot{
+    public:
+        std::atomic<size_t> sequence;
+        Entry               entry;
+    };
+
+    bool pop(Entry& entry);
+    bool hasPending() const;
+    void run();
+    void write(std::vector<Entry>& batch);
+
+    Slot*               m_slots;
+    std::atomic<size_t> m_enqueuePosition;
+    size_t              m_dequeuePosition;
+    std::atomic<size_t> m_written;
+    std::atomic<size_t> m_dropped;
+    size_t              m_reportedDropped;
+
+    std::atomic<bool>       m_sleeping;
+    std::atomic<bool>       m_stopping;
+    std::mutex              m_mutex;
+    std::condition_variable m_wakeCondition;
+    std::condition_variable m_writtenCondition;
+    std::thread             m_thread;
+};
+
+VisualLog::AsyncWriter::AsyncWriter()
+    : m_slots(new Slot[Capacity])
+    , m_enqueuePosition(0)
+    , m_dequeuePosition(0)
+    , m_written(0)
+    , m_dropped(0)
+    , m_reportedDropped(0)
+    , m_sleeping(false)
+    , m_stopping(false)
+{
+    for ( size_t i = 0; i < Capacity; ++i )
+        m_slots[i].sequence.store(i, std::memory_order_relaxed);
+    m_thread = std::thread(&VisualLog::AsyncWriter::run, this);
+}
+
+VisualLog::AsyncWriter::~AsyncWriter(){
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wakeCondition.notify_one();
+    m_thread.join();
+
+    Entry entry;
+    while ( pop(entry) ){
+        delete entry.location;
+        delete entry.stamp;
+    }
+    delete[] m_slots;
+}
+
+/**
+ * Adds an entry to the queue, moving its contents. Multiple threads can push at the same time. If the queue is
+ * full, the entry is dropped.
+ */
+void VisualLog::AsyncWriter::push(Entry &entry){
+    size_t position = m_enqueuePosition.load(std::memory_order_relaxed);
+    Slot* slot = nullptr;
+    while ( true ){
+        slot = &m_slots[position % Capacity];
+        size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+        if ( diff == 0 ){
+            if ( m_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed) )
+                break;
+        } else if ( diff < 0 ){
+            ++m_dropped;
+            delete entry.location;
+            delete entry.stamp;
+            entry.location = nullptr;
+            entry.stamp = nullptr;
+            return;
+        } else {
+            position = m_enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->entry = std::move(entry);
+    entry.location = nullptr;
+    entry.stamp = nullptr;
+    slot->sequence.store(position + 1, std::memory_order_release);
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if ( m_sleeping.load() ){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_wakeCondition.notify_one();
+    }
+}
+
+/** Waits until all entries pushed before this call have been written */
+void VisualLog::AsyncWriter::waitForWritten(){
+    if ( std::this_thread::get_id() == m_thread.get_id() )
+        return;
+
+    size_t target = m_enqueuePosition.load();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while ( m_written.load() < target ){
+        m_wakeCondition.notify_one();
+        m_writtenCondition.wait_for(lock, std::chrono::milliseconds(10));
+    }
+}
+
+bool VisualLog::AsyncWriter::pop(Entry &entry){
+    Slot& slot = m_slots[m_dequeuePosition % Capacity];
+    if ( slot.sequence.load(std::memory_order_acquire) != m_dequeuePosition + 1 )
+        return false;
+
+    entry = std::move(slot.entry);
+    slot.entry.location = nullptr;
+    slot.entry.stamp = nullptr;
+    slot.sequence.store(m_dequeuePosition + Capacity, std::memory_order_release);
+    ++m_dequeuePosition;
+    return true;
+}
+
+bool VisualLog::AsyncWriter::hasPending() const{
+    const Slot& slot = m_slots[m_dequeuePosition % Capacity];
+    return slot.sequence.load(std::memory_order_acquire) == m_dequeuePosition + 1;
+}
+
+void VisualLog::AsyncWriter::run(){
+    std::vector<Entry> batch;
+    batch.reserve(MaxBatch);
+
+    while ( true ){
+        Entry entry;
+        while ( batch.size() < MaxBatch && pop(entry) )
+            batch.push_back(std::move(entry));
+
+        if ( batch.empty() ){
+            if ( m_stopping )
+                return;
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_sleeping.store(true);
+            if ( !hasPending() && !m_stopping )
+                m_wakeCondition.wait_for(lock, std::chrono::milliseconds(50));
+            m_sleeping.store(false);
+            continue;
+        }
+
+        write(batch);
+        m_written += batch.size();
+        batch.clear();
+
+        size_t dropped = m_dropped;
+        if ( dropped > m_reportedDropped ){
+            VisualLog::internalMessageHandler()(
+                VisualLog::MessageInfo::Warning,
+                Utf8("% log messages dropped, the asynchronous queue was full.").format(dropped - m_reportedDropped).data()
+            );
+            m_reportedDropped = dropped;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_writtenCondition.notify_all();
+    }
+}
+
+/** Formats the batch entries, then writes console output at once and flushes each file once */
+void VisualLog::AsyncWriter::write(std::vector<Entry> &batch){
+    std::string console;
+    std::vector<VisualLog::Configuration*> files;
+
+    for ( Entry& entry : batch ){
+        VisualLog::Configuration* configuration = entry.configuration;
+
+        VisualLog::MessageInfo messageInfo(entry.level);
+        messageInfo.m_location = entry.location;
+        messageInfo.m_stamp = entry.stamp;
+        entry.location = nullptr;
+        entry.stamp = nullptr;
+
+        bool hasPrefix = entry.expandPrefix && !configuration->m_prefix.empty();
+        bool usesStamp = hasPrefix || ((entry.output & VisualLog::File) && configuration->m_logDaily);
+        if ( usesStamp && !messageInfo.m_stamp ){
+            messageInfo.m_stamp = new DateTime(DateTime::createFromMs(static_cast<size_t>(entry.stampMs)).toLocal());
+        }
+
+        std::string line = entry.expandPrefix
+            ? (hasPrefix ? messageInfo.expand(configuration->m_prefix) : std::string()) + entry.data + "\n"
+            : entry.data;
+
+        if ( entry.output & VisualLog::Console )
+            console += line;
+        if ( entry.output & VisualLog::File ){
+            VisualLog::writeFile(configuration, messageInfo, line, false);
+            if ( std::find(files.begin(), files.end(), configuration) == files.end() )
+                files.push_back(configuration);
+        }
+    }
+
+    if ( !console.empty() )
+        vLoggerConsole(console);
+    for ( VisualLog::Configuration* configuration : files ){
+        std::lock_guard<std::mutex> lock(configuration->m_fileMutex);
+        if ( configuration->m_logFile )
+            configuration->m_logFile->flush();
+    }
+}
+
+// VisualLog::Handle
+// ---------------------------------------------------------------------
+
+/**
+ * \brief Creates a handle for the configuration with the given \p tag
+ *
+ * The configuration is resolved on first use, so handles can be created statically.
+ */
+VisualLog::Handle::Handle(const std::string &tag)
+    : m_tag(tag)
+    , m_configuration(nullptr)
+    , m_applicationLevel(VisualLog::MessageInfo::Info)
+    , m_generation(0)
+{
+}
+
+void VisualLog::Handle::resolve() const{
+    unsigned int generation = VisualLog::m_configurationGeneration.load(std::memory_order_acquire);
+    VisualLog::Configuration* configuration = VisualLog::registeredConfigurations().configurationAtOrGlobal(m_tag);
+    m_configuration.store(configuration, std::memory_order_relaxed);
+    m_applicationLevel.store(configuration->m_applicationLevel, std::memory_order_relaxed);
+    m_generation.store(generation, std::memory_order_release);
+}
+
 // VisualLog
 // ---------------------------------------------------------------------
 
@@ -320,12 +620,14 @@ VisualLog::ViewTransport* VisualLog::m_model = nullptr;
 
 bool VisualLog::m_globalConfigured = false;
 
+std::atomic<unsigned int> VisualLog::m_configurationGeneration(1);
+
 /**
  * \brief Default constructor of VisualLog
  */
 VisualLog::VisualLog()
     : m_configuration(registeredConfigurations().globalConfiguration())
-    , m_stream(new std::stringstream)
+    , m_stream(nullptr)
     , m_objectOutput(false)
 {
     m_messageInfo.m_level = m_configuration->m_defaultLevel;
@@ -338,7 +640,7 @@ VisualLog::VisualLog()
 VisualLog::VisualLog(VisualLog::MessageInfo::Level level)
     : m_configuration(registeredConfigurations().globalConfiguration())
     , m_messageInfo(level)
-    , m_stream(new std::stringstream)
+    , m_stream(nullptr)
     , m_objectOutput(false)
 {
     init();
@@ -349,7 +651,7 @@ VisualLog::VisualLog(VisualLog::MessageInfo::Level level)
 */
 VisualLog::VisualLog(const std::string &configurationKey)
     : m_configuration(registeredConfigurations().configurationAtOrGlobal(configurationKey))
-    , m_stream(new std::stringstream)
+    , m_stream(nullptr)
     , m_objectOutput(false)
 {
     m_messageInfo.m_level = m_configuration->m_defaultLevel;
@@ -360,7 +662,21 @@ VisualLog::VisualLog(const std::string &configurationKey)
 VisualLog::VisualLog(const std::string &configurationKey, VisualLog::MessageInfo::Level level)
     : m_configuration(registeredConfigurations().configurationAtOrGlobal(configurationKey))
     , m_messageInfo(level)
-    , m_stream(new std::stringstream)
+    , m_stream(nullptr)
+    , m_objectOutput(false)
+{
+    init();
+}
+
+/**
+ * \brief Constructor of VisualLog from a cached configuration handle
+ *
+ * Used by the vlog_if macro, which already checked the level.
+ */
+VisualLog::VisualLog(const VisualLog::Handle &handle, VisualLog::MessageInfo::Level level)
+    : m_configuration(handle.configuration())
+    , m_messageInfo(level)
+    , m_stream(nullptr)
     , m_objectOutput(false)
 {
     init();
@@ -434,8 +750,7 @@ void VisualLog::configure(const std::string &configuration, const MLNode& option
 
     VisualLog::Configuration* cfg = registeredConfigurations().configurationAt(configuration);
     if ( !cfg ){
-        cfg = new VisualLog::Configuration(*registeredConfigurations().globalConfiguration());
-        cfg->m_name = configuration;
+        cfg = new VisualLog::Configuration(configuration, *registeredConfigurations().globalConfiguration());
         registeredConfigurations().addConfiguration(configuration, cfg);
     }
 
@@ -457,6 +772,11 @@ void VisualLog::configure(VisualLog::Configuration *configuration, const MLNode
         m_globalConfigured = true;
     }
 
+    flushPending(); // queued messages may still use the current file and prefix
+
+    // keeps the writer thread from using the file or changing the output while they are reconfigured
+    std::lock_guard<std::mutex> fileLock(configuration->m_fileMutex);
+
     for ( auto it = options.begin(); it != options.end(); ++it ){
         if ( it.key() == "level" ){
             if ( it.value().type() == MLNode::String ){
@@ -473,7 +793,7 @@ void VisualLog::configure(VisualLog::Configuration *configuration, const MLNode
         } else if ( it.key() == "file" ){
             std::string v = it.value().asString();
             if ( configuration->m_filePath != v ){
-                configuration->closeFile();
+                configuration->closeFileUnlocked();
                 configuration->m_filePath = v;
                 if ( !configuration->m_filePath.empty() ){
                     configuration->m_output = configuration->m_output | VisualLog::File;
@@ -508,6 +828,10 @@ void VisualLog::configure(VisualLog::Configuration *configuration, const MLNode
             configuration->m_logObjects = it.value().asInt();
         } else if ( it.key() == "prefix" ){
             configuration->m_prefix = it.value().asString();
+        } else if ( it.key() == "async" ){
+            configuration->m_async = it.value().asBool();
+            if ( configuration->m_async && !asyncWriter() )
+                asyncWriter().reset(new VisualLog::AsyncWriter);
         } else {
             VisualLog::internalMessageHandler()(
                 VisualLog::MessageInfo::Warning, Utf8("Unknown configuration key: %.").format(it.key()).data()
@@ -515,6 +839,8 @@ void VisualLog::configure(VisualLog::Configuration *configuration, const MLNode
         }
     }
 
+    ++m_configurationGeneration; // handles need to pick up level changes
+
     //TODO: Requires parameter validation checking (e.g. log file / path exists)
 }
 
@@ -524,8 +850,7 @@ void VisualLog::addTransport(const std::string &configuration, VisualLog::Transp
 
     VisualLog::Configuration* cfg = registeredConfigurations().configurationAt(configuration);
     if ( !cfg ){
-        cfg = new VisualLog::Configuration(*registeredConfigurations().globalConfiguration());
-        cfg->m_name = configuration;
+        cfg = new VisualLog::Configuration(configuration, *registeredConfigurations().globalConfiguration());
         registeredConfigurations().addConfiguration(configuration, cfg);
     }
 
@@ -565,24 +890,29 @@ int VisualLog::totalConfigurations(){
 /** \brief Flushes the entire buffer to preset outputs */
 void VisualLog::flushLine(){
     if ( canLog() ){
-        std::string pref = prefix();
-        std::string buffer = m_stream->str();
-        if ( m_output & VisualLog::Console )
-            vLoggerConsole(pref + buffer + "\n");
-        if ( m_output & VisualLog::File )
-            flushFile(pref + buffer + "\n");
+        std::string buffer = m_stream ? m_stream->str() : std::string();
+        int textOutput = m_output & (VisualLog::Console | VisualLog::File);
+        if ( textOutput && !(m_configuration->m_async && flushAsync(textOutput, buffer, true)) ){
+            std::string pref = prefix();
+            if ( m_output & VisualLog::Console )
+                vLoggerConsole(pref + buffer + "\n");
+            if ( m_output & VisualLog::File )
+                flushFile(pref + buffer + "\n");
+        }
         if ( m_output & VisualLog::View && m_model )
             m_model->onMessage(m_configuration, m_messageInfo, buffer);
         if ( m_output & VisualLog::Extensions )
             flushHandler(buffer);
 
-        m_stream->clear();
+        if ( m_stream )
+            m_stream->clear();
     }
 }
 
 /** \brief Closes the internal log file */
 void VisualLog::closeFile(){
     m_output = 0; // Disable output
+    flushPending();
     m_configuration->closeFile();
 }
 
@@ -595,13 +925,18 @@ void VisualLog::asObject(const std::string &type, const MLNode &mlvalue){
         pref + "\\@" + type + "\n" +
         std::string(pref.length(), ' ') + str + "\n";
 
-    if ( m_output & VisualLog::Console && m_configuration->m_logObjects & VisualLog::Console ){
-        flushConsole(writeData);
-        m_output &= ~VisualLog::Console; // remove console flag from text based logging
-    }
-    if ( m_output & VisualLog::File && m_configuration->m_logObjects & VisualLog::File ){
-        flushFile(writeData);
-        m_output &= ~VisualLog::File; // remove file flag from text based logging
+    int textOutput = m_output & m_configuration->m_logObjects & (VisualLog::Console | VisualLog::File);
+    if ( textOutput && m_configuration->m_async && flushAsync(textOutput, writeData, false) ){
+        m_output &= ~textOutput; // remove console and file flags from text based logging
+    } else {
+        if ( m_output & VisualLog::Console && m_configuration->m_logObjects & VisualLog::Console ){
+            flushConsole(writeData);
+            m_output &= ~VisualLog::Console; // remove console flag from text based logging
+        }
+        if ( m_output & VisualLog::File && m_configuration->m_logObjects & VisualLog::File ){
+            flushFile(writeData);
+            m_output &= ~VisualLog::File; // remove file flag from text based logging
+        }
     }
     if ( m_output & VisualLog::Extensions && m_configuration->m_logObjects & VisualLog::Extensions){
         for ( auto it = m_configuration->m_transports.begin(); it != m_configuration->m_transports.end(); ++it ){
@@ -626,34 +961,72 @@ void VisualLog::init(){
 }
 
 void VisualLog::flushFile(const std::string& data){
-    if ( m_configuration->m_logDaily ){
-        DateTime cdt = m_messageInfo.stamp();
-        if ( cdt.dayOfYear() != m_configuration->m_lastLog.dayOfYear() || m_configuration->m_logFile == nullptr ){
-            m_configuration->m_logFile = new std::ofstream;
-            m_configuration->m_logFilePath = cdt.format(m_configuration->m_filePath);
-            m_configuration->m_logFile->open(m_configuration->m_logFilePath, std::ios::out | std::ios::binary | std::ios::app );
-            if ( !m_configuration->m_logFile->is_open() ){
-                m_configuration->m_output = removeOutputFlag(m_configuration->m_output, VisualLog::File);
-                std::string fileName = m_configuration->m_logFilePath;
-                delete m_configuration->m_logFile;
-                m_configuration->m_logFile = nullptr;
-                m_configuration->m_logFilePath = "";
+    writeFile(m_configuration, m_messageInfo, data, true);
+}
+
+/**
+ * Queues \p data for the \p output flags on the asynchronous writer. Returns false if the writer is not available,
+ * in which case the data needs to be written directly. The timestamp is captured here, but formatted by the writer.
+ */
+bool VisualLog::flushAsync(int output, const std::string &data, bool expandPrefix){
+    VisualLog::AsyncWriter* writer = asyncWriter().get();
+    if ( !writer )
+        return false;
+
+    VisualLog::AsyncWriter::Entry entry;
+    entry.configuration = m_configuration;
+    entry.output        = output;
+    entry.level         = m_messageInfo.m_level;
+    entry.expandPrefix  = expandPrefix;
+    entry.data          = data;
+
+    if ( expandPrefix && !m_configuration->m_prefix.empty() && m_messageInfo.m_location )
+        entry.location = new VisualLog::SourceLocation(*m_messageInfo.m_location);
+    if ( m_messageInfo.m_stamp ){
+        entry.stamp = new DateTime(*m_messageInfo.m_stamp);
+    } else {
+        entry.stampMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()
+        ).count();
+    }
+
+    writer->push(entry);
+    return true;
+}
+
+void VisualLog::writeFile(VisualLog::Configuration *configuration, const MessageInfo &messageInfo, const std::string &data, bool flush){
+    std::lock_guard<std::mutex> lock(configuration->m_fileMutex);
+
+    if ( configuration->m_logDaily ){
+        DateTime cdt = messageInfo.stamp();
+        if ( cdt.dayOfYear() != configuration->m_lastLog.dayOfYear() || configuration->m_logFile == nullptr ){
+            configuration->closeFileUnlocked();
+            configuration->m_lastLog = cdt;
+            configuration->m_logFile = new std::ofstream;
+            configuration->m_logFilePath = cdt.format(configuration->m_filePath);
+            configuration->m_logFile->open(configuration->m_logFilePath, std::ios::out | std::ios::binary | std::ios::app );
+            if ( !configuration->m_logFile->is_open() ){
+                configuration->m_output = removeOutputFlag(configuration->m_output, VisualLog::File);
+                std::string fileName = configuration->m_logFilePath;
+                delete configuration->m_logFile;
+                configuration->m_logFile = nullptr;
+                configuration->m_logFilePath = "";
                 VisualLog::internalMessageHandler()(
                     VisualLog::MessageInfo::Error, Utf8("Failed to open file: \'%\'. Closing file output stream.").format(fileName).data()
                 );
                 return;
             }
         }
-    } else if ( m_configuration->m_logFile == nullptr ){
-        m_configuration->m_logFile = new std::ofstream;
-        m_configuration->m_logFilePath = m_configuration->m_filePath;
-        m_configuration->m_logFile->open(m_configuration->m_logFilePath, std::ios::out | std::ios::binary | std::ios::app );
-        if ( !m_configuration->m_logFile->is_open() ){
-            m_configuration->m_output = removeOutputFlag(m_configuration->m_output, VisualLog::File);
-            std::string fileName = m_configuration->m_logFilePath;
-            delete m_configuration->m_logFile;
-            m_configuration->m_logFile = nullptr;
-            m_configuration->m_logFilePath = "";
+    } else if ( configuration->m_logFile == nullptr ){
+        configuration->m_logFile = new std::ofstream;
+        configuration->m_logFilePath = configuration->m_filePath;
+        configuration->m_logFile->open(configuration->m_logFilePath, std::ios::out | std::ios::binary | std::ios::app );
+        if ( !configuration->m_logFile->is_open() ){
+            configuration->m_output = removeOutputFlag(configuration->m_output, VisualLog::File);
+            std::string fileName = configuration->m_logFilePath;
+            delete configuration->m_logFile;
+            configuration->m_logFile = nullptr;
+            configuration->m_logFilePath = "";
             VisualLog::internalMessageHandler()(
                 VisualLog::MessageInfo::Error, Utf8("Failed to open file: \'%\'. Closing file output stream.").format(fileName).data()
             );
@@ -661,8 +1034,14 @@ void VisualLog::flushFile(const std::string& data){
         }
     }
 
-    m_configuration->m_logFile->write(data.c_str(), data.length());
-    m_configuration->m_logFile->flush();
+    configuration->m_logFile->write(data.c_str(), data.length());
+    if ( flush )
+        configuration->m_logFile->flush();
+}
+
+std::unique_ptr<VisualLog::AsyncWriter> &VisualLog::asyncWriter(){
+    static std::unique_ptr<VisualLog::AsyncWriter> writer;
+    return writer;
 }
 
 void VisualLog::flushHandler(const std::string &data){
@@ -678,6 +1057,19 @@ void VisualLog::flushConsole(const std::string &data){
     vLoggerConsole(data);
 }
 
+/** Waits until messages queued by asynchronous configurations are written */
+void VisualLog::flushPending(){
+    VisualLog::AsyncWriter* writer = asyncWriter().get();
+    if ( writer )
+        writer->waitForWritten();
+}
+
+/** Returns the number of messages dropped because the asynchronous queue was full */
+size_t VisualLog::droppedMessages(){
+    VisualLog::AsyncWriter* writer = asyncWriter().get();
+    return writer ? writer->dropped() : 0;
+}
+
 void VisualLog::setInternalMessageHandler(const VisualLog::MessageHandlerFunction &fn){
     if (fn)
         VisualLog::internalMessageHandler() = fn;
@@ -20,6 +20,8 @@
 #include <sstream>
 #include <ostream>
 #include <functional>
+#include <memory>
+#include <atomic>
 
 #include "live/mlnode.h"
 
@@ -33,6 +35,7 @@ class LV_BASE_EXPORT VisualLog{
 public:
     class Configuration;
     class ConfigurationContainer;
+    class AsyncWriter;
 
     typedef std::function<void(int, const std::string&)> MessageHandlerFunction;
 
@@ -169,11 +172,40 @@ public:
         ) = 0;
     };
 
+    /**
+     * \class lv::VisualLog::Handle
+     * \brief Cached reference to a configuration, for logging from hot paths
+     *
+     * The configuration is looked up by its tag once, and again only after configurations change. Use it
+     * through the vlog_if macro, which checks the level before the message or its arguments are built.
+     *
+     * \ingroup lvbase
+     */
+    class LV_BASE_EXPORT Handle{
+
+        DISABLE_COPY(Handle);
+
+    public:
+        Handle(const std::string& tag);
+
+        bool canLog(MessageInfo::Level level) const;
+        Configuration* configuration() const;
+
+    private:
+        void resolve() const;
+
+        std::string                          m_tag;
+        mutable std::atomic<Configuration*>  m_configuration;
+        mutable std::atomic<int>             m_applicationLevel;
+        mutable std::atomic<unsigned int>    m_generation;
+    };
+
 public:
     VisualLog();
     VisualLog(MessageInfo::Level level);
     VisualLog(const std::string& configuration);
     VisualLog(const std::string& configuration, MessageInfo::Level level);
+    VisualLog(const Handle& handle, MessageInfo::Level level);
     ~VisualLog();
 
     VisualLog& at(const std::string& file, int line = 0, const std::string& functionName = "");
@@ -221,6 +253,8 @@ public:
     static void setViewTransport(ViewTransport* model);
 
     static void flushConsole(const std::string& data);
+    static void flushPending();
+    static size_t droppedMessages();
     static void setInternalMessageHandler(const MessageHandlerFunction& fn);
 
 private:
@@ -228,13 +262,17 @@ private:
 
     void init();
     void flushFile(const std::string &data);
+    bool flushAsync(int output, const std::string& data, bool expandPrefix);
     void flushHandler(const std::string& data);
     std::string prefix();
     bool canLogObjects(VisualLog::Configuration* configuration);
+    std::stringstream& stream();
 
     template<typename T> void object(MessageInfo::Level level, const T& value);
 
     static int removeOutputFlag(int flags, VisualLog::Output output);
+    static void writeFile(VisualLog::Configuration* configuration, const MessageInfo& messageInfo, const std::string& data, bool flush);
+    static std::unique_ptr<AsyncWriter>& asyncWriter();
 
     static ConfigurationContainer createDefaultConfigurations();
     static ConfigurationContainer& registeredConfigurations();
@@ -244,6 +282,7 @@ private:
     static ViewTransport* m_model;
 
     static bool m_globalConfigured;
+    static std::atomic<unsigned int> m_configurationGeneration;
 
     int                m_output;
     Configuration*     m_configuration;
@@ -275,6 +314,23 @@ inline VisualLog::SourceLocation::SourceLocation(
 {
 }
 
+// VisualLog::Handle
+// ---------------------------------------------------------------------
+
+/** \brief Returns true if a message of the given \p level would be logged by this configuration */
+inline bool VisualLog::Handle::canLog(MessageInfo::Level level) const{
+    if ( m_generation.load(std::memory_order_acquire) != VisualLog::m_configurationGeneration.load(std::memory_order_relaxed) )
+        resolve();
+    return level <= m_applicationLevel.load(std::memory_order_relaxed);
+}
+
+/** \brief Returns the configuration this handle refers to */
+inline VisualLog::Configuration *VisualLog::Handle::configuration() const{
+    if ( m_generation.load(std::memory_order_acquire) != VisualLog::m_configurationGeneration.load(std::memory_order_relaxed) )
+        resolve();
+    return m_configuration.load(std::memory_order_relaxed);
+}
+
 // VisualLog
 // ---------------------------------------------------------------------
 
@@ -419,12 +475,19 @@ inline std::string VisualLog::MessageInfo::sourceFunctionName() const{
     return m_location ? m_location->functionName : "";
 }
 
+/** \brief Returns the message stream, creating it on first use */
+inline std::stringstream &VisualLog::stream(){
+    if ( !m_stream )
+        m_stream = new std::stringstream;
+    return *m_stream;
+}
+
 /** \brief Stream insertion operator */
 template<typename T> VisualLog& VisualLog::operator<< (const T& x){
     if ( !canLog() )
         return *this;
 
-    *m_stream << x;
+    stream() << x;
 
     return *this;
 }
@@ -436,7 +499,7 @@ template<typename T> VisualLog& VisualLog::operator<< (std::ostream &(*f)(std::o
 
     std::stringstream ss;
     f(ss);
-    *m_stream << ss.str().c_str();
+    stream() << ss.str().c_str();
 
     return *this;
 }
@@ -448,7 +511,7 @@ template<typename T> VisualLog& VisualLog::operator<< ( std::ostream& (*f)(std::
 
     std::stringstream ss;
     f(ss);
-    *m_stream << ss.str().c_str();
+    stream() << ss.str().c_str();
 
     return *this;
 }
@@ -460,7 +523,7 @@ template<typename T> VisualLog& VisualLog::operator<< ( std::ostream (*f)(std::i
 
     std::stringstream ss;
     f(ss);
-    *m_stream << ss.str().c_str();
+    stream() << ss.str().c_str();
 
     return *this;
 }
@@ -481,6 +544,12 @@ template<typename T> VisualLog& VisualLog::operator<< ( std::ostream (*f)(std::i
 #endif // VLOG_DEBUG_BUILD
 #endif // vlog_debug
 
+#ifndef vlog_if
+#define vlog_if(_handle, _level) \
+    if ( !(_handle).canLog(lv::VisualLog::MessageInfo::_level) ){} else \
+        lv::VisualLog(_handle, lv::VisualLog::MessageInfo::_level).at(__FILE__, __LINE__, __FUNCTION__)
+#endif // vlog_if
+
 #endif // VLOG_NO_MACROS
 
 
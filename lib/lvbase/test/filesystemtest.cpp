@@ -20,8 +20,12 @@
 #include "live/fileio.h"
 #include "live/path.h"
 #include "live/directory.h"
+#include "live/filestatcache.h"
+#include "live/mappedfile.h"
 
+#include <filesystem>
 #include <map>
+#include <thread>
 
 using namespace lv;
 
@@ -214,5 +218,105 @@ TEST_CASE( "FileSystem Test", "[FileSystem]" ) {
 
         REQUIRE(Path::remove(newdir));
     }
-}
+    SECTION("Test Resolve Cache"){
+        std::string newdir = Path::join(workPath(), "newdir");
+        if ( Path::exists(newdir)){
+            REQUIRE(Path::remove(newdir));
+        }
+        REQUIRE(Path::createDirectory(newdir));
+
+        std::string relative = Path::join(newdir, "../newdir");
+        REQUIRE(Path::resolveCached(relative) == Path::resolve(relative));
+
+        REQUIRE(Path::remove(newdir));
+        REQUIRE(Path::resolveCached(relative) == Path::resolve(workPath()) + Path::separator + "newdir");
+
+        Path::invalidateResolveCache(newdir);
+        REQUIRE_THROWS_AS(Path::resolveCached(relative), lv::Exception);
+
+        // relative paths follow the working directory
+        REQUIRE(Path::createDirectories(Path::join(newdir, "a", "x")));
+        REQUIRE(Path::createDirectories(Path::join(newdir, "b", "x")));
+        std::filesystem::path cwd = std::filesystem::current_path();
+        std::filesystem::current_path(Path::join(newdir, "a"));
+        REQUIRE(Path::resolveCached("x") == Path::resolve(Path::join(newdir, "a", "x")));
+        std::filesystem::current_path(Path::join(newdir, "b"));
+        REQUIRE(Path::resolveCached("x") == Path::resolve(Path::join(newdir, "b", "x")));
+        std::filesystem::current_path(cwd);
+
+        REQUIRE(Path::remove(newdir));
+    }
+
+    SECTION("Test Sync File"){
+        std::string from = Path::join(workPath(), "syncfrom.txt");
+        std::string to = Path::join(workPath(), "syncto.txt");
+        FileIO fio;
+        fio.writeToFile(from, "sync content");
+        if ( Path::exists(to) )
+            REQUIRE(Path::remove(to));
+
+        REQUIRE(Path::syncFile(from, to));
+        REQUIRE(fio.readFromFile(to) == "sync content");
+        REQUIRE(!Path::syncFile(from, to));
+
+        fio.writeToFile(from, "changed sync content");
+        REQUIRE(Path::syncFile(from, to));
+        REQUIRE(fio.readFromFile(to) == "changed sync content");
+
+        REQUIRE(Path::remove(from));
+        REQUIRE(Path::remove(to));
+    }
 
+    SECTION("Test Mapped File"){
+        std::string file = Path::join(workPath(), "mapped.txt");
+        FileIO fio;
+        fio.writeToFile(file, "mapped content");
+
+        MappedFile::Ptr mf = MappedFile::open(file);
+        REQUIRE(std::string(mf->data(), mf->size()) == "mapped content");
+        mf = nullptr;
+
+        REQUIRE(Path::remove(file));
+        REQUIRE_THROWS_AS(MappedFile::open(file), lv::Exception);
+    }
+
+    SECTION("Test File Stat Cache"){
+        std::string newdir = Path::join(workPath(), "newdir");
+        if ( Path::exists(newdir)){
+            REQUIRE(Path::remove(newdir));
+        }
+
+        FileStatCache cache;
+        FileStatCache::Scope scope(&cache);
+        REQUIRE(FileStatCache::active() == &cache);
+
+        // scopes only activate the cache on their own thread
+        FileStatCache* otherThreadActive = &cache;
+        std::thread([&otherThreadActive](){ otherThreadActive = FileStatCache::active(); }).join();
+        REQUIRE(otherThreadActive == nullptr);
+
+        REQUIRE(!Path::exists(newdir));
+        REQUIRE(!Path::exists(newdir));
+        REQUIRE(cache.misses() == 1);
+        REQUIRE(cache.hits() == 1);
+
+        REQUIRE(Path::createDirectory(newdir));
+        REQUIRE(Path::isDir(newdir));
+
+        std::string file = Path::join(newdir, "file.txt");
+        FileIO fio;
+        fio.writeToFile(file, "content");
+        REQUIRE(Path::isFile(file));
+        REQUIRE(Path::fileSize(file) == 7);
+
+        REQUIRE(Path::remove(newdir));
+        REQUIRE(!Path::exists(file));
+        REQUIRE(!Path::exists(newdir));
+
+        // an empty tree root matches nothing
+        size_t misses = cache.misses();
+        cache.invalidateTree("");
+        REQUIRE(!Path::exists(newdir));
+        REQUIRE(cache.misses() == misses);
+    }
+}
@@ -16,10 +16,96 @@
 
 #include "catch_library.h"
 #include "live/mlnode.h"
+#include "live/mlnodetojson.h"
 #include "live/visuallog.h"
 
+#include <map>
+
 using namespace lv;
 
+namespace{
+
+size_t& countedBytes(){
+    static size_t bytes = 0;
+    return bytes;
+}
+
+size_t& countedAllocations(){
+    static size_t allocations = 0;
+    return allocations;
+}
+
+template<typename T> class CountingAllocator{
+public:
+    typedef T value_type;
+
+    CountingAllocator(){}
+    template<typename U> CountingAllocator(const CountingAllocator<U>&){}
+
+    T* allocate(size_t n){
+        countedBytes() += n * sizeof(T);
+        ++countedAllocations();
+        return std::allocator<T>().allocate(n);
+    }
+    void deallocate(T* p, size_t n){
+        countedBytes() -= n * sizeof(T);
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    template<typename U> bool operator == (const CountingAllocator<U>&) const{ return true; }
+    template<typename U> bool operator != (const CountingAllocator<U>&) const{ return false; }
+};
+
+typedef std::map<
+    MLNode::StringType, MLNode, std::less<MLNode::StringType>,
+    CountingAllocator<std::pair<const MLNode::StringType, MLNode> >
+> TreeObject;
+
+typedef FlatMap<
+    MLNode::StringType, MLNode, std::less<MLNode::StringType>,
+    CountingAllocator<std::pair<MLNode::StringType, MLNode> >
+> FlatObject;
+
+// keys of a typical package or module descriptor, in file order
+std::vector<std::string> descriptorKeys(){
+    return {
+        "name", "version", "dependencies", "libraries", "modules", "palettes",
+        "release", "workspace", "documentation", "path", "files", "types"
+    };
+}
+
+template<typename Object> void fillObject(Object& object, const std::vector<std::string>& keys){
+    for ( const std::string& key : keys )
+        object[key] = MLNode(static_cast<MLNode::IntType>(key.size()));
+}
+
+template<typename Object> size_t lookupObject(const Object& object, const std::vector<std::string>& keys){
+    size_t found = 0;
+    for ( const std::string& key : keys ){
+        if ( object.find(key) != object.end() )
+            ++found;
+    }
+    return found;
+}
+
+std::string descriptorsJson(int total, const std::vector<std::string>& keys){
+    std::string result = "[";
+    for ( int i = 0; i < total; ++i ){
+        if ( i > 0 )
+            result += ",";
+        result += "{";
+        for ( size_t k = 0; k < keys.size(); ++k ){
+            if ( k > 0 )
+                result += ",";
+            result += "\"" + keys[k] + "\":\"value" + std::to_string(k) + "\"";
+        }
+        result += "}";
+    }
+    return result + "]";
+}
+
+} // namespace
+
 
 TEST_CASE( "MLNode Test", "[MLNode]" ) {
     SECTION("Test Constructor"){
@@ -58,6 +144,13 @@ TEST_CASE( "MLNode Test", "[MLNode]" ) {
         n = MLNode::BytesType(data, 10);
         REQUIRE(n.type() == MLNode::Bytes);
         delete[] data;
+
+        // moving a child into its own parent
+        MLNode parent = {{"x", {{"y", 1}}}, {"z", 2}};
+        parent = std::move(parent["x"]);
+        REQUIRE(parent.type() == MLNode::Object);
+        REQUIRE(parent.size() == 1);
+        REQUIRE(parent["y"].asInt() == 1);
     }
     SECTION("Test Access Operator"){
         MLNode n = 100;
@@ -232,3 +325,69 @@ TEST_CASE( "MLNode Test", "[MLNode]" ) {
         REQUIRE(it == n.cend());
     }
 }
+
+TEST_CASE( "MLNode Object Storage Benchmark", "[MLNode][.benchmark]" ) {
+    std::vector<std::string> keys = descriptorKeys();
+    const int totalObjects = 1000;
+
+    size_t treeBytes = 0, treeAllocations = 0;
+    {
+        countedBytes() = 0;
+        countedAllocations() = 0;
+        std::vector<TreeObject> objects(totalObjects);
+        for ( TreeObject& object : objects )
+            fillObject(object, keys);
+        treeBytes = countedBytes();
+        treeAllocations = countedAllocations();
+    }
+
+    size_t flatBytes = 0, flatAllocations = 0;
+    {
+        countedBytes() = 0;
+        countedAllocations() = 0;
+        std::vector<FlatObject> objects(totalObjects);
+        for ( FlatObject& object : objects )
+            fillObject(object, keys);
+        flatBytes = countedBytes();
+        flatAllocations = countedAllocations();
+    }
+
+    WARN(
+        "Retained object storage for " << totalObjects << " objects with " << keys.size() << " keys: " <<
+        "std::map " << treeBytes << " bytes in " << treeAllocations << " allocations, " <<
+        "FlatMap " << flatBytes << " bytes in " << flatAllocations << " allocations"
+    );
+    REQUIRE(flatBytes < treeBytes);
+    REQUIRE(flatAllocations < treeAllocations);
+
+    BENCHMARK("std::map insert and find"){
+        TreeObject object;
+        fillObject(object, keys);
+        return lookupObject(object, keys);
+    };
+
+    BENCHMARK("FlatMap insert and find"){
+        FlatObject object;
+        fillObject(object, keys);
+        return lookupObject(object, keys);
+    };
+
+    TreeObject treeObject;
+    fillObject(treeObject, keys);
+    BENCHMARK("std::map find"){
+        return lookupObject(treeObject, keys);
+    };
+
+    FlatObject flatObject;
+    fillObject(flatObject, keys);
+    BENCHMARK("FlatMap find"){
+        return lookupObject(flatObject, keys);
+    };
+
+    std::string json = descriptorsJson(totalObjects, keys);
+    BENCHMARK("Parse descriptors json"){
+        MLNode n;
+        ml::fromJson(json, n);
+        return n.size();
+    };
+}
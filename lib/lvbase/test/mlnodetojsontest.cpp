@@ -18,6 +18,9 @@
 #include "live/mlnode.h"
 #include "live/mlnodetojson.h"
 #include "live/visuallog.h"
+#include "live/fileio.h"
+#include "live/path.h"
+#include "live/directory.h"
 
 using namespace lv;
 
@@ -77,5 +80,70 @@ TEST_CASE( "MLNode to Json Test", "[MLNodeToJson]" ){
         REQUIRE(rt["float"].asFloat() == 100.1);
         REQUIRE(rt["null"].isNull());
     }
-}
+    SECTION("Test Deserialize Insitu"){
+        std::string data = "{\"object\":{\"string\":\"va\\\"l\\nue\",\"key2\":100,\"key2\":200},"
+                           "\"array\":[100,\"200\",false,[],{}],\"bool\":true,\"int\":-100,"
+                           "\"big\":4294967296,\"float\":100.1,\"null\":null}";
+
+        MLNode expected;
+        ml::fromJson(data, expected);
+
+        MLNode rt;
+        ml::fromJsonInsitu(data, rt);
 
+        std::string rtSerialized, expectedSerialized;
+        ml::toJson(rt, rtSerialized);
+        ml::toJson(expected, expectedSerialized);
+        REQUIRE(rtSerialized == expectedSerialized);
+        REQUIRE(rt["object"].size() == 2);
+        REQUIRE(rt["object"]["string"].asString() == MLNode::StringType("va\"l\nue"));
+        REQUIRE(rt["object"]["key2"].asInt() == 200);
+        REQUIRE(rt["array"].size() == 5);
+        REQUIRE(rt["array"][3].type() == MLNode::Type::Array);
+        REQUIRE(rt["array"][4].type() == MLNode::Type::Object);
+        REQUIRE(rt["int"].asInt() == -100);
+        REQUIRE(rt["big"].type() == MLNode::Type::Integer);
+        REQUIRE(rt["float"].asFloat() == 100.1);
+        REQUIRE(rt["null"].isNull());
+
+        std::string invalid = "{\"key\": [1, 2}";
+        MLNode n;
+        REQUIRE_THROWS_AS(ml::fromJsonInsitu(invalid, n), lv::Exception);
+    }
+    SECTION("Test Serialize To File"){
+        MLNode n = {
+            {"array", { 100, "200", false}},
+            {"string", "va\"lue"}
+        };
+
+        std::string expected;
+        ml::toJson(n, expected);
+
+        std::string workPath = Path::join(Path::temporaryDirectory(), "_mlnodetojsontest_");
+        Path::createDirectories(workPath);
+        std::string filePath = Path::join(workPath, "descriptor.json");
+
+        FileIO fileIO;
+        fileIO.writeToFile(filePath, "previous content that is longer than the json");
+        ml::toJsonFile(n, filePath);
+
+        REQUIRE(fileIO.readFromFile(filePath) == expected);
+        int totalFiles = 0;
+        Directory::Iterator dit = Directory::iterate(workPath);
+        while ( !dit.isEnd() ){
+            ++totalFiles;
+            dit.next();
+        }
+        REQUIRE(totalFiles == 1);
+
+        std::string tempPath = Path::temporarySiblingPath(filePath);
+        REQUIRE(tempPath != Path::temporarySiblingPath(filePath));
+        REQUIRE(Path::parent(tempPath) == workPath);
+
+        fileIO.replaceFile(filePath, "\0binary", 7);
+        std::string replaced = fileIO.readFromFile(filePath);
+        REQUIRE(replaced == std::string("\0binary", 7));
+
+        Path::remove(workPath);
+    }
+}
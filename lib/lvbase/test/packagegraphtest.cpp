@@ -0,0 +1,142 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 Dinu SV.
+**
+** This file is part of Livekeys Application.
+**
+** GNU Lesser General Public License Usage
+** This file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+****************************************************************************/
+
+#include "catch_library.h"
+#include "live/packagegraph.h"
+#include "live/packagecontext.h"
+#include "live/mlnode.h"
+#include "live/exception.h"
+#include "live/fileio.h"
+#include "live/path.h"
+
+#include <map>
+
+using namespace lv;
+
+namespace{
+
+Package::Ptr createPackage(const std::string& name){
+    return Package::createFromNode("/" + name, "/" + name + "/live.package.json", {
+        {"name", name}, {"version", "1.0.0"}
+    });
+}
+
+size_t indexOf(const std::vector<Package::Ptr>& order, const Package::Ptr& p){
+    for ( size_t i = 0; i < order.size(); ++i )
+        if ( order[i] == p )
+            return i;
+    return order.size();
+}
+
+}
+
+TEST_CASE( "PackageGraph Test", "[PackageGraph]" ) {
+    SECTION("Test Topological Order"){
+        PackageGraph::TopologicalOrder<int> order;
+        std::map<int, std::list<int> > dependencies;
+        std::map<int, std::list<int> > dependents;
+
+        auto addDependency = [&](int node, int dependsOn){
+            auto cr = order.addDependency(
+                node, dependsOn,
+                [&](int n) -> const std::list<int>& { return dependencies[n]; },
+                [&](int n) -> const std::list<int>& { return dependents[n]; }
+            );
+            if ( !cr.found() ){
+                dependencies[node].push_back(dependsOn);
+                dependents[dependsOn].push_back(node);
+            }
+            return cr;
+        };
+
+        for ( int i = 1; i <= 5; ++i )
+            order.insert(i);
+
+        REQUIRE_FALSE(addDependency(1, 2).found());
+        REQUIRE_FALSE(addDependency(2, 3).found());
+        REQUIRE_FALSE(addDependency(3, 5).found());
+        REQUIRE_FALSE(addDependency(1, 4).found());
+        REQUIRE(order.nodes() == std::vector<int>{5, 3, 2, 4, 1});
+
+        auto cr = addDependency(5, 1);
+        REQUIRE(cr.found());
+        REQUIRE(cr.path() == std::list<int>{5, 1, 2, 3, 5});
+        REQUIRE(order.nodes() == std::vector<int>{5, 3, 2, 4, 1});
+
+        REQUIRE(addDependency(4, 4).found());
+
+        order.remove(3);
+        REQUIRE(order.nodes() == std::vector<int>{5, 2, 4, 1});
+        REQUIRE_FALSE(order.contains(3));
+    }
+    SECTION("Test Package Dependencies"){
+        PackageGraph pg;
+        Package::Ptr a = createPackage("a");
+        Package::Ptr b = createPackage("b");
+        Package::Ptr c = createPackage("c");
+        pg.loadPackage(a);
+        pg.loadPackage(b);
+        pg.loadPackage(c);
+
+        pg.addDependency(a, b);
+        pg.addDependency(b, c);
+
+        auto order = pg.topologicalPackages();
+        REQUIRE(order.size() == 3);
+        REQUIRE(indexOf(order, c) < indexOf(order, b));
+        REQUIRE(indexOf(order, b) < indexOf(order, a));
+
+        REQUIRE_THROWS_AS(pg.addDependency(c, a), lv::Exception);
+        REQUIRE(c->context()->dependencies.empty());
+        REQUIRE(a->context()->dependents.empty());
+        REQUIRE_FALSE(pg.checkCycles(a).found());
+
+        c->context()->dependencies.push_back(a);
+        auto cr = pg.checkCycles(a);
+        REQUIRE(cr.found());
+        REQUIRE(cr.path() == std::list<Package::Ptr>{a, b, c, a});
+    }
+    SECTION("Test Find Package Cache"){
+        std::string importPath = Path::join(Path::temporaryDirectory(), "packagegraphtest");
+        if ( Path::exists(importPath) ){
+            REQUIRE(Path::remove(importPath));
+        }
+        REQUIRE(Path::createDirectories(Path::join(importPath, "pkga")));
+
+        FileIO fio;
+        fio.writeToFile(Path::join(importPath, "pkga", Package::fileName), "{\"name\": \"pkga\", \"version\": \"1.2.0\"}");
+
+        PackageGraph pg;
+        pg.setPackageImportPaths({importPath});
+
+        Package::Ptr pkga = pg.findPackage("pkga");
+        REQUIRE(pkga);
+        REQUIRE(pkga->version().toString() == "1.2.0");
+        REQUIRE(pg.findPackage("pkga") == pkga);
+        REQUIRE(pg.findPackage(Package::Reference("pkga", Version("1.0.0"))) == pkga);
+
+        REQUIRE_FALSE(pg.findPackage("pkgb"));
+
+        REQUIRE(Path::createDirectories(Path::join(importPath, "pkgb")));
+        fio.writeToFile(Path::join(importPath, "pkgb", Package::fileName), "{\"name\": \"pkgb\", \"version\": \"1.0.0\"}");
+        REQUIRE_FALSE(pg.findPackage("pkgb"));
+
+        pg.clearPackageCache();
+        REQUIRE(pg.findPackage("pkgb"));
+
+        REQUIRE(Path::remove(importPath));
+    }
+}
@@ -0,0 +1,56 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 Dinu SV.
+**
+** This file is part of Livekeys Application.
+**
+** GNU Lesser General Public License Usage
+** This file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+****************************************************************************/
+
+#include "catch_library.h"
+#include "live/tracer.h"
+#include "live/mlnode.h"
+#include "live/mlnodetojson.h"
+
+using namespace lv;
+
+TEST_CASE( "Tracer Test", "[Tracer]" ){
+    SECTION("Test Scope Recording"){
+        Tracer::clear();
+
+        { Tracer::Scope scope("test", "not recorded"); }
+        REQUIRE(Tracer::totalEvents() == 0);
+
+        Tracer::start();
+        {
+            Tracer::Scope outer("test", "outer", "detail");
+            Tracer::Scope inner("test", "inner");
+        }
+        Tracer::stop();
+        REQUIRE(Tracer::totalEvents() == 2);
+
+        std::string json;
+        Tracer::toJson(json);
+
+        MLNode result;
+        ml::fromJson(json, result);
+        const MLNode::ArrayType& events = result["traceEvents"].asArray();
+        REQUIRE(events.size() == 2);
+        REQUIRE(events[0]["name"].asString() == "inner");
+        REQUIRE(events[0]["ph"].asString() == "X");
+        REQUIRE(events[1]["name"].asString() == "outer");
+        REQUIRE(events[1]["args"]["detail"].asString() == "detail");
+        REQUIRE(events[1]["ts"].asInt() <= events[0]["ts"].asInt());
+        REQUIRE(events[1]["dur"].asInt() >= events[0]["dur"].asInt());
+
+        Tracer::clear();
+        REQUIRE(Tracer::totalEvents() == 0);
+    }
+}
@@ -21,6 +21,7 @@
 
 #include <vector>
 #include <utility>
+#include <thread>
 
 using namespace lv;
 
@@ -142,6 +143,36 @@ TEST_CASE( "VisualLog Test", "[VisualLog]" ) {
         vlog().configure("test", {{"prefix", ""}});
         vlog().removeTransports("test");
     }
+    SECTION("Test Handle"){
+        static VisualLog::Handle handle("testhandle");
+
+        VisualLogTransportStub* ts = new VisualLogTransportStub;
+        vlog().addTransport("testhandle", ts);
+        vlog().configure("testhandle", {
+            {"level", VisualLog::MessageInfo::Info}
+        });
+
+        int evaluated = 0;
+        auto argument = [&evaluated](){ ++evaluated; return "argument"; };
+
+        vlog_if(handle, Info) << "info " << argument();
+        vlog_if(handle, Verbose) << "verbose " << argument();
+
+        REQUIRE(ts->messages.size() == 1);
+        REQUIRE(ts->messages[0].second == "info argument");
+        REQUIRE(evaluated == 1);
+
+        vlog().configure("testhandle", {
+            {"level", VisualLog::MessageInfo::Verbose}
+        });
+
+        vlog_if(handle, Verbose) << "verbose " << argument();
+
+        REQUIRE(ts->messages.size() == 2);
+        REQUIRE(evaluated == 2);
+
+        vlog().removeTransports("testhandle");
+    }
     SECTION("Test File Output"){
         std::unique_ptr<FileIO> fio = std::make_unique<FileIO>();
 
@@ -185,5 +216,40 @@ TEST_CASE( "VisualLog Test", "[VisualLog]" ) {
         std::string contents = fio->readFromFile(workPath + "/_temp_.txt");
         REQUIRE(contents == "test info\n");
     }
-}
+    SECTION("Test Async File Output"){
+        std::unique_ptr<FileIO> fio = std::make_unique<FileIO>();
+
+        std::string tempFilePath = Path::join(Path::temporaryDirectory(), "_temp_async_.txt");
+        REQUIRE(fio->writeToFile(tempFilePath, ""));
+
+        vlog().configure("testasync", {
+            {"level",        VisualLog::MessageInfo::Info},
+            {"defaultLevel", VisualLog::MessageInfo::Info},
+            {"toConsole",    false},
+            {"file",         tempFilePath},
+            {"prefix",       "%v: "},
+            {"async",        true}
+        });
+
+        std::vector<std::thread> threads;
+        for ( int t = 0; t < 4; ++t ){
+            threads.push_back(std::thread([](){
+                for ( int i = 0; i < 500; ++i ){
+                    vlog("testasync") << "message " << i;
+                    vlog("testasync").d() << "skipped";
+                }
+            }));
+        }
+        for ( std::thread& th : threads )
+            th.join();
+
+        VisualLog::flushPending();
 
+        std::string contents = fio->readFromFile(tempFilePath);
+        auto lines = Utf8(contents).split("\n");
+        REQUIRE(VisualLog::droppedMessages() == 0);
+        REQUIRE(lines.size() == 2001);
+        REQUIRE(lines[0].substr(0, 14) == "info: message ");
+        REQUIRE(lines[2000] == "");
+    }
+}
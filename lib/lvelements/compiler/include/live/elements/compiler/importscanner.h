@@ -0,0 +1 @@
+#include "../../../../src/importscanner.h"
\ No newline at end of file
@@ -0,0 +1 @@
+#include "../../../../src/memoryaccounting.h"
\ No newline at end of file
@@ -15,6 +15,8 @@
 
 #include "compiler.h"
 #include "live/visuallog.h"
+#include "live/filestatcache.h"
+#include "live/tracer.h"
 #include "live/packagegraph.h"
 #include "live/packagecontext.h"
 #include "live/modulecontext.h"
@@ -22,13 +24,67 @@
 #include "languagenodestojs_p.h"
 #include "elementssections_p.h"
 #include "elementsmodule.h"
+#include "modulefile.h"
+#include "importscanner.h"
 #include "tracepointexception.h"
+#include "memoryaccounting.h"
+
+#include <set>
 
 namespace lv{ namespace el {
 
+namespace{
+
+VisualLog::Handle compilerLog("lvcompiler");
+
+std::string displayFilePath(const std::string& path, const std::string& packagePath){
+    std::string result = path;
+    Utf8::replaceAll(result, packagePath, "");
+    return result;
+}
+
+/**
+ * Activates the compiler's file stat cache for a compile call. The outermost session clears the
+ * cache on exit, unless it's being watched, so changes made between calls are not missed.
+ */
+class FileStatSession{
+
+    DISABLE_COPY(FileStatSession);
+
+public:
+    FileStatSession(FileStatCache* cache)
+        : m_cache(cache)
+        , m_outermost(cache && FileStatCache::active() != cache)
+        , m_scope(cache)
+    {
+    }
+
+    ~FileStatSession(){
+        if ( m_outermost && !m_cache->isWatching() )
+            m_cache->clear();
+    }
+
+private:
+    FileStatCache*        m_cache;
+    bool                  m_outermost;
+    FileStatCache::Scope  m_scope;
+};
+
+bool importsAnyOf(const ElementsModule::Ptr& module, const std::set<ElementsModule*>& modules){
+    for ( auto fit = module->fileExports().begin(); fit != module->fileExports().end(); ++fit ){
+        for ( const ModuleFile::ModuleImport& imp : fit->second->imports() ){
+            if ( imp.module && modules.find(imp.module.get()) != modules.end() )
+                return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
 class CompilerPrivate{
 public:
-    CompilerPrivate(const Compiler::Config& pconfig) : config(pconfig), packageGraph(nullptr){}
+    CompilerPrivate(const Compiler::Config& pconfig) : config(pconfig), packageGraph(nullptr), fileStatCache(nullptr){}
 
     Compiler::Config    config;
     LanguageParser::Ptr parser;
@@ -37,6 +93,8 @@ public:
     bool          packageGraphOwn;
     std::map<std::string, ElementsModule::Ptr> loadedModules;
     std::map<std::string, ElementsModule::Ptr> loadedModulesByPath;
+    std::set<std::string> builtModules;
+    FileStatCache* fileStatCache;
 
     BaseNode::ConversionContext* createConversionContext(
             BaseNode::ConversionContext::OutputTarget target = BaseNode::ConversionContext::JS,
@@ -79,11 +137,19 @@ Compiler::Compiler(const Config &opt, PackageGraph* pg)
     m_d->packageGraph = (pg == nullptr) ? new PackageGraph : pg;
     m_d->packageGraphOwn = (pg == nullptr) ? true : false;
     m_d->parser = LanguageParser::createForElements();
+
+    if ( m_d->config.m_fileStatCache ){
+        m_d->fileStatCache = new FileStatCache;
+        if ( m_d->config.m_fileStatWatch && !m_d->fileStatCache->enableWatcher() ){
+            vlog("lvcompiler").w() << "File watching is not available, file stat cache will be cleared after each compile.";
+        }
+    }
 }
 
 Compiler::~Compiler(){
     if ( m_d->packageGraphOwn )
         delete m_d->packageGraph;
+    delete m_d->fileStatCache;
     delete m_d;
 }
 
@@ -95,11 +161,19 @@ FileIOInterface *Compiler::fileIO() const{
     return m_d->config.m_fileIO;
 }
 
+/**
+ * \brief Returns the file stat cache used during compile calls, or nullptr if it's disabled
+ */
+FileStatCache *Compiler::fileStatCache() const{
+    return m_d->fileStatCache;
+}
+
 const std::list<std::string> &Compiler::importPaths() const{
     return m_d->config.m_importPaths;
 }
 
 Compiler::TargetResult Compiler::compileToTarget(const std::string &path, const std::string &contents){
+    MemoryAccounting::FileScope memoryScope(path);
     LanguageParser::AST* ast = m_d->parser->parse(contents);
     Compiler::TargetResult result = compileToTarget(path, contents, ast);
     LanguageParser::destroy(ast);
@@ -134,12 +208,18 @@ Compiler::TargetResult Compiler::compileToTarget(const std::string &path, const
 
         auto ctx = m_d->createConversionContext(target);
 
-        LanguageNodesToJs lnt;
-        lnt.convert(node, contents, section->m_children, 0, ctx);
+        {
+            LV_TRACE_SCOPE_DETAIL("compile", "convert", path);
+            LanguageNodesToJs lnt;
+            lnt.convert(node, contents, section->m_children, 0, ctx);
+        }
         delete ctx;
 
         std::vector<std::string> flatten;
-        section->flatten(contents, flatten);
+        {
+            LV_TRACE_SCOPE_DETAIL("compile", "flatten", path);
+            section->flatten(contents, flatten);
+        }
         for ( const std::string& s : flatten ){
             outStr += s;
         }
@@ -148,6 +228,7 @@ Compiler::TargetResult Compiler::compileToTarget(const std::string &path, const
 
         if ( m_d->config.m_fileOutput ){
             std::string outputPath = path + extension;
+            LV_TRACE_SCOPE_DETAIL("io", "write", outputPath);
             m_d->config.m_fileIO->writeToFile(outputPath, outStr);
         }
     };
@@ -211,12 +292,18 @@ Compiler::TargetResult Compiler::compileModuleFileToTarget(const Module::Ptr &mo
         section->to   = static_cast<int>(contents.size());
 
         auto ctx = m_d->createConversionContext(target, module, path, relativePathFromOutput.data());
-        LanguageNodesToJs lnt;
-        lnt.convert(node, contents, section->m_children, 0, ctx);
+        {
+            LV_TRACE_SCOPE_DETAIL("compile", "convert", path);
+            LanguageNodesToJs lnt;
+            lnt.convert(node, contents, section->m_children, 0, ctx);
+        }
         delete ctx;
 
         std::vector<std::string> flatten;
-        section->flatten(contents, flatten);
+        {
+            LV_TRACE_SCOPE_DETAIL("compile", "flatten", path);
+            section->flatten(contents, flatten);
+        }
 
         for ( const std::string& s : flatten ){
             outStr += s;
@@ -227,9 +314,6 @@ Compiler::TargetResult Compiler::compileModuleFileToTarget(const Module::Ptr &mo
         if ( m_d->config.m_fileOutput ){
             std::string outputFile = outputPath.data() + extension;
 
-            std::string displayFilePath = path;
-            Utf8::replaceAll(displayFilePath, module->packagePath(), "");
-
             bool shouldWrite = true;
             if ( m_d->config.m_fileOutputOnlyOnModified && Path::exists(outputFile) ){
                 DateTime sourceModifiedStamp = Path::lastModified(path);
@@ -241,17 +325,18 @@ Compiler::TargetResult Compiler::compileModuleFileToTarget(const Module::Ptr &mo
                 if ( !package->release().empty() ){
                     shouldWrite = false;
                     if ( extension != ".d.ts" && !Path::exists(outputFile) ){
-                        Utf8 msg = Utf8("Released package '%' missing build file: %").format(package->name(), displayFilePath);
+                        Utf8 msg = Utf8("Released package '%' missing build file: %").format(package->name(), displayFilePath(path, module->packagePath()));
                         THROW_EXCEPTION(lv::Exception, msg, Exception::toCode("~File"));
                     }
                 }
             }
 
             if ( shouldWrite ){
+                LV_TRACE_SCOPE_DETAIL("io", "write", outputFile);
                 m_d->config.m_fileIO->writeToFile(outputFile, outStr);
-                vlog("lvcompiler").v() << "Compiler: Compiled file: " << displayFilePath << extension;
+                vlog_if(compilerLog, Verbose) << "Compiler: Compiled file: " << displayFilePath(path, module->packagePath()) << extension;
             } else {
-                vlog("lvcompiler").v() << "Compiler: Skipped file: " << displayFilePath << extension;
+                vlog_if(compilerLog, Verbose) << "Compiler: Skipped file: " << displayFilePath(path, module->packagePath()) << extension;
             }
         }
     };
@@ -338,6 +423,8 @@ void Compiler::configureImplicitType(const std::string &type){
 }
 
 std::shared_ptr<ElementsModule> Compiler::compile(Ptr compiler, const std::string &path, Engine *engine){
+    FileStatSession fileStatSession(compiler->m_d->fileStatCache);
+
     std::string modulePath = Path::parent(path);
     std::string fileName = Path::name(path);
 
@@ -400,6 +487,8 @@ std::shared_ptr<ElementsModule> Compiler::compile(Ptr compiler, const std::strin
 }
 
 std::shared_ptr<ElementsModule> Compiler::compileModule(Compiler::Ptr compiler, const std::string &path, Engine *engine){
+    FileStatSession fileStatSession(compiler->m_d->fileStatCache);
+
     if ( !Path::exists(path) ){
         THROW_EXCEPTION(lv::Exception, Utf8("Path does not exist: %.").format(path), lv::Exception::toCode("~Path"));
     }
@@ -417,6 +506,8 @@ std::shared_ptr<ElementsModule> Compiler::compileModule(Compiler::Ptr compiler,
 }
 
 std::vector<std::shared_ptr<ElementsModule> > Compiler::compilePackage(Compiler::Ptr compiler, const std::string &path, Engine *engine){
+    FileStatSession fileStatSession(compiler->m_d->fileStatCache);
+
     if ( !Path::exists(path) ){
         THROW_EXCEPTION(lv::Exception, Utf8("Path doesn't exist: %.").format(path), lv::Exception::toCode("~Path"));
     }
@@ -437,6 +528,7 @@ std::vector<std::shared_ptr<ElementsModule> > Compiler::compilePackage(Compiler:
 }
 
 std::shared_ptr<ElementsModule> Compiler::createAndResolveImportedModule(Compiler::Ptr compiler, const std::string &importKey, const Module::Ptr& requestingModule, Engine *engine){
+    LV_TRACE_SCOPE_DETAIL("module", "import", importKey);
     auto foundEp = compiler->m_d->loadedModules.find(importKey);
     if ( foundEp == compiler->m_d->loadedModules.end() ){
         try{
@@ -462,6 +554,103 @@ std::shared_ptr<ElementsModule> Compiler::createAndResolveImportedModule(Compile
     return nullptr;
 }
 
+/**
+ * \brief Finds the modules imported by \p module, directly or indirectly, without parsing their files
+ *
+ * Module files are pre-scanned with ImportScanner, so the whole import graph is known before any
+ * file goes through the full parse. Modules are returned with each dependency placed before its
+ * dependents, ending with \p module. Imports that fail to resolve are skipped, since compiling
+ * the module reports them with their location. A \p module that isn't loaded yet is loaded as a
+ * running module of its package.
+ *
+ * When \p imports is given, it receives the modules each returned module imports directly, keyed
+ * by module path. Import cycles are kept there, while the returned order breaks them.
+ */
+std::vector<Module::Ptr> Compiler::scanModuleImports(
+        Compiler::Ptr compiler,
+        const Module::Ptr &module,
+        std::map<std::string, std::vector<Module::Ptr> >* imports)
+{
+    LV_TRACE_SCOPE_DETAIL("module", "scan imports", module->path());
+    FileStatSession fileStatSession(compiler->m_d->fileStatCache);
+
+    if ( !module->context() ){
+        Package::Ptr package = Package::createFromPath(module->package());
+        compiler->m_d->packageGraph->loadRunningPackageAndModule(package, module);
+    }
+
+    std::vector<Module::Ptr> result;
+    std::set<std::string> visited;
+
+    auto scanImported = [&compiler, imports](const Module::Ptr& m){
+        std::vector<Module::Ptr> imported = compiler->scanImportedModules(m);
+        if ( imports )
+            (*imports)[m->path()] = imported;
+        return imported;
+    };
+
+    // depth first, each entry keeps the imported modules left to visit
+    std::vector<std::pair<Module::Ptr, std::vector<Module::Ptr> > > stack;
+    visited.insert(module->path());
+    stack.push_back(std::make_pair(module, scanImported(module)));
+
+    while ( !stack.empty() ){
+        std::vector<Module::Ptr>& pending = stack.back().second;
+        if ( pending.empty() ){
+            result.push_back(stack.back().first);
+            stack.pop_back();
+            continue;
+        }
+
+        Module::Ptr next = pending.back();
+        pending.pop_back();
+        if ( visited.insert(next->path()).second )
+            stack.push_back(std::make_pair(next, scanImported(next)));
+    }
+
+    return result;
+}
+
+std::vector<Module::Ptr> Compiler::scanImportedModules(const Module::Ptr &module){
+    std::vector<Module::Ptr> result;
+    const std::string& importId = module->context()->importId.data();
+
+    for ( auto it = module->fileModules().begin(); it != module->fileModules().end(); ++it ){
+        std::string filePath = Path::join(module->path(), *it + ".lv");
+        if ( !Path::isFile(filePath) )
+            continue;
+
+        ImportScanner::Result scan = ImportScanner::scan(m_d->config.m_fileIO->readFromFile(filePath), *it);
+        for ( const ImportScanner::Import& imp : scan.imports ){
+            std::string importKey = imp.uri;
+            if ( imp.isRelative ){
+                Package::Ptr package = module->context()->packageUnwrapped();
+                if ( !package || package->nameScope() == "." )
+                    continue;
+                importKey = package->nameScope() + (imp.uri == "." ? "" : imp.uri);
+            }
+            if ( importKey == importId )
+                continue;
+
+            Module::Ptr importedModule;
+            auto loadedIt = m_d->loadedModules.find(importKey);
+            if ( loadedIt != m_d->loadedModules.end() ){
+                importedModule = loadedIt->second->module();
+            } else {
+                try{
+                    importedModule = m_d->packageGraph->loadModule(importKey, module);
+                } catch ( lv::Exception& e ){
+                    vlog_if(compilerLog, Verbose) << "Compiler: Skipping unresolved import '" << importKey << "' in '" << filePath << "': " << e.message();
+                }
+            }
+
+            if ( importedModule )
+                result.push_back(importedModule);
+        }
+    }
+    return result;
+}
+
 const std::vector<std::string> &Compiler::packageImportPaths() const{
     return m_d->packageGraph->packageImportPaths();
 }
@@ -470,6 +659,96 @@ void Compiler::setPackageImportPaths(const std::vector<std::string> &paths){
     m_d->packageGraph->setPackageImportPaths(paths);
 }
 
+/**
+ * \brief Sets the package import paths, collecting the import folder of \p packagePath and of
+ * each package above it.
+ */
+void Compiler::initializePackageImportPaths(const std::string &packagePath){
+    std::string current = packagePath;
+    std::vector<std::string> importPaths;
+    while ( Path::exists(current) ){
+        auto importPath = Path::join(current, importLocalPath());
+        if ( Package::existsIn(current) && Path::exists(importPath) ){
+            importPaths.push_back(importPath);
+        }
+        if ( Path::rootPath(current) == current ){
+            break;
+        }
+        current = Path::parent(current);
+    }
+    setPackageImportPaths(importPaths);
+}
+
+/**
+ * \brief Drops cached state related to \p path, so the next compile reads it again.
+ *
+ * Removes loaded modules that contain or are contained by \p path, and every loaded module that
+ * imports them directly or indirectly, together with the cached file stats, resolved paths and
+ * package lookups.
+ */
+void Compiler::invalidate(const std::string &path){
+    auto isUnder = [](const std::string& p, const std::string& root){
+        return p.compare(0, root.size(), root) == 0 &&
+              (p.size() == root.size() || p[root.size()] == '/' || p[root.size()] == Path::separator);
+    };
+
+    std::set<ElementsModule*> dropped;
+    for ( auto it = m_d->loadedModules.begin(); it != m_d->loadedModules.end(); ++it ){
+        const std::string& modulePath = it->second->module()->path();
+        if ( isUnder(modulePath, path) || isUnder(path, modulePath) )
+            dropped.insert(it->second.get());
+    }
+
+    // importers keep resolved imports to the dropped modules, so drop them as well
+    bool droppedImporter = !dropped.empty();
+    while ( droppedImporter ){
+        droppedImporter = false;
+        for ( auto it = m_d->loadedModules.begin(); it != m_d->loadedModules.end(); ++it ){
+            if ( dropped.find(it->second.get()) != dropped.end() || !importsAnyOf(it->second, dropped) )
+                continue;
+            dropped.insert(it->second.get());
+            droppedImporter = true;
+        }
+    }
+
+    for ( auto it = m_d->loadedModules.begin(); it != m_d->loadedModules.end(); ){
+        if ( dropped.find(it->second.get()) != dropped.end() ){
+            m_d->loadedModulesByPath.erase(it->second->module()->path());
+            it = m_d->loadedModules.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for ( auto it = m_d->builtModules.begin(); it != m_d->builtModules.end(); ){
+        if ( isUnder(*it, path) || isUnder(path, *it) )
+            it = m_d->builtModules.erase(it);
+        else
+            ++it;
+    }
+
+    if ( m_d->fileStatCache )
+        m_d->fileStatCache->invalidateTree(path);
+    Path::invalidateResolveCache(path);
+    m_d->packageGraph->clearPackageCache();
+}
+
+/**
+ * \brief Marks the module at \p modulePath as having an up to date build output
+ *
+ * Used when the module was compiled by another compiler, like a different worker of the same build.
+ * Importers then load the module from its descriptor instead of compiling it again.
+ */
+void Compiler::markModuleBuilt(const std::string &modulePath){
+    m_d->builtModules.insert(Path::resolveCached(modulePath));
+}
+
+bool Compiler::isModuleBuilt(const std::string &modulePath) const{
+    if ( m_d->builtModules.empty() )
+        return false;
+    return m_d->builtModules.find(Path::resolveCached(modulePath)) != m_d->builtModules.end();
+}
+
 std::shared_ptr<ElementsModule> Compiler::findLoadedModuleByPath(const std::string &path) const{
     auto it = m_d->loadedModulesByPath.find(path);
     if ( it != m_d->loadedModulesByPath.end() ){
@@ -487,6 +766,8 @@ Compiler::Config::Config(bool fileOutput, const std::string &outputExtension, Fi
     , m_enableComponentMetaInfo(true)
     , m_allowUnresolved(true)
     , m_outputTarget(JS)
+    , m_fileStatCache(false)
+    , m_fileStatWatch(false)
 {
     if ( m_fileOutput && !m_fileIO ){
         THROW_EXCEPTION(lv::Exception, "File reader & writer not defined for compiler.", lv::Exception::toCode("~FileIO"));
@@ -557,6 +838,12 @@ void Compiler::Config::initialize(const MLNode &config){
         else if ( t == "JS" ) m_outputTarget = JS;
         else m_outputTarget = JS_DTS;
     }
+    if ( config.hasKey("fileStatCache") ){
+        m_fileStatCache = config["fileStatCache"].asBool();
+    }
+    if ( config.hasKey("watchFiles") ){
+        m_fileStatWatch = config["watchFiles"].asBool();
+    }
 }
 
 }} // namespace lv, el
@@ -26,6 +26,7 @@
 namespace lv{
 
 class MLNode;
+class FileStatCache;
 
 namespace el{
 
@@ -66,6 +67,7 @@ public:
         void initialize(const MLNode& config);
         void allowUnresolvedTypes(bool allow){ m_allowUnresolved = allow; }
         void outputTarget(OutputTarget target) { m_outputTarget = target; }
+        void enableFileStatCache(bool enable, bool watch = false){ m_fileStatCache = enable; m_fileStatWatch = watch; }
     private:
         bool                   m_fileOutput;
         bool                   m_fileOutputOnlyOnModified;
@@ -82,6 +84,8 @@ public:
         bool                   m_enableComponentMetaInfo;
         bool                   m_allowUnresolved;
         OutputTarget           m_outputTarget;
+        bool                   m_fileStatCache;
+        bool                   m_fileStatWatch;
     };
 
     class TargetResult {
@@ -97,6 +101,7 @@ public:
     static Ptr create(const Config& config = Config(), PackageGraph* pg = nullptr);
 
     FileIOInterface* fileIO() const;
+    FileStatCache* fileStatCache() const;
 
     const std::list<std::string>& importPaths() const;
 
@@ -122,14 +127,26 @@ public:
     static std::shared_ptr<ElementsModule> compileModule(Compiler::Ptr compiler, const std::string& path, Engine* engine = nullptr);
     static std::vector<std::shared_ptr<ElementsModule> > compilePackage(Compiler::Ptr compiler, const std::string& path, Engine* engine = nullptr);
     static std::shared_ptr<ElementsModule> createAndResolveImportedModule(Compiler::Ptr compiler, const std::string& path, const Module::Ptr& requstingModule, Engine* engine = nullptr);
+    static std::vector<Module::Ptr> scanModuleImports(
+        Compiler::Ptr compiler,
+        const Module::Ptr& module,
+        std::map<std::string, std::vector<Module::Ptr> >* imports = nullptr
+    );
 
     const std::vector<std::string> &packageImportPaths() const;
     void setPackageImportPaths(const std::vector<std::string>& paths);
+    void initializePackageImportPaths(const std::string& packagePath);
+
+    void invalidate(const std::string& path);
+
+    void markModuleBuilt(const std::string& modulePath);
+    bool isModuleBuilt(const std::string& modulePath) const;
 
     std::shared_ptr<ElementsModule> findLoadedModuleByPath(const std::string& path) const;
 
 private:
     std::string createModuleBuildPath(const Module::Ptr& plugin);
+    std::vector<Module::Ptr> scanImportedModules(const Module::Ptr& module);
 
     Compiler(const Config& config, PackageGraph *pg);
 
@@ -16,15 +16,29 @@
 #include "elementsmodule.h"
 #include "modulefile.h"
 #include "live/modulecontext.h"
+#include "live/package.h"
 #include "live/exception.h"
 #include "live/fileio.h"
 #include "live/path.h"
+#include "live/mappedfile.h"
+#include "live/filestatcache.h"
 #include "live/visuallog.h"
+#include "live/tracer.h"
 #include "live/mlnodetojson.h"
 #include "live/elements/compiler/tracepointexception.h"
+#include "memoryaccounting.h"
+
+#include <unordered_map>
+#include <future>
 
 namespace lv{ namespace el{
 
+namespace{
+
+VisualLog::Handle globalLog("global");
+
+} // namespace
+
 /**
  * \class ElementsModule
  * \brief Container for module functionality on the Elements side.
@@ -39,12 +53,17 @@ public:
     Compiler::WeakPtr compiler;
     Engine*           engine;
     std::map<std::string, ModuleFile*> fileModules;
+    std::unordered_map<std::string, ModuleFile*> fileModulesByPath;
     std::list<ModuleLibrary*>          libraries;
 
     std::string            buildLocation;
     ElementsModule::Status status;
 
     ModuleDescriptor::Ptr  descriptor;
+
+    PackageGraph::TopologicalOrder<ModuleFile*> fileOrder;
+
+    std::map<std::pair<std::string, bool>, std::string> importPathPrefixes;
 };
 
 
@@ -86,6 +105,7 @@ ElementsModule::Ptr ElementsModule::create(Module::Ptr module, Compiler::Ptr com
 }
 
 ElementsModule::Ptr ElementsModule::createImpl(Module::Ptr module, Compiler::Ptr compiler, Engine *engine){
+    LV_TRACE_SCOPE_DETAIL("module", "ElementsModule::create", module->path());
 
     ModuleDescriptor::Ptr descriptor;
 
@@ -93,15 +113,35 @@ ElementsModule::Ptr ElementsModule::createImpl(Module::Ptr module, Compiler::Ptr
     if ( !package ){
         THROW_EXCEPTION(lv::Exception, Utf8("Assertion: Package null for module: \'%\'").format(module->path()), Exception::toCode("~NullPtr"));
     }
-    if ( !package->release().empty() ){
+    if ( !package->release().empty() || compiler->isModuleBuilt(module->path()) ){
         auto buildLocation = compiler->moduleBuildPath(module);
-        if ( Path::exists(Path::join(buildLocation, ModuleDescriptor::buildFileName) ) ){
-            std::string descriptorContent = compiler->fileIO()->readFromFile(
-                Path::join(buildLocation, ModuleDescriptor::buildFileName)
-            );
+        std::string descriptorPath = Path::join(buildLocation, ModuleDescriptor::buildFileName);
+        std::string binaryDescriptorPath = Path::join(buildLocation, ModuleDescriptor::binaryBuildFileName);
+        bool hasDescriptor = Path::exists(descriptorPath);
+
+        // prefer the binary descriptor, unless the json one was written after it
+        if ( Path::isFile(binaryDescriptorPath) &&
+             (!hasDescriptor || Path::lastModified(descriptorPath) <= Path::lastModified(binaryDescriptorPath)) )
+        {
+            try{
+                // map the file only when it was written to disk, other interfaces are read through
+                if ( dynamic_cast<FileIO*>(compiler->fileIO()) ){
+                    MappedFile::Ptr mapped = MappedFile::open(binaryDescriptorPath);
+                    descriptor = ModuleDescriptor::createFromBinary(mapped->data(), mapped->size());
+                } else {
+                    std::string content = compiler->fileIO()->readFromFile(binaryDescriptorPath);
+                    descriptor = ModuleDescriptor::createFromBinary(content.data(), content.size());
+                }
+            } catch ( lv::Exception& e ){
+                vlog("lvcompiler").w() << "ElementsModule: Failed to load binary descriptor \'" << binaryDescriptorPath << "\': " << e.message();
+            }
+        }
+
+        if ( !descriptor && hasDescriptor ){
+            std::string descriptorContent = compiler->fileIO()->readFromFile(descriptorPath);
 
             MLNode descriptorNode;
-            ml::fromJson(descriptorContent, descriptorNode);
+            ml::fromJsonInsitu(descriptorContent, descriptorNode);
 
             descriptor = ModuleDescriptor::createFromMlNode(descriptorNode);
         }
@@ -133,6 +173,15 @@ ElementsModule::Ptr ElementsModule::createImpl(Module::Ptr module, Compiler::Ptr
 }
 
 
+PackageGraph::TopologicalOrder<ModuleFile *> &ElementsModule::fileOrder(){
+    return m_d->fileOrder;
+}
+
+void ElementsModule::addModuleFile(const std::string &name, ModuleFile *mf){
+    m_d->fileModules[name] = mf;
+    m_d->fileModulesByPath[mf->filePath()] = mf;
+}
+
 void ElementsModule::initializeLibraries(const std::list<std::string> &libs){
 #ifdef BUILD_ELEMENTS_ENGINE
 //    for ( auto it = libs.begin(); it != libs.end(); ++it ){
@@ -153,7 +202,7 @@ ModuleFile *ElementsModule::loadModuleFile(ElementsModule::Ptr &epl, const std::
     }
 
     ModuleFile* mf = ModuleFile::createFromDescriptor(epl.get(), name, mfd);
-    epl->m_d->fileModules[name] = mf;
+    epl->addModuleFile(name, mf);
 
     std::string currentUriName = epl->module()->context()->importId.data() + "." + name;
 
@@ -208,7 +257,13 @@ ModuleFile *ElementsModule::parseModuleFile(ElementsModule::Ptr &epl, const std:
         );
     }
 
-    std::string content = compiler->fileIO()->readFromFile(filePath);
+    MemoryAccounting::FileScope memoryScope(filePath);
+
+    std::string content;
+    {
+        LV_TRACE_SCOPE_DETAIL("io", "read", filePath);
+        content = compiler->fileIO()->readFromFile(filePath);
+    }
 
     std::string componentName = name;
     size_t i = componentName.find(".lv");
@@ -216,11 +271,19 @@ ModuleFile *ElementsModule::parseModuleFile(ElementsModule::Ptr &epl, const std:
         componentName = name.substr(0, i);
     }
 
-    LanguageParser::AST* ast = compiler->parser()->parse(content);
-    ProgramNode* pn = compiler->parseProgramNodes(filePath, componentName, ast);
+    LanguageParser::AST* ast = nullptr;
+    {
+        LV_TRACE_SCOPE_DETAIL("compile", "parse", filePath);
+        ast = compiler->parser()->parse(content);
+    }
+    ProgramNode* pn = nullptr;
+    {
+        LV_TRACE_SCOPE_DETAIL("compile", "visit", filePath);
+        pn = compiler->parseProgramNodes(filePath, componentName, ast);
+    }
 
     ModuleFile* mf = ModuleFile::createFromProgramNode(epl.get(), name, content, pn, ast);
-    epl->m_d->fileModules[name] = mf;
+    epl->addModuleFile(name, mf);
     epl->m_d->descriptor->addModuleFileDescriptor(mf->descriptor());
 
     std::string currentUriName = epl->module()->context()->importId.data() + "." + name;
@@ -288,11 +351,9 @@ ModuleFile *ElementsModule::findModuleFileByName(const std::string &name) const{
 }
 
 ModuleFile *ElementsModule::moduleFileBypath(const std::string &path) const{
-    std::string pathNormalized = Path::resolve(path);
-    for ( auto it = m_d->fileModules.begin(); it != m_d->fileModules.end(); ++it ){
-        ModuleFile* mf = it->second;
-        if ( mf->filePath() == pathNormalized )
-            return mf;
+    auto it = m_d->fileModulesByPath.find(Path::resolveCached(path));
+    if ( it != m_d->fileModulesByPath.end() ){
+        return it->second;
     }
     return nullptr;
 }
@@ -305,14 +366,34 @@ void ElementsModule::compile(){
     if ( m_d->status == ElementsModule::Compiled || m_d->status == ElementsModule::Compiling )
         return;
 
+    LV_TRACE_SCOPE_DETAIL("module", "ElementsModule::compile", m_d->module->path());
+
     // resolve types
     if ( m_d->status != ElementsModule::Resolved && m_d->status != ElementsModule::Parsed){
+        LV_TRACE_SCOPE_DETAIL("compile", "resolve", m_d->module->path());
         for ( auto it = m_d->fileModules.begin(); it != m_d->fileModules.end(); ++it ){
             it->second->resolveTypes();
         }
         m_d->status = ElementsModule::Resolved;
     }
 
+    // sync assets while the module files are being compiled
+
+    std::future<void> assetSync;
+    auto assets = m_d->module->assets();
+    if ( !assets.empty() ){
+        std::string modulePath = m_d->module->path();
+        std::string moduleBuildPath = compiler()->moduleBuildPath(m_d->module);
+        FileStatCache* fileStatCache = FileStatCache::active();
+        assetSync = std::async(std::launch::async, [assets, modulePath, moduleBuildPath, fileStatCache](){
+            FileStatCache::Scope fileStatScope(fileStatCache);
+            LV_TRACE_SCOPE_DETAIL("io", "sync assets", modulePath);
+            for ( auto it = assets.begin(); it != assets.end(); ++it ){
+                Path::syncFile(Path::join(modulePath, *it), Path::join(moduleBuildPath, *it));
+            }
+        });
+    }
+
     // compile dependencies
     for ( auto it = m_d->fileModules.begin(); it != m_d->fileModules.end(); ++it ){
         ModuleFile* mf = it->second;
@@ -330,21 +411,15 @@ void ElementsModule::compile(){
         it->second->compile();
     }
 
-    auto assets = m_d->module->assets();
-    std::string moduleBuildPath = compiler()->moduleBuildPath(m_d->module);
-
-    for ( auto it = assets.begin(); it != assets.end(); ++it ){
-        std::string assetPath = Path::join(m_d->module->path(), *it);
-        std::string resultPath = Path::join(moduleBuildPath, *it);
-        if (Path::exists(resultPath))
-            Path::remove(resultPath);
-        Path::copyFile(assetPath, resultPath, Path::OverwriteExisting);
+    if ( assetSync.valid() ){
+        LV_TRACE_SCOPE("io", "wait for assets");
+        assetSync.get();
     }
 
+    LV_TRACE_SCOPE_DETAIL("io", "save descriptor", m_d->buildLocation);
+
     // write compile info
     MLNode descriptorData = m_d->descriptor->toMLNode();
-    std::string descriptorContent;
-    ml::toJson(descriptorData, descriptorContent);
 
     std::string descriptorPath = Path::join(m_d->buildLocation, ModuleDescriptor::buildFileName);
 
@@ -353,9 +428,16 @@ void ElementsModule::compile(){
         THROW_EXCEPTION(lv::Exception, Utf8("Assertion: ElementsModule: Compiler pointer has been released."), Exception::toCode("~Compiler"));
     }
 
-    vlog().v() << "ElementsModule: Saving descriptor:" << descriptorPath;
+    vlog_if(globalLog, Verbose) << "ElementsModule: Saving descriptor:" << descriptorPath;
 
-    compiler->fileIO()->writeToFile(descriptorPath, descriptorContent);
+    compiler->fileIO()->writeJsonToFile(descriptorPath, descriptorData);
+
+    // replaced atomically, other processes may have the previous file mapped
+    std::string descriptorBinary;
+    m_d->descriptor->toBinary(descriptorBinary);
+    compiler->fileIO()->replaceFile(
+        Path::join(m_d->buildLocation, ModuleDescriptor::binaryBuildFileName), descriptorBinary.data(), descriptorBinary.size()
+    );
     
     m_d->status = ElementsModule::Compiled;
 }
@@ -384,6 +466,72 @@ ModuleFile *ElementsModule::moduleFileByName(const std::string &fileName) const{
     return nullptr;
 }
 
+/**
+ * \brief Returns the path prefix used by files in this module to import files from \p imported
+ *
+ * Relative imports go up from this module to the package root and down to the imported module,
+ * while absolute imports start from the imported package build path. The prefix only depends on the
+ * two modules, so it's computed once per imported module and appended to each imported file name.
+ * Prefixes are keyed by the imported module's import id, so a module that's reloaded after being
+ * invalidated gets the prefix of its own location, not the one of a previous module at the same address.
+ */
+const std::string &ElementsModule::importPathPrefix(ElementsModule *imported, bool isRelative){
+    const Module::Ptr& importedModule = imported->module();
+
+    auto key = std::make_pair(importedModule->context()->importId.data(), isRelative);
+    auto it = m_d->importPathPrefixes.find(key);
+    if ( it != m_d->importPathPrefixes.end() )
+        return it->second;
+
+    Package::Ptr importedPkg = importedModule->context()->packageUnwrapped();
+    if ( !importedPkg ){
+        THROW_EXCEPTION(Exception,
+            Utf8("ElementsModule::importPathPrefix (%): Package expired or unset for imported module (path %, importId %).")
+                .format(isRelative ? "relative" : "absolute", importedModule->path(), importedModule->context()->importId.data()),
+            Exception::toCode("~NullPtr"));
+    }
+
+    Utf8 packageName = importedPkg->nameScopeAsPath();
+    Utf8 importedImportId = importedModule->context()->importId;
+    Utf8 packageToImportedName = importedImportId.length() > packageName.length()
+        ? importedImportId.substr(packageName.length() + 1, std::string::npos)
+        : "";
+    std::string packageToImported = Utf8::join(packageToImportedName.split("."), "/").data();
+
+    std::string prefix;
+    if ( isRelative ){
+        // this plugin to package
+        Utf8 currentImportId = m_d->module->context()->importId;
+        Utf8 packageToPluginName = currentImportId.length() > packageName.length()
+            ? currentImportId.substr(packageName.length() + 1, std::string::npos)
+            : "";
+
+        std::vector<Utf8> parts = packageToPluginName.split(".");
+        if ( parts.size() > 0 ){
+            for ( size_t i = 0; i < parts.size(); ++i ){
+                if ( !prefix.empty() )
+                    prefix += '/';
+                prefix += "..";
+            }
+        } else {
+            prefix = ".";
+        }
+
+        // package to imported plugin
+        prefix += "/" + packageToImported;
+        if ( !packageToImported.empty() )
+            prefix += "/";
+    } else {
+        std::string configPackageBuildPath = compiler()->packageBuildPath();
+        prefix = packageName.data() + (configPackageBuildPath.empty() ? "" : "/" + configPackageBuildPath);
+        if ( !packageToImported.empty() )
+            prefix += "/" + packageToImported;
+        prefix += "/";
+    }
+
+    return m_d->importPathPrefixes.emplace(key, prefix).first->second;
+}
+
 const std::string &ElementsModule::buildLocation() const{
     return m_d->buildLocation;
 }
@@ -392,8 +540,20 @@ ElementsModule::Status ElementsModule::status() const{
     return m_d->status;
 }
 
+const std::map<std::string, ModuleFile *> &ElementsModule::fileExports() const{
+    return m_d->fileModules;
+}
+
 const std::list<ModuleLibrary *> &ElementsModule::libraryModules() const{
     return m_d->libraries;
 }
 
+/**
+ * \brief Returns the files that depend on, or are dependencies of other files in this module, with
+ * each dependency placed before its dependents
+ */
+const std::vector<ModuleFile *> &ElementsModule::fileDependencyOrder() const{
+    return m_d->fileOrder.nodes();
+}
+
 }} // namespace lv, el
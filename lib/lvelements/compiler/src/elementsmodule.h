@@ -20,6 +20,7 @@
 #include "live/elements/compiler/compiler.h"
 #include "live/elements/compiler/languagedescriptors.h"
 #include "live/module.h"
+#include "live/packagegraph.h"
 
 #include <memory>
 
@@ -72,8 +73,14 @@ public:
 
     const std::map<std::string, ModuleFile*>& fileExports() const;
     const std::list<ModuleLibrary*>& libraryModules() const;
+    const std::vector<ModuleFile*>& fileDependencyOrder() const;
 
 private:
+    friend class ModuleFile;
+
+    PackageGraph::TopologicalOrder<ModuleFile*>& fileOrder();
+    void addModuleFile(const std::string& name, ModuleFile* mf);
+    const std::string& importPathPrefix(ElementsModule* imported, bool isRelative);
     void initializeLibraries(const std::list<std::string>& libs);
 
     static ModuleFile *loadModuleFile(ElementsModule::Ptr& epl, const std::string& name, const ModuleFileDescriptor::Ptr& mfd);
@@ -14,7 +14,18 @@
 ****************************************************************************/
 
 #include "elementssections_p.h"
+#include "memoryaccounting.h"
 
 namespace lv{ namespace el{
 
+void *InsertionSection::operator new(size_t size){
+    MemoryAccounting::add(MemoryAccounting::Sections, size);
+    return ::operator new(size);
+}
+
+void InsertionSection::operator delete(void *p, size_t size){
+    MemoryAccounting::remove(MemoryAccounting::Sections, size);
+    ::operator delete(p);
+}
+
 }} // namespace lv, el
@@ -36,6 +36,9 @@ public:
     InsertionSection(): type(Insertion){}
     virtual ~InsertionSection(){}
 
+    static void* operator new(size_t size);
+    static void operator delete(void* p, size_t size);
+
     virtual std::string toString() const{ return content + "\n"; }
     virtual void flatten(const std::string&, std::vector<std::string>& parts){
         if ( content.size() > 0 )
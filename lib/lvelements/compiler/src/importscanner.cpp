@@ -0,0 +1,331 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 Dinu SV.
+** This file is part of Livekeys Application.
+**
+** GNU Lesser General Public License Usage
+** This file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+****************************************************************************/
+
+#include "importscanner.h"
+
+#include <cstring>
+
+/**
+ * \class lv::el::ImportScanner
+ * \brief Finds module imports and exported components without parsing the file
+ *
+ * The scanner tokenizes the file just enough to skip comments, strings, tagged and template strings
+ * and regular expressions, and tracks bracket depth. Only statements at the top level are read:
+ * elements imports, and named component and instance declarations. Javascript imports and anonymous
+ * components are skipped.
+ *
+ * This is meant for discovering the module graph ahead of the full parse, which remains the reference
+ * for both imports and exports.
+ *
+ * \ingroup lvelementscompiler
+ */
+
+namespace lv{ namespace el{
+
+namespace{
+
+bool isIdentifierStart(char c){
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == '$' || static_cast<unsigned char>(c) >= 0x80;
+}
+
+bool isIdentifierChar(char c){
+    return isIdentifierStart(c) || (c >= '0' && c <= '9');
+}
+
+bool isImportSegmentChar(char c){
+    return isIdentifierChar(c) || c == '@' || c == '-';
+}
+
+/// Keywords after which a '/' starts a regular expression instead of a division
+bool isRegexPrefixKeyword(const char* start, size_t length){
+    static const char* keywords[] = {
+        "return", "typeof", "instanceof", "case", "do", "else", "in", "of", "new", "delete", "void", "throw", "yield", "await"
+    };
+    for ( const char* keyword : keywords ){
+        if ( std::strlen(keyword) == length && std::strncmp(keyword, start, length) == 0 )
+            return true;
+    }
+    return false;
+}
+
+class Scanner{
+
+public:
+    enum Token{
+        End,
+        Identifier,
+        Literal,
+        Punctuation
+    };
+
+public:
+    Scanner(const std::string& c)
+        : content(c), pos(0), tokenStart(0), regexAllowed(true){}
+
+    char peek(size_t offset = 0) const{
+        return pos + offset < content.size() ? content[pos + offset] : '\0';
+    }
+
+    void skipSpaceAndComments(){
+        while ( pos < content.size() ){
+            char c = content[pos];
+            if ( c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v' ){
+                ++pos;
+            } else if ( c == '/' && peek(1) == '/' ){
+                size_t end = content.find('\n', pos + 2);
+                pos = end == std::string::npos ? content.size() : end + 1;
+            } else if ( c == '/' && peek(1) == '*' ){
+                size_t end = content.find("*/", pos + 2);
+                pos = end == std::string::npos ? content.size() : end + 2;
+            } else {
+                break;
+            }
+        }
+    }
+
+    /// Reads the next token, skipping whitespace and comments. Strings, templates and regexes are single tokens.
+    Token next(){
+        skipSpaceAndComments();
+        tokenStart = pos;
+        if ( pos >= content.size() )
+            return End;
+
+        char c = content[pos];
+        if ( isIdentifierStart(c) ){
+            while ( pos < content.size() && isIdentifierChar(content[pos]) )
+                ++pos;
+            regexAllowed = isRegexPrefixKeyword(content.data() + tokenStart, pos - tokenStart);
+            return Identifier;
+        } else if ( c >= '0' && c <= '9' ){
+            while ( pos < content.size() && (isIdentifierChar(content[pos]) || content[pos] == '.') )
+                ++pos;
+            regexAllowed = false;
+            return Literal;
+        } else if ( c == '"' || c == '\'' ){
+            skipString(c);
+            regexAllowed = false;
+            return Literal;
+        } else if ( c == '`' ){
+            skipTemplate();
+            regexAllowed = false;
+            return Literal;
+        } else if ( c == '/' && regexAllowed ){
+            skipRegex();
+            regexAllowed = false;
+            return Literal;
+        }
+
+        ++pos;
+        regexAllowed = c != ')' && c != ']';
+        return Punctuation;
+    }
+
+    /// Skips tokens up to and including the bracket that closes an already opened one
+    void skipBalanced(){
+        int depth = 1;
+        Token t;
+        while ( (t = next()) != End ){
+            if ( t != Punctuation )
+                continue;
+            char c = content[tokenStart];
+            if ( c == '{' || c == '(' || c == '[' ){
+                ++depth;
+            } else if ( c == '}' || c == ')' || c == ']' ){
+                if ( --depth == 0 )
+                    return;
+            }
+        }
+    }
+
+    void skipString(char quote){
+        ++pos;
+        while ( pos < content.size() ){
+            char c = content[pos];
+            if ( c == '\\' ){
+                pos += 2;
+            } else if ( c == quote || c == '\n' ){
+                ++pos;
+                return;
+            } else {
+                ++pos;
+            }
+        }
+    }
+
+    /// Skips template and tagged strings, including the triple quoted form and ${} expressions
+    void skipTemplate(){
+        if ( content.compare(pos, 3, "```") == 0 ){
+            size_t end = content.find("```", pos + 3);
+            pos = end == std::string::npos ? content.size() : end + 3;
+            return;
+        }
+
+        ++pos;
+        while ( pos < content.size() ){
+            char c = content[pos];
+            if ( c == '\\' ){
+                pos += 2;
+            } else if ( c == '`' ){
+                ++pos;
+                return;
+            } else if ( c == '$' && peek(1) == '{' ){
+                pos += 2;
+                regexAllowed = true;
+                skipBalanced();
+            } else {
+                ++pos;
+            }
+        }
+    }
+
+    void skipRegex(){
+        ++pos;
+        bool inClass = false;
+        while ( pos < content.size() ){
+            char c = content[pos];
+            if ( c == '\\' ){
+                pos += 2;
+                continue;
+            }
+            ++pos;
+            if ( c == '\n' ){
+                return;
+            } else if ( c == '[' ){
+                inClass = true;
+            } else if ( c == ']' ){
+                inClass = false;
+            } else if ( c == '/' && !inClass ){
+                while ( pos < content.size() && isIdentifierChar(content[pos]) )
+                    ++pos;
+                return;
+            }
+        }
+    }
+
+    /// Returns the identifier at the current position without consuming it
+    std::string peekIdentifier(){
+        skipSpaceAndComments();
+        size_t end = pos;
+        if ( end < content.size() && isIdentifierStart(content[end]) ){
+            while ( end < content.size() && isIdentifierChar(content[end]) )
+                ++end;
+        }
+        return content.substr(pos, end - pos);
+    }
+
+    std::string readIdentifier(){
+        std::string result = peekIdentifier();
+        pos += result.size();
+        regexAllowed = false;
+        return result;
+    }
+
+    /// Reads an elements import path (e.g. '.', '.module', '@scope.package.module'), or returns false for javascript imports
+    bool readImport(ImportScanner::Import& imp){
+        skipSpaceAndComments();
+        if ( peek() == '.' ){
+            imp.isRelative = true;
+            imp.uri = ".";
+            ++pos;
+        }
+
+        bool firstSegment = true;
+        while ( isImportSegmentChar(peek()) ){
+            size_t start = pos;
+            while ( isImportSegmentChar(peek()) )
+                ++pos;
+            if ( !firstSegment )
+                imp.uri += '.';
+            imp.uri.append(content, start, pos - start);
+            firstSegment = false;
+
+            if ( peek() == '.' && isImportSegmentChar(peek(1)) )
+                ++pos;
+            else
+                break;
+        }
+        regexAllowed = false;
+
+        if ( imp.uri.empty() )
+            return false;
+
+        std::string following = peekIdentifier();
+        if ( following == "as" ){
+            pos += following.size();
+            imp.as = readIdentifier();
+        } else if ( following == "from" || peek() == ',' ){
+            return false;
+        }
+        return true;
+    }
+
+    const std::string& content;
+    size_t pos;
+    size_t tokenStart;
+    bool   regexAllowed;
+};
+
+} // namespace
+
+/**
+ * \brief Scans \p content for top level imports and exports
+ *
+ * Components and instances named 'default' are exported as \p componentName, like in the full parse.
+ */
+ImportScanner::Result ImportScanner::scan(const std::string &content, const std::string &componentName){
+    Result result;
+    Scanner scanner(content);
+
+    int depth = 0;
+    bool afterDot = false;
+
+    Scanner::Token t;
+    while ( (t = scanner.next()) != Scanner::End ){
+        if ( t == Scanner::Punctuation ){
+            char c = content[scanner.tokenStart];
+            if ( c == '{' || c == '(' || c == '[' ){
+                ++depth;
+            } else if ( (c == '}' || c == ')' || c == ']') && depth > 0 ){
+                --depth;
+            }
+            afterDot = c == '.';
+            continue;
+        }
+
+        if ( t == Scanner::Identifier && depth == 0 && !afterDot ){
+            size_t length = scanner.pos - scanner.tokenStart;
+            const char* token = content.data() + scanner.tokenStart;
+
+            if ( length == 6 && std::strncmp(token, "import", 6) == 0 ){
+                ImportScanner::Import imp;
+                if ( scanner.readImport(imp) )
+                    result.imports.push_back(imp);
+            } else if ( length == 9 && std::strncmp(token, "component", 9) == 0 ){
+                std::string name = scanner.readIdentifier();
+                if ( !name.empty() )
+                    result.exports.push_back(ExportDescriptor(name == "default" ? componentName : name, ExportDescriptor::Component));
+            } else if ( length == 8 && std::strncmp(token, "instance", 8) == 0 ){
+                std::string name = scanner.readIdentifier();
+                if ( !name.empty() )
+                    result.exports.push_back(ExportDescriptor(name == "default" ? componentName : name, ExportDescriptor::Element));
+            }
+        }
+        afterDot = false;
+    }
+
+    return result;
+}
+
+}} // namespace lv, el
@@ -0,0 +1,62 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 Dinu SV.
+** This file is part of Livekeys Application.
+**
+** GNU Lesser General Public License Usage
+** This file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+****************************************************************************/
+
+#ifndef LVIMPORTSCANNER_H
+#define LVIMPORTSCANNER_H
+
+#include "live/elements/compiler/lvelcompilerglobal.h"
+#include "live/elements/compiler/languagedescriptors.h"
+
+#include <string>
+#include <vector>
+
+namespace lv{ namespace el{
+
+class LV_ELEMENTS_COMPILER_EXPORT ImportScanner{
+
+public:
+    /**
+     * \class lv::el::ImportScanner::Import
+     * \brief Module import found by the scanner, with the same uri format as ImportNode::path
+     */
+    class LV_ELEMENTS_COMPILER_EXPORT Import{
+    public:
+        Import() : isRelative(false){}
+
+        std::string uri;
+        std::string as;
+        bool        isRelative;
+    };
+
+    /**
+     * \class lv::el::ImportScanner::Result
+     * \brief Imports and exports found in a single file
+     */
+    class LV_ELEMENTS_COMPILER_EXPORT Result{
+    public:
+        std::vector<Import>           imports;
+        std::vector<ExportDescriptor> exports;
+    };
+
+public:
+    static Result scan(const std::string& content, const std::string& componentName);
+
+private:
+    ImportScanner();
+};
+
+}} // namespace lv, el
+
+#endif // LVIMPORTSCANNER_H
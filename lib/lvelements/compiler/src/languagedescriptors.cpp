@@ -15,9 +15,128 @@
 
 #include "languagedescriptors.h"
 #include <algorithm>
+#include <cstring>
+#include <cstdint>
 
 namespace lv{ namespace el{
 
+namespace{
+
+/*
+ * Binary module descriptor layout, all integers are 32 bit in native byte order:
+ *
+ *   BinaryHeader
+ *   BinaryFileRecord[fileCount]
+ *   BinaryExportRecord[exportCount]
+ *   BinaryDependencyRecord[dependencyCount]
+ *   BinaryLibraryRecord[libraryCount]
+ *   string table (stringTableSize bytes)
+ *
+ * Strings are stored as offset and length into the string table. Each file record
+ * points to a contiguous range of export and dependency records.
+ */
+
+const char     binaryMagic[4] = {'L', 'V', 'M', 'D'};
+const uint32_t binaryVersion  = 1;
+
+class BinaryString{
+public:
+    uint32_t offset;
+    uint32_t length;
+};
+
+class BinaryHeader{
+public:
+    char         magic[4];
+    uint32_t     version;
+    BinaryString uri;
+    uint32_t     fileCount;
+    uint32_t     exportCount;
+    uint32_t     dependencyCount;
+    uint32_t     libraryCount;
+    uint32_t     stringTableSize;
+};
+
+class BinaryFileRecord{
+public:
+    BinaryString fileName;
+    uint32_t     firstExport;
+    uint32_t     exportCount;
+    uint32_t     firstDependency;
+    uint32_t     dependencyCount;
+};
+
+class BinaryExportRecord{
+public:
+    BinaryString name;
+    uint32_t     kind;
+};
+
+class BinaryDependencyRecord{
+public:
+    BinaryString importUri;
+};
+
+class BinaryLibraryRecord{
+public:
+    BinaryString name;
+};
+
+class BinaryStringTable{
+public:
+    BinaryString add(const std::string& str){
+        auto it = m_index.find(str);
+        if ( it != m_index.end() )
+            return it->second;
+        BinaryString bs;
+        bs.offset = static_cast<uint32_t>(m_data.size());
+        bs.length = static_cast<uint32_t>(str.size());
+        m_data.append(str);
+        m_index[str] = bs;
+        return bs;
+    }
+
+    const std::string& data() const{ return m_data; }
+
+private:
+    std::string m_data;
+    std::unordered_map<std::string, BinaryString> m_index;
+};
+
+class BinaryReader{
+public:
+    BinaryReader(const char* data, size_t size) : m_data(data), m_size(size){}
+
+    template<typename T> T read(size_t offset) const{
+        if ( offset + sizeof(T) > m_size || offset + sizeof(T) < offset )
+            throwCorrupted();
+        T result;
+        std::memcpy(&result, m_data + offset, sizeof(T));
+        return result;
+    }
+
+    Utf8 string(const BinaryString& bs, size_t tableOffset) const{
+        size_t start = tableOffset + bs.offset;
+        if ( start < tableOffset || start + bs.length > m_size || start + bs.length < start )
+            throwCorrupted();
+        return Utf8(std::string(m_data + start, bs.length));
+    }
+
+    static void throwCorrupted(){
+        THROW_EXCEPTION(Exception, "ModuleDescriptor: Binary descriptor is corrupted.", Exception::toCode("~Binary"));
+    }
+
+private:
+    const char* m_data;
+    size_t      m_size;
+};
+
+template<typename T> void appendRecord(std::string& result, const T& record){
+    result.append(reinterpret_cast<const char*>(&record), sizeof(T));
+}
+
+} // namespace
+
 ExportDescriptor::ExportDescriptor(const Utf8& name, ExportDescriptor::Kind kind )
     : m_name(name), m_kind(kind)
 {}
@@ -101,12 +220,21 @@ MLNode ModuleFileDescriptor::toMLNode() const
 }
 
 const char* ModuleDescriptor::buildFileName = "__module__.lv.json";
+const char* ModuleDescriptor::binaryBuildFileName = "__module__.lv.bin";
 
 ModuleDescriptor::Ptr ModuleDescriptor::create(const Utf8& uri){
     return ModuleDescriptor::Ptr(new ModuleDescriptor(uri));
 }
+/**
+ * Adds the file exports to the descriptor, indexing them by name. The first export
+ * added under a name takes precedence.
+ */
 void ModuleDescriptor::addModuleFileDescriptor(const ModuleFileDescriptor::Ptr &mfd){
+    if ( m_fileIndex.emplace(mfd->fileName().data(), mfd).second )
+        m_files.push_back(mfd);
+
     for ( auto it = mfd->exports().begin(); it != mfd->exports().end(); ++it ){
+        m_exportIndex.emplace(it->name().data(), m_exports.size());
         m_exports.push_back(ModuleDescriptor::ExportLink(it->name(), it->kind(), mfd));
     }
 }
@@ -115,31 +243,24 @@ void ModuleDescriptor::addModuleLibraryDescriptor(const ModuleLibraryDescriptor:
 
 ModuleDescriptor::ExportLink ModuleDescriptor:: findExportByName(const Utf8 &name) const
 {
-    for ( auto it = m_exports.begin(); it != m_exports.end(); ++it ){
-        const auto& el = *it;
-        if ( el.name() == name ){
-            return el;
-        }
+    auto it = m_exportIndex.find(name.data());
+    if ( it != m_exportIndex.end() ){
+        return m_exports[it->second];
     }
     return ModuleDescriptor::ExportLink();
 }
 
 /**
- * Returns a list of unique files
+ * Returns a list of unique files that have exports
  */
 std::vector<ModuleFileDescriptor::Ptr> ModuleDescriptor::files() const
 {
     std::vector<ModuleFileDescriptor::Ptr> result;
+    result.reserve(m_files.size());
 
-    for ( auto it = m_exports.begin(); it != m_exports.end(); ++it ){
-        const auto& el = *it;
-        if ( el.file() ){
-            auto foundIt = std::find_if(result.begin(), result.end(), [el](const ModuleFileDescriptor::Ptr& mfd) {
-                return mfd->fileName() == el.file()->fileName();
-            });
-            if ( foundIt == result.end() ){
-                result.push_back(el.file());
-            }
+    for ( auto it = m_files.begin(); it != m_files.end(); ++it ){
+        if ( !(*it)->exports().empty() ){
+            result.push_back(*it);
         }
     }
     return result;
@@ -147,11 +268,9 @@ std::vector<ModuleFileDescriptor::Ptr> ModuleDescriptor::files() const
 
 ModuleFileDescriptor::Ptr ModuleDescriptor::findFile(const Utf8 &name) const
 {
-    for ( auto it = m_exports.begin(); it != m_exports.end(); ++it ){
-        const auto& el = *it;
-        if ( el.file() && el.file()->fileName() == name ){
-            return el.file();
-        }
+    auto it = m_fileIndex.find(name.data());
+    if ( it != m_fileIndex.end() && !it->second->exports().empty() ){
+        return it->second;
     }
     return nullptr;
 }
@@ -233,6 +352,133 @@ MLNode ModuleDescriptor::toMLNode() const
     return result;
 }
 
+/**
+ * Creates the descriptor from the binary format written by toBinary, without going
+ * through an intermediate MLNode. Throws if the data is not a valid binary descriptor.
+ */
+ModuleDescriptor::Ptr ModuleDescriptor::createFromBinary(const char *data, size_t size){
+    BinaryReader reader(data, size);
+    BinaryHeader header = reader.read<BinaryHeader>(0);
+
+    if ( std::memcmp(header.magic, binaryMagic, sizeof(binaryMagic)) != 0 || header.version != binaryVersion ){
+        THROW_EXCEPTION(Exception, "ModuleDescriptor: Binary descriptor has an unknown format.", Exception::toCode("~Binary"));
+    }
+
+    size_t fileOffset       = sizeof(BinaryHeader);
+    size_t exportOffset     = fileOffset + static_cast<size_t>(header.fileCount) * sizeof(BinaryFileRecord);
+    size_t dependencyOffset = exportOffset + static_cast<size_t>(header.exportCount) * sizeof(BinaryExportRecord);
+    size_t libraryOffset    = dependencyOffset + static_cast<size_t>(header.dependencyCount) * sizeof(BinaryDependencyRecord);
+    size_t stringOffset     = libraryOffset + static_cast<size_t>(header.libraryCount) * sizeof(BinaryLibraryRecord);
+    if ( stringOffset + header.stringTableSize != size )
+        BinaryReader::throwCorrupted();
+
+    ModuleDescriptor::Ptr md = ModuleDescriptor::create(reader.string(header.uri, stringOffset));
+
+    for ( uint32_t i = 0; i < header.fileCount; ++i ){
+        BinaryFileRecord fr = reader.read<BinaryFileRecord>(fileOffset + i * sizeof(BinaryFileRecord));
+        if ( static_cast<size_t>(fr.firstExport) + fr.exportCount > header.exportCount ||
+             static_cast<size_t>(fr.firstDependency) + fr.dependencyCount > header.dependencyCount )
+        {
+            BinaryReader::throwCorrupted();
+        }
+
+        ModuleFileDescriptor::Ptr mfd = ModuleFileDescriptor::create(reader.string(fr.fileName, stringOffset));
+        for ( uint32_t j = fr.firstExport; j < fr.firstExport + fr.exportCount; ++j ){
+            BinaryExportRecord er = reader.read<BinaryExportRecord>(exportOffset + j * sizeof(BinaryExportRecord));
+            if ( er.kind != ExportDescriptor::Component && er.kind != ExportDescriptor::Element )
+                BinaryReader::throwCorrupted();
+            mfd->addExport(ExportDescriptor(reader.string(er.name, stringOffset), static_cast<ExportDescriptor::Kind>(er.kind)));
+        }
+        for ( uint32_t j = fr.firstDependency; j < fr.firstDependency + fr.dependencyCount; ++j ){
+            BinaryDependencyRecord dr = reader.read<BinaryDependencyRecord>(dependencyOffset + j * sizeof(BinaryDependencyRecord));
+            mfd->addDependency(ModuleFileDescriptor::ImportDependency(reader.string(dr.importUri, stringOffset)));
+        }
+        md->addModuleFileDescriptor(mfd);
+    }
+
+    for ( uint32_t i = 0; i < header.libraryCount; ++i ){
+        BinaryLibraryRecord lr = reader.read<BinaryLibraryRecord>(libraryOffset + i * sizeof(BinaryLibraryRecord));
+        md->addModuleLibraryDescriptor(ModuleLibraryDescriptor::create(reader.string(lr.name, stringOffset)));
+    }
+
+    return md;
+}
+
+/**
+ * Writes the descriptor in binary format, containing the same data as toMLNode.
+ */
+void ModuleDescriptor::toBinary(std::string &result) const{
+    BinaryStringTable strings;
+
+    std::vector<BinaryFileRecord> fileRecords;
+    std::vector<BinaryExportRecord> exportRecords;
+    std::vector<BinaryDependencyRecord> dependencyRecords;
+    std::vector<BinaryLibraryRecord> libraryRecords;
+
+    auto fileExports = files();
+    for ( auto it = fileExports.begin(); it != fileExports.end(); ++it ){
+        const ModuleFileDescriptor::Ptr& mfd = *it;
+
+        BinaryFileRecord fr;
+        fr.fileName        = strings.add(mfd->fileName().data());
+        fr.firstExport     = static_cast<uint32_t>(exportRecords.size());
+        fr.exportCount     = static_cast<uint32_t>(mfd->exports().size());
+        fr.firstDependency = static_cast<uint32_t>(dependencyRecords.size());
+        fr.dependencyCount = static_cast<uint32_t>(mfd->dependencies().size());
+        fileRecords.push_back(fr);
+
+        for ( auto eit = mfd->exports().begin(); eit != mfd->exports().end(); ++eit ){
+            BinaryExportRecord er;
+            er.name = strings.add(eit->name().data());
+            er.kind = static_cast<uint32_t>(eit->kind());
+            exportRecords.push_back(er);
+        }
+        for ( auto dit = mfd->dependencies().begin(); dit != mfd->dependencies().end(); ++dit ){
+            BinaryDependencyRecord dr;
+            dr.importUri = strings.add(dit->importUri().data());
+            dependencyRecords.push_back(dr);
+        }
+    }
+
+    auto libraryExports = libraries();
+    for ( auto it = libraryExports.begin(); it != libraryExports.end(); ++it ){
+        BinaryLibraryRecord lr;
+        lr.name = strings.add((*it)->name().data());
+        libraryRecords.push_back(lr);
+    }
+
+    BinaryHeader header;
+    std::memcpy(header.magic, binaryMagic, sizeof(binaryMagic));
+    header.version         = binaryVersion;
+    header.uri             = strings.add(m_uri.data());
+    header.fileCount       = static_cast<uint32_t>(fileRecords.size());
+    header.exportCount     = static_cast<uint32_t>(exportRecords.size());
+    header.dependencyCount = static_cast<uint32_t>(dependencyRecords.size());
+    header.libraryCount    = static_cast<uint32_t>(libraryRecords.size());
+    header.stringTableSize = static_cast<uint32_t>(strings.data().size());
+
+    result.clear();
+    result.reserve(
+        sizeof(BinaryHeader) +
+        fileRecords.size() * sizeof(BinaryFileRecord) +
+        exportRecords.size() * sizeof(BinaryExportRecord) +
+        dependencyRecords.size() * sizeof(BinaryDependencyRecord) +
+        libraryRecords.size() * sizeof(BinaryLibraryRecord) +
+        strings.data().size()
+    );
+
+    appendRecord(result, header);
+    for ( const auto& r : fileRecords )
+        appendRecord(result, r);
+    for ( const auto& r : exportRecords )
+        appendRecord(result, r);
+    for ( const auto& r : dependencyRecords )
+        appendRecord(result, r);
+    for ( const auto& r : libraryRecords )
+        appendRecord(result, r);
+    result.append(strings.data());
+}
+
 ModuleLibraryDescriptor::Ptr ModuleLibraryDescriptor::create(const Utf8 &name)
 {
     return ModuleLibraryDescriptor::Ptr(new ModuleLibraryDescriptor(name));
@@ -20,6 +20,8 @@
 #include "live/utf8.h"
 #include "live/mlnode.h"
 
+#include <unordered_map>
+
 namespace lv{ namespace el{
 
 class LV_ELEMENTS_COMPILER_EXPORT ExportDescriptor{
@@ -146,10 +148,13 @@ public:
     
     /** Name for the module build file */
     static const char* buildFileName;
+    /** Name for the binary module build file, written alongside the json one */
+    static const char* binaryBuildFileName;
 
 public:
     static Ptr create(const Utf8& uri);
     static ModuleDescriptor::Ptr createFromMlNode(const MLNode& node);
+    static ModuleDescriptor::Ptr createFromBinary(const char* data, size_t size);
 
     const Utf8& uri() const{ return m_uri; }
     const std::vector<ExportLink>& exports(){ return m_exports; }
@@ -164,13 +169,17 @@ public:
     std::vector<ModuleLibraryDescriptor::Ptr> libraries() const;
 
     MLNode toMLNode() const;
+    void toBinary(std::string& result) const;
 
 private:
     ModuleDescriptor(const Utf8& uri) : m_uri(uri){}
 
 private:
-    Utf8                    m_uri;
-    std::vector<ExportLink> m_exports;
+    Utf8                                   m_uri;
+    std::vector<ExportLink>                m_exports;
+    std::vector<ModuleFileDescriptor::Ptr> m_files;
+    std::unordered_map<std::string, size_t>                    m_exportIndex;
+    std::unordered_map<std::string, ModuleFileDescriptor::Ptr> m_fileIndex;
 };
 
 
@@ -15,6 +15,7 @@
 
 #include "languagenodes_p.h"
 #include "propertybindingcontainer_p.h"
+#include "memoryaccounting.h"
 #include "live/visuallog.h"
 #include "live/stacktrace.h"
 
@@ -22,6 +23,7 @@
 #include <vector>
 #include <algorithm>
 #include <set>
+#include <unordered_map>
 #include <string.h>
 
 namespace lv{ namespace el{
@@ -84,6 +86,16 @@ BaseNode::~BaseNode(){
     }
 }
 
+void *BaseNode::operator new(size_t size){
+    MemoryAccounting::add(MemoryAccounting::Nodes, size);
+    return ::operator new(size);
+}
+
+void BaseNode::operator delete(void *p, size_t size){
+    MemoryAccounting::remove(MemoryAccounting::Nodes, size);
+    ::operator delete(p);
+}
+
 BaseNode *BaseNode::visit(const std::string &filePath, const std::string &fileName, LanguageParser::AST *ast){
     TSTree* tree = reinterpret_cast<TSTree*>(ast);
     TSNode root_node = ts_tree_root_node(tree);
@@ -380,7 +392,7 @@ void BaseNode::addChild(BaseNode *child){
 std::string BaseNode::astString() const{
     char* str = ts_node_string(m_node);
     std::string result(str);
-    free(str);
+    MemoryAccounting::freeTreeSitterMemory(str);
     return result;
 }
 
@@ -1969,57 +1981,52 @@ void ProgramNode::collectImportTypes(const std::string &source, ConversionContex
     std::vector<IdentifierNode*> identifiers;
     collectImports(source, identifiers, ctx);
 
+    // map import namespaces once, instead of slicing each import for every identifier
+    std::unordered_map<std::string, ImportNode*> importNamespaces;
+    for ( ImportNode* in : m_imports ){
+        if ( in->hasNamespace() )
+            importNamespaces.emplace(in->as(source), in);
+    }
+
     for ( auto identifier : identifiers ){
 
         std::string idName = slice(source, identifier);
 
-        bool isNamespaceIdentifier = false;
-
         // check whether identifier is part of an import namespace
-        for ( ImportNode* in : m_imports ){
-            if ( in->hasNamespace() ){
-                if ( in->as(source) == idName ){
-                    isNamespaceIdentifier = true;
-                    BaseNode* parent = identifier->parent();
-                    if ( parent->isNodeType<ComponentDeclarationNode>() ){
-                        auto parentCast = parent->as<ComponentDeclarationNode>();
-                        if ( parentCast->heritage().size() > 1 && parentCast->heritage()[0] == identifier ){
-                            ProgramNode::ImportType impt;
-                            impt.importNamespace = idName;
-                            impt.name = slice(source, parentCast->heritage()[1]);
-                            impt.location = identifier->startPoint();
-                            addImportType(impt);
-                        }
-                    } else if ( parent->isNodeType<MemberExpressionNode>() ){
-                        auto parentCast = parent->as<MemberExpressionNode>();
-                        if ( parentCast->children().size() > 1 && parentCast->children()[0] == identifier ){
-                            ProgramNode::ImportType impt;
-                            impt.importNamespace = idName;
-                            impt.name = slice(source, parentCast->children()[1]);
-                            impt.location = identifier->startPoint();
-                            addImportType(impt);
-                        }
-                    } else if ( parent->isNodeType<NewComponentExpressionNode>() ||
-                                parent->isNodeType<RootNewComponentExpressionNode>() )
-                    {
-                        auto parentCast = parent->as<NewComponentExpressionNode>();
-                        if ( parentCast->name().size() > 1 && parentCast->name()[0] == identifier ){
-                            ProgramNode::ImportType impt;
-                            impt.importNamespace = idName;
-                            impt.name = slice(source, parentCast->name()[1]);
-                            impt.location = identifier->startPoint();
-                            addImportType(impt);
-                        }
-                    }
+        if ( importNamespaces.find(idName) != importNamespaces.end() ){
+            BaseNode* parent = identifier->parent();
+            BaseNode* typeNode = nullptr;
+            if ( parent->isNodeType<ComponentDeclarationNode>() ){
+                auto parentCast = parent->as<ComponentDeclarationNode>();
+                if ( parentCast->heritage().size() > 1 && parentCast->heritage()[0] == identifier ){
+                    typeNode = parentCast->heritage()[1];
+                }
+            } else if ( parent->isNodeType<MemberExpressionNode>() ){
+                auto parentCast = parent->as<MemberExpressionNode>();
+                if ( parentCast->children().size() > 1 && parentCast->children()[0] == identifier ){
+                    typeNode = parentCast->children()[1];
+                }
+            } else if ( parent->isNodeType<NewComponentExpressionNode>() ||
+                        parent->isNodeType<RootNewComponentExpressionNode>() )
+            {
+                auto parentCast = parent->as<NewComponentExpressionNode>();
+                if ( parentCast->name().size() > 1 && parentCast->name()[0] == identifier ){
+                    typeNode = parentCast->name()[1];
                 }
             }
-        }
 
-        if ( !isNamespaceIdentifier ){
+            if ( typeNode ){
+                ProgramNode::ImportType impt;
+                impt.name = slice(source, typeNode);
+                impt.importNamespace = std::move(idName);
+                impt.location = identifier->startPoint();
+                addImportType(std::move(impt));
+            }
+        } else {
             ProgramNode::ImportType impt;
-            impt.name = idName;
+            impt.name = std::move(idName);
             impt.location = identifier->startPoint();
-            addImportType(impt);
+            addImportType(std::move(impt));
         }
     }
 
@@ -2117,13 +2124,21 @@ void ProgramNode::collectImports(const std::string &source, std::vector<Identifi
 }
 
 void ProgramNode::addImportType(const ProgramNode::ImportType &t){
+    addImportType(ProgramNode::ImportType(t));
+}
+
+void ProgramNode::addImportType(ProgramNode::ImportType &&t){
     auto asIt = m_importTypes.find(t.importNamespace);
-    if ( asIt == m_importTypes.end() ){
-        std::map<std::string, ProgramNode::ImportType> imports;
-        imports[t.name] = t;
-        m_importTypes[t.importNamespace] = imports;
+    if ( asIt == m_importTypes.end() )
+        asIt = m_importTypes.emplace(t.importNamespace, std::map<std::string, ProgramNode::ImportType>()).first;
+
+    std::map<std::string, ProgramNode::ImportType>& imports = asIt->second;
+    auto nameIt = imports.lower_bound(t.name);
+    if ( nameIt != imports.end() && nameIt->first == t.name ){
+        nameIt->second = std::move(t);
     } else {
-        asIt->second[t.name] = t;
+        std::string name = t.name;
+        imports.emplace_hint(nameIt, std::move(name), std::move(t));
     }
 }
 
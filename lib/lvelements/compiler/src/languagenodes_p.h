@@ -120,6 +120,9 @@ public:
     BaseNode(const TSNode& node, const LanguageNodeInfo::ConstPtr& ni);
     virtual ~BaseNode();
 
+    static void* operator new(size_t size);
+    static void operator delete(void* p, size_t size);
+
     const TSNode& current() const{ return m_node; }
     std::string astString() const;
     virtual std::string toString(int indent = 0) const;
@@ -339,6 +342,7 @@ public:
     std::string importTypesString() const;
 
     void addImportType(const ImportType& t);
+    void addImportType(ImportType&& t);
 
 protected:
     virtual void addChild(BaseNode *child);
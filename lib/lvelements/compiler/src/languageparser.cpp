@@ -20,6 +20,7 @@
 #include "elementsparserinternal.h"
 #include "languagenodes_p.h"
 #include "elementssections_p.h"
+#include "memoryaccounting.h"
 
 #include "live/visuallog.h"
 
@@ -85,9 +86,11 @@ std::string slice(const std::string& source, TSNode& node){
 }
 
 LanguageParser::LanguageParser(Language *language)
-    : m_parser(ts_parser_new())
+    : m_parser(nullptr)
     , m_language(language)
 {
+    MemoryAccounting::installTreeSitterAllocator();
+    m_parser = ts_parser_new();
     ts_parser_set_language(m_parser, reinterpret_cast<const TSLanguage*>(language));
 }
 
@@ -271,7 +274,7 @@ LanguageParser::ComparisonResult LanguageParser::compare(
 std::string LanguageParser::toString(LanguageParser::AST *ast) const {
     char* str = ts_node_string(ts_tree_root_node(reinterpret_cast<TSTree*>(ast)));
     std::string result(str);
-    free(str);
+    MemoryAccounting::freeTreeSitterMemory(str);
     return result;
 }
 
@@ -16,9 +16,157 @@
 #include "languagequery.h"
 #include "live/visuallog.h"
 #include "tree_sitter/api.h"
+#include "memoryaccounting.h"
+
+#include <map>
+#include <mutex>
+#include <unordered_map>
+
+/**
+ * \class lv::el::LanguageQuery
+ * \brief Runs tree-sitter queries over a parsed AST
+ *
+ * Compiled queries are cached per language and query string for the lifetime of the process, so
+ * creating the same query again only costs a lookup. The compiled query is immutable and shared
+ * between LanguageQuery objects, while predicates are registered on each object. Predicates of
+ * each pattern are resolved once at compile time and dispatched by their string id.
+ *
+ * \ingroup lvelementscompiler
+ */
 
 namespace lv{ namespace el{
 
+/// \private
+class LanguageQuery::Compiled{
+
+public:
+    class Argument{
+    public:
+        TSQueryPredicateStepType type;
+        uint32_t                 valueId;
+        Utf8                     value;
+    };
+
+    class Call{
+    public:
+        uint32_t              function;
+        std::string           functionName;
+        std::vector<Argument> arguments;
+    };
+
+    Compiled(TSQuery* q);
+    ~Compiled(){ ts_query_delete(query); }
+
+    TSQuery*                                  query;
+    std::vector<std::vector<Call> >           patternPredicates;
+    std::unordered_map<std::string, uint32_t> stringIds;
+
+private:
+    DISABLE_COPY(Compiled);
+};
+
+LanguageQuery::Compiled::Compiled(TSQuery *q)
+    : query(q)
+{
+    uint32_t totalStrings = ts_query_string_count(query);
+    for ( uint32_t i = 0; i < totalStrings; ++i ){
+        uint32_t length;
+        const char* value = ts_query_string_value_for_id(query, i, &length);
+        stringIds.emplace(std::string(value, length), i);
+    }
+
+    uint32_t totalPatterns = ts_query_pattern_count(query);
+    patternPredicates.resize(totalPatterns);
+    for ( uint32_t pattern = 0; pattern < totalPatterns; ++pattern ){
+        uint32_t length;
+        const TSQueryPredicateStep* step = ts_query_predicates_for_pattern(query, pattern, &length);
+
+        bool expectFunction = true;
+        for ( uint32_t i = 0; i < length; ++i ){
+            if ( step[i].type == TSQueryPredicateStepTypeDone ){
+                expectFunction = true;
+            } else if ( expectFunction ){
+                uint32_t strLen = 0;
+                Call call;
+                call.function = step[i].value_id;
+                call.functionName = ts_query_string_value_for_id(query, step[i].value_id, &strLen);
+                patternPredicates[pattern].push_back(call);
+                expectFunction = false;
+            } else {
+                uint32_t strLen = 0;
+                Argument arg;
+                arg.type = step[i].type;
+                arg.valueId = step[i].value_id;
+                if ( step[i].type == TSQueryPredicateStepTypeString )
+                    arg.value = ts_query_string_value_for_id(query, step[i].value_id, &strLen);
+                patternPredicates[pattern].back().arguments.push_back(arg);
+            }
+        }
+    }
+}
+
+namespace{
+
+class LanguageQueryCache{
+public:
+    std::mutex mutex;
+    std::map<const void*, std::unordered_map<std::string, std::shared_ptr<LanguageQuery::Compiled> > > queries;
+};
+
+LanguageQueryCache& languageQueryCache(){
+    static LanguageQueryCache cache;
+    return cache;
+}
+
+/**
+ * Cursors released by finished queries. Creating a cursor allocates its state and capture lists,
+ * which a reused cursor keeps between executions.
+ */
+class QueryCursorPool{
+public:
+    static const size_t MaxCursors = 16;
+
+    ~QueryCursorPool(){
+        for ( TSQueryCursor* cursor : cursors )
+            ts_query_cursor_delete(cursor);
+    }
+
+    std::mutex                  mutex;
+    std::vector<TSQueryCursor*> cursors;
+};
+
+QueryCursorPool& queryCursorPool(){
+    static QueryCursorPool pool;
+    return pool;
+}
+
+TSQueryCursor* acquireQueryCursor(){
+    QueryCursorPool& pool = queryCursorPool();
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        if ( !pool.cursors.empty() ){
+            TSQueryCursor* cursor = pool.cursors.back();
+            pool.cursors.pop_back();
+            return cursor;
+        }
+    }
+    return ts_query_cursor_new();
+}
+
+void releaseQueryCursor(TSQueryCursor* cursor){
+    QueryCursorPool& pool = queryCursorPool();
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        if ( pool.cursors.size() < QueryCursorPool::MaxCursors ){
+            pool.cursors.push_back(cursor);
+            return;
+        }
+    }
+    ts_query_cursor_delete(cursor);
+}
+
+} // namespace
+
 // LanguageQueryException
 // -----------------------------------------------------------------------------
 
@@ -67,7 +215,7 @@ uint32_t LanguageQuery::Cursor::captureId(uint16_t captureIndex){
 }
 
 LanguageQuery::Cursor::Cursor()
-    : m_cursor(ts_query_cursor_new())
+    : m_cursor(acquireQueryCursor())
     , m_currentMatch(new TSQueryMatch)
 {
 }
@@ -75,7 +223,7 @@ LanguageQuery::Cursor::Cursor()
 LanguageQuery::Cursor::~Cursor(){
     TSQueryCursor* cursor = reinterpret_cast<TSQueryCursor*>(m_cursor);
     TSQueryMatch* currentMatch = reinterpret_cast<TSQueryMatch*>(m_currentMatch);
-    ts_query_cursor_delete(cursor);
+    releaseQueryCursor(cursor);
     delete currentMatch;
 }
 
@@ -83,9 +231,26 @@ LanguageQuery::Cursor::~Cursor(){
 // LanguageQuery
 // -----------------------------------------------------------------------------
 
+/**
+ * \brief Returns a query for \p queryString, compiling it only if it's not already cached for \p language
+ *
+ * Throws LanguageQueryException if the query fails to compile. Failed queries are not cached.
+ */
 LanguageQuery::Ptr LanguageQuery::create(LanguageParser::Language* language, const std::string &queryString){
-    uint32_t errorOffset;
-    TSQueryError errorType;
+    LanguageQueryCache& cache = languageQueryCache();
+    {
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        auto languageIt = cache.queries.find(language);
+        if ( languageIt != cache.queries.end() ){
+            auto it = languageIt->second.find(queryString);
+            if ( it != languageIt->second.end() )
+                return LanguageQuery::Ptr(new LanguageQuery(it->second));
+        }
+    }
+
+    MemoryAccounting::installTreeSitterAllocator();
+    uint32_t errorOffset = 0;
+    TSQueryError errorType = TSQueryErrorNone;
 
     TSQuery * query = ts_query_new(
       reinterpret_cast<const TSLanguage*>(language),
@@ -97,15 +262,37 @@ LanguageQuery::Ptr LanguageQuery::create(LanguageParser::Language* language, con
 
     if ( errorType != TSQueryErrorNone ){
         ts_query_delete(query);
-        throw LanguageQueryException("Language query error.", 0, errorType, SOURCE_TRACE());
+        throw LanguageQueryException("Language query error.", errorOffset, errorType, SOURCE_TRACE());
+    }
+
+    std::shared_ptr<Compiled> compiled(new Compiled(query));
+    {
+        // another thread may have compiled the same query meanwhile, in which case theirs is kept
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        auto insertion = cache.queries[language].emplace(queryString, compiled);
+        compiled = insertion.first->second;
     }
 
-    return LanguageQuery::Ptr(new LanguageQuery(static_cast<void*>(query)));
+    return LanguageQuery::Ptr(new LanguageQuery(compiled));
 }
 
 LanguageQuery::~LanguageQuery(){
-    TSQuery* query = reinterpret_cast<TSQuery*>(m_query);
-    ts_query_delete(query);
+}
+
+size_t LanguageQuery::totalCachedQueries(){
+    LanguageQueryCache& cache = languageQueryCache();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    size_t total = 0;
+    for ( auto it = cache.queries.begin(); it != cache.queries.end(); ++it )
+        total += it->second.size();
+    return total;
+}
+
+/** Releases cached queries. Queries already created keep their compiled query until destroyed. */
+void LanguageQuery::clearCache(){
+    LanguageQueryCache& cache = languageQueryCache();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    cache.queries.clear();
 }
 
 uint32_t LanguageQuery::captureCount() const{
@@ -130,6 +317,8 @@ LanguageQuery::Cursor::Ptr LanguageQuery::exec(LanguageParser::AST *ast){
     Cursor::Ptr cursor(new Cursor);
     TSQueryCursor* cursorInternal = reinterpret_cast<TSQueryCursor*>(cursor->m_cursor);
 
+    // pooled cursors keep the range of their previous execution
+    ts_query_cursor_set_byte_range(cursorInternal, 0, 0);
     ts_query_cursor_exec(cursorInternal, query, root);
     return cursor;
 }
@@ -150,55 +339,59 @@ LanguageQuery::Cursor::Ptr LanguageQuery::exec(LanguageParser::AST *ast, uint32_
 }
 
 bool LanguageQuery::predicateMatch(const Cursor::Ptr &cursor, void *payload){
-    TSQuery* query = reinterpret_cast<TSQuery*>(m_query);
-    uint32_t length;
-    const TSQueryPredicateStep* step = ts_query_predicates_for_pattern(query, cursor->matchPatternIndex(), &length);
-    if ( length == 0 )
+    const std::vector<Compiled::Call>& calls = m_compiled->patternPredicates[cursor->matchPatternIndex()];
+    if ( calls.empty() )
         return true;
 
-    std::string functionToCall;
-    uint32_t strLen = 0;
-
     std::vector<LanguageQuery::PredicateData> args;
 
-    for( uint32_t i = 0; i < length; ++i ){
-        if ( functionToCall.empty() ){
-            functionToCall = ts_query_string_value_for_id(query, step[i].value_id, &strLen);
-        } else if ( step[i].type == TSQueryPredicateStepTypeString ){
-            LanguageQuery::PredicateData pd;
-            pd.m_value = ts_query_string_value_for_id(query, step[i].value_id, &strLen);
-            args.push_back(pd);
-        } else if ( step[i].type == TSQueryPredicateStepTypeCapture ){
-            uint16_t captures = cursor->totalMatchCaptures();
-            for ( uint16_t captureIndex = 0; captureIndex < captures; ++captureIndex ){
-                uint32_t captureId = cursor->captureId(captureIndex);
-                if ( captureId == step[i].value_id ){
-                    LanguageQuery::PredicateData pd;
-                    pd.m_range = cursor->captureRange(captureIndex);
-                    args.push_back(pd);
-                    break;
+    for ( const Compiled::Call& call : calls ){
+        if ( call.function >= m_predicates.size() || !m_predicates[call.function] ){
+            THROW_EXCEPTION(Exception, "LanguageQuery: Failed to find function \'" + call.functionName + "\'", Exception::toCode("~Function"));
+        }
+
+        args.clear();
+        for ( const Compiled::Argument& arg : call.arguments ){
+            if ( arg.type == TSQueryPredicateStepTypeString ){
+                LanguageQuery::PredicateData pd;
+                pd.m_value = arg.value;
+                args.push_back(pd);
+            } else if ( arg.type == TSQueryPredicateStepTypeCapture ){
+                uint16_t captures = cursor->totalMatchCaptures();
+                for ( uint16_t captureIndex = 0; captureIndex < captures; ++captureIndex ){
+                    uint32_t captureId = cursor->captureId(captureIndex);
+                    if ( captureId == arg.valueId ){
+                        LanguageQuery::PredicateData pd;
+                        pd.m_range = cursor->captureRange(captureIndex);
+                        args.push_back(pd);
+                        break;
+                    }
                 }
             }
-        } else if ( step[i].type == TSQueryPredicateStepTypeDone ){
-            auto it = m_predicates.find(functionToCall);
-            if ( it == m_predicates.end() ){
-                THROW_EXCEPTION(Exception, "LanguageQuery: Failed to find function \'" + functionToCall + "\'", Exception::toCode("~Function"));
-            }
-            if ( !it->second(args, payload) )
-                return false;
-            functionToCall = "";
         }
+
+        if ( !m_predicates[call.function](args, payload) )
+            return false;
     }
 
     return true;
 }
 
-void LanguageQuery::addPredicate(const std::string &name, std::function<bool (const std::vector<LanguageQuery::PredicateData> &, void *)> callback){
-    m_predicates[name] = callback;
+/**
+ * Registers \p callback for predicates named \p name. Names that don't appear in the query are
+ * ignored, since none of its patterns can call them.
+ */
+void LanguageQuery::addPredicate(const std::string &name, Predicate callback){
+    auto it = m_compiled->stringIds.find(name);
+    if ( it == m_compiled->stringIds.end() )
+        return;
+    m_predicates[it->second] = callback;
 }
 
-LanguageQuery::LanguageQuery(void *query)
-    : m_query(query)
+LanguageQuery::LanguageQuery(const std::shared_ptr<Compiled>& compiled)
+    : m_compiled(compiled)
+    , m_predicates(compiled->stringIds.size())
+    , m_query(compiled->query)
 {
 }
 
@@ -22,7 +22,7 @@
 #include "live/exception.h"
 
 #include <memory>
-#include <map>
+#include <vector>
 #include <functional>
 
 namespace lv{ namespace el{
@@ -78,11 +78,17 @@ public:
 
     typedef std::shared_ptr<LanguageQuery>       Ptr;
     typedef std::shared_ptr<const LanguageQuery> ConstPtr;
+    typedef std::function<bool(const std::vector<PredicateData>&, void* payload)> Predicate;
+
+    class Compiled;
 
 public:
     static LanguageQuery::Ptr create(LanguageParser::Language *, const std::string& query);
     ~LanguageQuery();
 
+    static size_t totalCachedQueries();
+    static void clearCache();
+
     uint32_t captureCount() const;
     std::string captureName(uint32_t captureIndex) const;
 
@@ -91,13 +97,14 @@ public:
 
     bool predicateMatch(const Cursor::Ptr& cursor, void* payload = nullptr);
 
-    void addPredicate(const std::string& name, std::function<bool(const std::vector<PredicateData>&, void* payload)> callback);
+    void addPredicate(const std::string& name, Predicate callback);
 
 private:
     DISABLE_COPY(LanguageQuery);
-    LanguageQuery(void* query);
+    LanguageQuery(const std::shared_ptr<Compiled>& compiled);
 
-    std::map<std::string, std::function<bool(const std::vector<PredicateData>&, void* payload)> > m_predicates;
+    std::shared_ptr<Compiled> m_compiled;
+    std::vector<Predicate>    m_predicates;
 
     void* m_query;
 };
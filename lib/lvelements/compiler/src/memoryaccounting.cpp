@@ -0,0 +1,650 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 Dinu SV.
+** This file is part of Livekeys Application.
+**
+** GNU Lesser General Public License Usage
+** This file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+****************************************************************************/
+
+#include "memoryaccounting.h"
+#include "tree_sitter/api.h"
+#include "alloc.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#if defined(PLATFORM_OS_LINUX) || defined(PLATFORM_OS_WIN)
+#include <malloc.h>
+#elif defined(PLATFORM_OS_MAC)
+#include <malloc/malloc.h>
+#endif
+
+/**
+ * \class lv::el::MemoryAccounting
+ * \brief Counts bytes held by the main compiler structures
+ *
+ * Tree-sitter allocations are counted through ts_set_allocator, using the allocated block size
+ * reported by the system allocator. BaseNode, InsertionSection and PropertyBindingContainer::Node
+ * count themselves through class specific operator new and delete, and module files count the
+ * source content they retain.
+ *
+ * Each category keeps live and peak bytes. Allocations made while a FileScope is active on the
+ * current thread are also attributed to that file.
+ *
+ * Accounting is disabled by default, so compiles that don't report memory don't pay for the shared
+ * counters. It's enabled with setEnabled() before compiling.
+ *
+ * Tree-sitter can optionally allocate from thread-local size-class pools instead of malloc, selected
+ * with setTreeSitterAllocator() before the first parser is created. Blocks carry their requested size,
+ * so the TreeSitter category then holds exact byte counts, and threads parsing in parallel only take a
+ * lock when their pool needs to be refilled.
+ *
+ * \ingroup lvelementscompiler
+ */
+
+namespace lv{ namespace el{
+
+/// \private
+class MemoryAccountingFile{
+public:
+    MemoryAccountingFile() : current(0), peak(0), allocated(0){}
+
+    void add(std::int64_t bytes){
+        allocated += bytes;
+        std::int64_t value = current += bytes;
+        std::int64_t p = peak;
+        while ( value > p && !peak.compare_exchange_weak(p, value) ){}
+    }
+
+    std::atomic<std::int64_t> current;
+    std::atomic<std::int64_t> peak;
+    std::atomic<std::int64_t> allocated;
+};
+
+namespace{
+
+std::atomic<bool> accountingEnabled(false);
+
+/** Counters of a category, on a cache line of their own, since threads update them in parallel */
+class alignas(64) CategoryCounter{
+public:
+    CategoryCounter() : live(0), peak(0), allocations(0){}
+
+    std::atomic<std::int64_t> live;
+    std::atomic<std::int64_t> peak;
+    std::atomic<std::int64_t> allocations;
+};
+
+CategoryCounter* categoryCounters(){
+    static CategoryCounter counters[MemoryAccounting::TotalCategories];
+    return counters;
+}
+
+MemoryAccountingFile*& currentFile(){
+    thread_local MemoryAccountingFile* file = nullptr;
+    return file;
+}
+
+std::mutex& filesMutex(){
+    static std::mutex mutex;
+    return mutex;
+}
+
+std::map<std::string, std::shared_ptr<MemoryAccountingFile> >& files(){
+    static std::map<std::string, std::shared_ptr<MemoryAccountingFile> > f;
+    return f;
+}
+
+size_t allocatedSize(void* p){
+#if defined(PLATFORM_OS_LINUX)
+    return malloc_usable_size(p);
+#elif defined(PLATFORM_OS_MAC)
+    return malloc_size(p);
+#elif defined(PLATFORM_OS_WIN)
+    return _msize(p);
+#else
+    MARK_UNUSED(p);
+    return 0;
+#endif
+}
+
+void* treeSitterMalloc(size_t size){
+    void* p = std::malloc(size);
+    if ( p )
+        MemoryAccounting::add(MemoryAccounting::TreeSitter, allocatedSize(p));
+    return p;
+}
+
+void* treeSitterCalloc(size_t count, size_t size){
+    void* p = std::calloc(count, size);
+    if ( p )
+        MemoryAccounting::add(MemoryAccounting::TreeSitter, allocatedSize(p));
+    return p;
+}
+
+void* treeSitterRealloc(void* p, size_t size){
+    size_t previousSize = p ? allocatedSize(p) : 0;
+    void* result = std::realloc(p, size);
+    if ( result ){
+        if ( previousSize )
+            MemoryAccounting::remove(MemoryAccounting::TreeSitter, previousSize);
+        MemoryAccounting::add(MemoryAccounting::TreeSitter, allocatedSize(result));
+    }
+    return result;
+}
+
+void treeSitterFree(void* p){
+    if ( p )
+        MemoryAccounting::remove(MemoryAccounting::TreeSitter, allocatedSize(p));
+    std::free(p);
+}
+
+
+// Tree-sitter pool allocator
+// ----------------------------------------------------------------------------
+
+/**
+ * Header in front of each pooled block. Its size keeps the payload aligned the same way malloc
+ * aligns, and freed blocks reuse the payload to link to the next free block.
+ */
+class PoolBlockHeader{
+public:
+    size_t       size;
+    unsigned int sizeClass;
+    unsigned int reserved;
+};
+
+const size_t PoolHeaderSize = 16;
+const size_t PoolSizeClasses[] = {16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048, 3072, 4096};
+const unsigned int PoolTotalSizeClasses = sizeof(PoolSizeClasses) / sizeof(size_t);
+const unsigned int PoolLargeClass = PoolTotalSizeClasses;
+const size_t PoolSlabSize = 64 * 1024;
+
+static_assert(sizeof(PoolBlockHeader) <= PoolHeaderSize, "Pool block header exceeds its reserved size.");
+
+unsigned int poolSizeClass(size_t size){
+    for ( unsigned int i = 0; i < PoolTotalSizeClasses; ++i )
+        if ( size <= PoolSizeClasses[i] )
+            return i;
+    return PoolLargeClass;
+}
+
+PoolBlockHeader* poolHeader(void* p){
+    return reinterpret_cast<PoolBlockHeader*>(static_cast<char*>(p) - PoolHeaderSize);
+}
+
+void* poolPayload(PoolBlockHeader* header){
+    return reinterpret_cast<char*>(header) + PoolHeaderSize;
+}
+
+void*& poolNext(PoolBlockHeader* header){
+    return *static_cast<void**>(poolPayload(header));
+}
+
+/** A linked list of free blocks of the same size class */
+class PoolChain{
+public:
+    PoolChain() : head(nullptr), count(0){}
+
+    PoolBlockHeader* head;
+    size_t           count;
+};
+
+/**
+ * Slabs shared by all threads. Slabs are kept for the lifetime of the process, so blocks can be
+ * freed on any thread, and chains of free blocks released by threads are handed to the next thread
+ * that runs out.
+ */
+class TreeSitterPool{
+public:
+    TreeSitterPool() : reservedBytes(0), pooledAllocations(0), largeAllocations(0), refills(0){}
+
+    PoolChain refill(unsigned int sizeClass){
+        ++refills;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::vector<PoolChain>& chains = freeChains[sizeClass];
+            if ( !chains.empty() ){
+                PoolChain chain = chains.back();
+                chains.pop_back();
+                return chain;
+            }
+        }
+
+        char* slab = static_cast<char*>(std::malloc(PoolSlabSize));
+        if ( !slab )
+            return PoolChain();
+        reservedBytes += PoolSlabSize;
+
+        size_t blockSize = PoolHeaderSize + PoolSizeClasses[sizeClass];
+        PoolChain chain;
+        for ( size_t offset = 0; offset + blockSize <= PoolSlabSize; offset += blockSize ){
+            PoolBlockHeader* header = reinterpret_cast<PoolBlockHeader*>(slab + offset);
+            header->sizeClass = sizeClass;
+            poolNext(header) = chain.head;
+            chain.head = header;
+            ++chain.count;
+        }
+        return chain;
+    }
+
+    void release(unsigned int sizeClass, const PoolChain& chain){
+        if ( !chain.head )
+            return;
+        std::lock_guard<std::mutex> lock(mutex);
+        freeChains[sizeClass].push_back(chain);
+    }
+
+    std::mutex                mutex;
+    std::vector<PoolChain>    freeChains[PoolTotalSizeClasses];
+    std::atomic<std::int64_t> reservedBytes;
+    std::atomic<std::int64_t> pooledAllocations;
+    std::atomic<std::int64_t> largeAllocations;
+    std::atomic<std::int64_t> refills;
+};
+
+TreeSitterPool& treeSitterPool(){
+    // not destroyed, since parse trees may still be released during static destruction
+    static TreeSitterPool* pool = new TreeSitterPool;
+    return *pool;
+}
+
+/**
+ * Free blocks cached by the current thread. A thread that frees more blocks than it allocates, like
+ * one that deletes trees parsed elsewhere, hands them back in chains once its cache is full.
+ */
+class TreeSitterPoolCache{
+public:
+    TreeSitterPoolCache(){}
+    ~TreeSitterPoolCache(){
+        for ( unsigned int i = 0; i < PoolTotalSizeClasses; ++i )
+            treeSitterPool().release(i, chains[i]);
+        released() = true;
+    }
+
+    static bool& released(){
+        thread_local bool r = false;
+        return r;
+    }
+
+    void* allocate(unsigned int sizeClass){
+        PoolChain& chain = chains[sizeClass];
+        if ( !chain.head ){
+            chain = treeSitterPool().refill(sizeClass);
+            if ( !chain.head )
+                return nullptr;
+        }
+        PoolBlockHeader* header = chain.head;
+        chain.head = static_cast<PoolBlockHeader*>(poolNext(header));
+        --chain.count;
+        return poolPayload(header);
+    }
+
+    void free(PoolBlockHeader* header){
+        unsigned int sizeClass = header->sizeClass;
+        PoolChain& chain = chains[sizeClass];
+        if ( chain.count * (PoolHeaderSize + PoolSizeClasses[sizeClass]) >= 2 * PoolSlabSize ){
+            treeSitterPool().release(sizeClass, chain);
+            chain = PoolChain();
+        }
+        poolNext(header) = chain.head;
+        chain.head = header;
+        ++chain.count;
+    }
+
+    PoolChain chains[PoolTotalSizeClasses];
+};
+
+TreeSitterPoolCache* treeSitterPoolCache(){
+    if ( TreeSitterPoolCache::released() )
+        return nullptr;
+    thread_local TreeSitterPoolCache cache;
+    return &cache;
+}
+
+void* poolMalloc(size_t size){
+    unsigned int sizeClass = poolSizeClass(size);
+    void* p = nullptr;
+
+    if ( sizeClass == PoolLargeClass ){
+        void* block = std::malloc(PoolHeaderSize + size);
+        if ( !block )
+            return nullptr;
+        PoolBlockHeader* header = static_cast<PoolBlockHeader*>(block);
+        header->sizeClass = PoolLargeClass;
+        p = poolPayload(header);
+        ++treeSitterPool().largeAllocations;
+    } else {
+        TreeSitterPoolCache* cache = treeSitterPoolCache();
+        if ( cache ){
+            p = cache->allocate(sizeClass);
+        } else {
+            // thread is exiting, take a single block and return the rest
+            TreeSitterPool& pool = treeSitterPool();
+            PoolChain chain = pool.refill(sizeClass);
+            if ( chain.head ){
+                p = poolPayload(chain.head);
+                chain.head = static_cast<PoolBlockHeader*>(poolNext(chain.head));
+                --chain.count;
+                pool.release(sizeClass, chain);
+            }
+        }
+        if ( !p )
+            return nullptr;
+        ++treeSitterPool().pooledAllocations;
+    }
+
+    poolHeader(p)->size = size;
+    MemoryAccounting::add(MemoryAccounting::TreeSitter, size);
+    return p;
+}
+
+void* poolCalloc(size_t count, size_t size){
+    if ( size && count > static_cast<size_t>(-1) / size )
+        return nullptr;
+    void* p = poolMalloc(count * size);
+    if ( p )
+        std::memset(p, 0, count * size);
+    return p;
+}
+
+void poolFree(void* p){
+    if ( !p )
+        return;
+
+    PoolBlockHeader* header = poolHeader(p);
+    MemoryAccounting::remove(MemoryAccounting::TreeSitter, header->size);
+
+    if ( header->sizeClass == PoolLargeClass ){
+        std::free(header);
+        return;
+    }
+
+    TreeSitterPoolCache* cache = treeSitterPoolCache();
+    if ( cache ){
+        cache->free(header);
+    } else {
+        PoolChain chain;
+        poolNext(header) = nullptr;
+        chain.head = header;
+        chain.count = 1;
+        treeSitterPool().release(header->sizeClass, chain);
+    }
+}
+
+void* poolRealloc(void* p, size_t size){
+    if ( !p )
+        return poolMalloc(size);
+
+    PoolBlockHeader* header = poolHeader(p);
+    if ( header->sizeClass != PoolLargeClass && size <= PoolSizeClasses[header->sizeClass] ){
+        MemoryAccounting::remove(MemoryAccounting::TreeSitter, header->size);
+        MemoryAccounting::add(MemoryAccounting::TreeSitter, size);
+        header->size = size;
+        return p;
+    }
+
+    void* result = poolMalloc(size);
+    if ( !result )
+        return nullptr;
+    std::memcpy(result, p, header->size < size ? header->size : size);
+    poolFree(p);
+    return result;
+}
+
+std::mutex& allocatorMutex(){
+    static std::mutex mutex;
+    return mutex;
+}
+
+std::atomic<bool>& allocatorInstalled(){
+    static std::atomic<bool> installed(false);
+    return installed;
+}
+
+MemoryAccounting::TreeSitterAllocator& selectedAllocator(){
+    static MemoryAccounting::TreeSitterAllocator allocator = MemoryAccounting::SystemAllocator;
+    return allocator;
+}
+
+} // namespace
+
+/**
+ * \brief Enables or disables counting
+ *
+ * Blocks are counted when they are released only if they were counted when allocated, so this
+ * should be set before compiling, and before the first parser is created for tree-sitter
+ * allocations to be counted.
+ */
+void MemoryAccounting::setEnabled(bool enabled){
+    accountingEnabled.store(enabled);
+}
+
+bool MemoryAccounting::isEnabled(){
+    return accountingEnabled.load(std::memory_order_relaxed);
+}
+
+void MemoryAccounting::add(Category category, size_t bytes){
+    if ( !isEnabled() )
+        return;
+
+    CategoryCounter& counter = categoryCounters()[category];
+    std::int64_t value = counter.live += static_cast<std::int64_t>(bytes);
+    ++counter.allocations;
+    std::int64_t p = counter.peak;
+    while ( value > p && !counter.peak.compare_exchange_weak(p, value) ){}
+
+    MemoryAccountingFile* file = currentFile();
+    if ( file )
+        file->add(static_cast<std::int64_t>(bytes));
+}
+
+void MemoryAccounting::remove(Category category, size_t bytes){
+    if ( !isEnabled() )
+        return;
+    categoryCounters()[category].live -= static_cast<std::int64_t>(bytes);
+    MemoryAccountingFile* file = currentFile();
+    if ( file )
+        file->current -= static_cast<std::int64_t>(bytes);
+}
+
+std::int64_t MemoryAccounting::liveBytes(Category category){
+    return categoryCounters()[category].live;
+}
+
+std::int64_t MemoryAccounting::peakBytes(Category category){
+    return categoryCounters()[category].peak;
+}
+
+std::int64_t MemoryAccounting::totalLiveBytes(){
+    std::int64_t total = 0;
+    for ( int i = 0; i < TotalCategories; ++i )
+        total += categoryCounters()[i].live;
+    return total;
+}
+
+const char *MemoryAccounting::categoryName(Category category){
+    switch( category ){
+    case TreeSitter: return "treeSitter";
+    case Nodes:      return "nodes";
+    case Sections:   return "sections";
+    case Bindings:   return "bindings";
+    case Content:    return "content";
+    default:         return "";
+    }
+}
+
+/** Sets the peak of each category to its current live bytes */
+void MemoryAccounting::resetPeaks(){
+    for ( int i = 0; i < TotalCategories; ++i )
+        categoryCounters()[i].peak = categoryCounters()[i].live.load();
+}
+
+/** Drops the per file stats, which otherwise grow with every file compiled */
+void MemoryAccounting::clearFiles(){
+    std::lock_guard<std::mutex> lock(filesMutex());
+    files().clear();
+}
+
+/**
+ * \brief Returns live, peak and allocation counts per category, and per file stats
+ *
+ * File stats contain the bytes allocated while the file was active, and the peak of allocated minus
+ * released bytes. Releases are attributed to whichever file is active when they happen.
+ */
+MLNode MemoryAccounting::toMLNode(){
+    MLNode result(MLNode::Object);
+    result["enabled"] = isEnabled();
+
+    MLNode categories(MLNode::Object);
+    for ( int i = 0; i < TotalCategories; ++i ){
+        CategoryCounter& counter = categoryCounters()[i];
+        MLNode c(MLNode::Object);
+        c["liveBytes"]   = static_cast<MLNode::IntType>(counter.live);
+        c["peakBytes"]   = static_cast<MLNode::IntType>(counter.peak);
+        c["allocations"] = static_cast<MLNode::IntType>(counter.allocations);
+        categories[categoryName(static_cast<Category>(i))] = c;
+    }
+    result["categories"] = categories;
+    result["totalLiveBytes"] = static_cast<MLNode::IntType>(totalLiveBytes());
+
+    MLNode fileStats(MLNode::Object);
+    {
+        std::lock_guard<std::mutex> lock(filesMutex());
+        for ( auto it = files().begin(); it != files().end(); ++it ){
+            MLNode f(MLNode::Object);
+            f["allocatedBytes"] = static_cast<MLNode::IntType>(it->second->allocated);
+            f["peakBytes"]      = static_cast<MLNode::IntType>(it->second->peak);
+            fileStats[it->first] = f;
+        }
+    }
+    result["files"] = fileStats;
+
+    if ( treeSitterAllocator() == PoolAllocator ){
+        result["treeSitterAllocator"] = "pool";
+        result["treeSitterPool"] = treeSitterPoolStats();
+    } else {
+        result["treeSitterAllocator"] = "system";
+    }
+
+    return result;
+}
+
+/**
+ * \brief Selects the allocator installed for tree-sitter
+ *
+ * Memory allocated by one allocator cannot be released by the other, so the allocator can only be
+ * selected before it's installed, which happens when the first parser or query is created. Returns
+ * whether \p allocator is the one in use.
+ */
+bool MemoryAccounting::setTreeSitterAllocator(TreeSitterAllocator allocator){
+    std::lock_guard<std::mutex> lock(allocatorMutex());
+    if ( !allocatorInstalled() )
+        selectedAllocator() = allocator;
+    return selectedAllocator() == allocator;
+}
+
+MemoryAccounting::TreeSitterAllocator MemoryAccounting::treeSitterAllocator(){
+    std::lock_guard<std::mutex> lock(allocatorMutex());
+    return selectedAllocator();
+}
+
+/**
+ * \brief Routes tree-sitter allocations through the selected allocator
+ *
+ * Called before tree-sitter objects are created. Installing is done only once. The system
+ * allocator is only wrapped for counting when accounting is enabled, otherwise tree-sitter keeps
+ * calling malloc directly.
+ */
+void MemoryAccounting::installTreeSitterAllocator(){
+    if ( allocatorInstalled() )
+        return;
+
+    std::lock_guard<std::mutex> lock(allocatorMutex());
+    if ( allocatorInstalled() )
+        return;
+
+    if ( selectedAllocator() == PoolAllocator ){
+        ts_set_allocator(&poolMalloc, &poolCalloc, &poolRealloc, &poolFree);
+    } else if ( isEnabled() ){
+        ts_set_allocator(&treeSitterMalloc, &treeSitterCalloc, &treeSitterRealloc, &treeSitterFree);
+    }
+    allocatorInstalled() = true;
+}
+
+/**
+ * \brief Allocates \p size bytes with the allocator installed for tree-sitter, installing it if needed
+ *
+ * For buffers handed over to tree-sitter, which releases them with its own allocator.
+ */
+void *MemoryAccounting::allocateTreeSitterMemory(size_t size){
+    installTreeSitterAllocator();
+    return ts_malloc(size);
+}
+
+void *MemoryAccounting::reallocateTreeSitterMemory(void *p, size_t size){
+    installTreeSitterAllocator();
+    return ts_realloc(p, size);
+}
+
+/**
+ * \brief Releases \p p, allocated by tree-sitter and handed over to the caller, like the result of
+ * ts_node_string()
+ *
+ * Goes through the installed allocator, since blocks from the pool allocator cannot be passed to free().
+ */
+void MemoryAccounting::freeTreeSitterMemory(void *p){
+    ts_free(p);
+}
+
+/**
+ * \brief Returns the bytes reserved by the tree-sitter pools and how allocations were served
+ *
+ * Large allocations are the ones above the biggest size class, which go straight to malloc. Refills
+ * count the times a thread ran out of blocks of a size class.
+ */
+MLNode MemoryAccounting::treeSitterPoolStats(){
+    TreeSitterPool& pool = treeSitterPool();
+    MLNode result(MLNode::Object);
+    result["reservedBytes"]     = static_cast<MLNode::IntType>(pool.reservedBytes);
+    result["pooledAllocations"] = static_cast<MLNode::IntType>(pool.pooledAllocations);
+    result["largeAllocations"]  = static_cast<MLNode::IntType>(pool.largeAllocations);
+    result["refills"]           = static_cast<MLNode::IntType>(pool.refills);
+    return result;
+}
+
+// class MemoryAccounting::FileScope
+// ----------------------------------------------------------------------------
+
+MemoryAccounting::FileScope::FileScope(const std::string &path)
+    : m_previous(currentFile())
+{
+    if ( !isEnabled() )
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(filesMutex());
+        auto& file = files()[path];
+        if ( !file )
+            file.reset(new MemoryAccountingFile);
+        m_file = file;
+    }
+    currentFile() = m_file.get();
+}
+
+MemoryAccounting::FileScope::~FileScope(){
+    currentFile() = m_previous;
+}
+
+}} // namespace lv, el
@@ -0,0 +1,101 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 Dinu SV.
+** This file is part of Livekeys Application.
+**
+** GNU Lesser General Public License Usage
+** This file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+****************************************************************************/
+
+#ifndef LVMEMORYACCOUNTING_H
+#define LVMEMORYACCOUNTING_H
+
+#include "live/elements/compiler/lvelcompilerglobal.h"
+#include "live/mlnode.h"
+
+#include <string>
+#include <memory>
+#include <cstdint>
+
+namespace lv{ namespace el{
+
+class MemoryAccountingFile;
+class LV_ELEMENTS_COMPILER_EXPORT MemoryAccounting{
+
+public:
+    enum Category{
+        /** Tree-sitter parse trees, parsers and queries */
+        TreeSitter = 0,
+        /** BaseNode graphs */
+        Nodes,
+        /** Insertion sections produced during conversion */
+        Sections,
+        /** PropertyBindingContainer tries */
+        Bindings,
+        /** Source contents retained by module files */
+        Content,
+        TotalCategories
+    };
+
+    enum TreeSitterAllocator{
+        /** Allocations go to malloc, counted with the block size reported by the system */
+        SystemAllocator = 0,
+        /** Allocations come from thread-local size-class pools, counted with their requested size */
+        PoolAllocator
+    };
+
+    /**
+     * \class lv::el::MemoryAccounting::FileScope
+     * \brief Attributes allocations on the current thread to a file until the scope ends
+     */
+    class LV_ELEMENTS_COMPILER_EXPORT FileScope{
+
+        DISABLE_COPY(FileScope);
+
+    public:
+        FileScope(const std::string& path);
+        ~FileScope();
+
+    private:
+        std::shared_ptr<MemoryAccountingFile> m_file;
+        MemoryAccountingFile*                 m_previous;
+    };
+
+public:
+    static void setEnabled(bool enabled);
+    static bool isEnabled();
+
+    static void add(Category category, size_t bytes);
+    static void remove(Category category, size_t bytes);
+
+    static std::int64_t liveBytes(Category category);
+    static std::int64_t peakBytes(Category category);
+    static std::int64_t totalLiveBytes();
+    static const char* categoryName(Category category);
+
+    static void resetPeaks();
+    static void clearFiles();
+
+    static MLNode toMLNode();
+
+    static bool setTreeSitterAllocator(TreeSitterAllocator allocator);
+    static TreeSitterAllocator treeSitterAllocator();
+    static void installTreeSitterAllocator();
+    static void* allocateTreeSitterMemory(size_t size);
+    static void* reallocateTreeSitterMemory(void* p, size_t size);
+    static void freeTreeSitterMemory(void* p);
+    static MLNode treeSitterPoolStats();
+
+private:
+    MemoryAccounting();
+};
+
+}} // namespace lv, el
+
+#endif // LVMEMORYACCOUNTING_H
@@ -15,6 +15,7 @@
 
 #include "modulefile.h"
 #include "languagenodes_p.h"
+#include "memoryaccounting.h"
 #include "live/elements/compiler/languageparser.h"
 #include "live/exception.h"
 #include "live/package.h"
@@ -23,6 +24,7 @@
 #include "live/packagegraph.h"
 #include "live/utf8.h"
 #include "live/visuallog.h"
+#include "live/tracer.h"
 
 #include <sstream>
 
@@ -47,6 +49,7 @@ public:
 };
 
 ModuleFile::~ModuleFile(){
+    MemoryAccounting::remove(MemoryAccounting::Content, m_d->content.capacity());
     delete m_d->compilationData;
     LanguageParser::destroy(m_d->ast);
     delete m_d->rootNode;
@@ -100,73 +103,11 @@ void ModuleFile::resolveTypes(){
                             if ( !foundFile ){
                                 THROW_EXCEPTION(Exception, Utf8("Assertion: File not found: %").format(foundExp.file()->fileName()), Exception::toCode("NullPtr"));
                             }
-                            if ( impIt->isRelative ){
-                                // this plugin to package
-                                Utf8 currentImportId = m_d->elementsModule->module()->context()->importId;
-                                Package::Ptr importedPkg = impIt->module->module()->context()->packageUnwrapped();
-                                if ( !importedPkg ){
-                                    THROW_EXCEPTION(Exception,
-                                        Utf8("ModuleFile::resolveTypes (relative): Package expired or unset for imported module (path %, importId %).")
-                                            .format(impIt->module->module()->path(), impIt->module->module()->context()->importId.data()),
-                                        Exception::toCode("~NullPtr"));
-                                }
-                                Utf8 packageName = importedPkg->nameScopeAsPath();
-                                Utf8 packageToPluginName = currentImportId.length() > packageName.length() 
-                                    ? currentImportId.substr(packageName.length() + 1, std::string::npos)
-                                    : "";
-
-                                std::vector<Utf8> parts = packageToPluginName.split(".");
-                                std::string pluginToPackage = "";
-                                if ( parts.size() > 0 ){
-                                    for ( size_t i = 0; i < parts.size(); ++i ){
-                                        if ( !pluginToPackage.empty() )
-                                            pluginToPackage += '/';
-                                        pluginToPackage += "..";
-                                    }
-                                } else {
-                                    pluginToPackage = ".";
-                                }
-
-                                // package to new plugin
-
-                                Utf8 newPluginImportId = impIt->module->module()->context()->importId;
-
-                                Utf8 packageToNewPluginUri = newPluginImportId.length() > packageName.length() 
-                                    ? newPluginImportId.substr(packageName.length() + 1, std::string::npos)
-                                    : "";
-
-                                std::vector<Utf8> packageToNewPluginParts = packageToNewPluginUri.split(".");
-
-                                std::string packageToNewPlugin = Utf8::join(packageToNewPluginParts, "/").data();
-                                if ( !packageToNewPlugin.empty() )
-                                    packageToNewPlugin += "/";
-
-                                m_d->rootNode->resolveImport(impType.importNamespace, impType.name, pluginToPackage + "/" + packageToNewPlugin + foundFile->jsFileName());
-
-                            } else {
-                                Package::Ptr importedPkg = impIt->module->module()->context()->packageUnwrapped();
-                                if ( !importedPkg ){
-                                    THROW_EXCEPTION(Exception,
-                                        Utf8("ModuleFile::resolveTypes (absolute): Package expired or unset for imported module (path %, importId %).")
-                                            .format(impIt->module->module()->path(), impIt->module->module()->context()->importId.data()),
-                                        Exception::toCode("~NullPtr"));
-                                }
-                                Utf8 packageName = importedPkg->nameScopeAsPath();
-                                Utf8 importId = impIt->module->module()->context()->importId;
-                                Utf8 packageToPluginName =  importId.length() > packageName.length() 
-                                    ? importId.substr(packageName.length() + 1, std::string::npos)
-                                    : "";
-
-                                std::vector<Utf8> packageToPlugin = packageToPluginName.split(".");
-
-                                std::string configPackageBuildPath = m_d->elementsModule->compiler()->packageBuildPath();
-                                std::string packageBuildPath = packageName.data() +
-                                    (configPackageBuildPath.empty() ? "" : "/" + configPackageBuildPath);
-                                std::string packageToPluginStr = Utf8::join(packageToPlugin, "/").data();
-                                std::string importPath = packageBuildPath + (packageToPluginStr.empty() ? "" : "/" + packageToPluginStr) + "/" + foundFile->jsFileName();
-
-                                m_d->rootNode->resolveImport(impType.importNamespace, impType.name, importPath);
-                            }
+                            m_d->rootNode->resolveImport(
+                                impType.importNamespace,
+                                impType.name,
+                                m_d->elementsModule->importPathPrefix(impIt->module.get(), impIt->isRelative) + foundFile->jsFileName()
+                            );
                             break;
                         }
                     }
@@ -181,6 +122,8 @@ void ModuleFile::resolveTypes(){
 
 void ModuleFile::compile(){
     if ( m_d->status != ModuleFile::Compiled ){
+        LV_TRACE_SCOPE_DETAIL("compile", "ModuleFile::compile", filePath());
+        MemoryAccounting::FileScope memoryScope(filePath());
         if ( !m_d->rootNode ){
             THROW_EXCEPTION(lv::Exception, Utf8("Assertion: ModuleFile being compiled without parsed node."), Exception::toCode("~NullPtr"));
         }
@@ -229,12 +172,14 @@ const ModuleFileDescriptor::Ptr &ModuleFile::descriptor() const{
 }
 
 void ModuleFile::addDependency(ModuleFile *dependency){
-    if ( dependency == this )
+    if ( dependency == this || hasDependency(this, dependency) )
         return;
-    m_d->dependencies.push_back(dependency);
-    dependency->m_d->dependents.push_back(this);
 
-    PackageGraph::CyclesResult<ModuleFile*> cr = checkCycles(this);
+    PackageGraph::CyclesResult<ModuleFile*> cr = m_d->elementsModule->fileOrder().addDependency(
+        this, dependency,
+        [](ModuleFile* mf) -> const std::list<ModuleFile*>& { return mf->m_d->dependencies; },
+        [](ModuleFile* mf) -> const std::list<ModuleFile*>& { return mf->m_d->dependents; }
+    );
     if ( cr.found() ){
         std::stringstream ss;
 
@@ -245,21 +190,11 @@ void ModuleFile::addDependency(ModuleFile *dependency){
             ss << n->name();
         }
 
-        for ( auto it = m_d->dependencies.begin(); it != m_d->dependencies.end(); ++it ){
-            if ( *it == dependency ){
-                m_d->dependencies.erase(it);
-                break;
-            }
-        }
-        for ( auto it = dependency->m_d->dependents.begin(); it != dependency->m_d->dependents.end(); ++it ){
-            if ( *it == this ){
-                dependency->m_d->dependents.erase(it);
-                break;
-            }
-        }
-
         THROW_EXCEPTION(lv::Exception, "Module file dependency cycle found: "  + ss.str(), lv::Exception::toCode("Cycle"));
     }
+
+    m_d->dependencies.push_back(dependency);
+    dependency->m_d->dependents.push_back(this);
 }
 
 void ModuleFile::setCompilationData(CompilationData *cd){
@@ -276,33 +211,6 @@ bool ModuleFile::hasDependency(ModuleFile *module, ModuleFile *dependency){
     return false;
 }
 
-PackageGraph::CyclesResult<ModuleFile *> ModuleFile::checkCycles(ModuleFile *mf){
-    std::list<ModuleFile*> path;
-    path.push_back(mf);
-
-    for ( auto it = mf->m_d->dependencies.begin(); it != mf->m_d->dependencies.end(); ++it ){
-        PackageGraph::CyclesResult<ModuleFile*> cr = checkCycles(mf, *it, path);
-        if ( cr.found() )
-            return cr;
-    }
-    return PackageGraph::CyclesResult<ModuleFile*>(PackageGraph::CyclesResult<ModuleFile*>::NotFound);;
-}
-
-PackageGraph::CyclesResult<ModuleFile*> ModuleFile::checkCycles(
-        ModuleFile *mf, ModuleFile *current, std::list<ModuleFile *> path)
-{
-    path.push_back(current);
-    if ( current == mf )
-        return PackageGraph::CyclesResult<ModuleFile*>(PackageGraph::CyclesResult<ModuleFile*>::Found, path);
-
-    for ( auto it = current->m_d->dependencies.begin(); it != current->m_d->dependencies.end(); ++it ){
-        PackageGraph::CyclesResult<ModuleFile*> cr = checkCycles(mf, *it, path);
-        if ( cr.found() )
-            return cr;
-    }
-    return PackageGraph::CyclesResult<ModuleFile*>(PackageGraph::CyclesResult<ModuleFile*>::NotFound);
-}
-
 ModuleFile *ModuleFile::createFromProgramNode(ElementsModule *module, const std::string &name, const std::string &content, ProgramNode *node, LanguageParser::AST *ast){
     auto descriptor = ModuleFileDescriptor::create(name);
 
@@ -363,6 +271,7 @@ ModuleFile::ModuleFile(
     m_d->name = componentName;
     m_d->status = ModuleFile::Initiaized;
     m_d->content = content;
+    MemoryAccounting::add(MemoryAccounting::Content, m_d->content.capacity());
     m_d->rootNode = node;
     m_d->ast = ast;
     m_d->descriptor = mfd;
@@ -84,8 +84,6 @@ private:
     void setCompilationData(CompilationData* cd);
 
     bool hasDependency(ModuleFile* module, ModuleFile* dependency);
-    static PackageGraph::CyclesResult<ModuleFile*> checkCycles(ModuleFile* mf);
-    static PackageGraph::CyclesResult<ModuleFile*> checkCycles(ModuleFile* mf, ModuleFile* current, std::list<ModuleFile*> path);
 
 
     static ModuleFile* createFromProgramNode(
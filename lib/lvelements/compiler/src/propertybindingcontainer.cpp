@@ -1,10 +1,28 @@
 #include "propertybindingcontainer_p.h"
 #include "languagenodes_p.h"
+#include "memoryaccounting.h"
 
 #include "live/visuallog.h"
 
 namespace lv{ namespace el{
 
+namespace{
+
+const size_t MaxScannedNodes = 8;
+
+/// Same order as MemberExpressionNode::identifierChain, without copying the names
+void collectIdentifierChain(BaseNode* node, std::vector<BaseNode*>& chain){
+    for ( auto child : node->children() ){
+        if ( child->isNodeType<IdentifierNode>() ){
+            chain.push_back(child);
+        } else if ( child->canCast<MemberExpressionNode>() ){
+            collectIdentifierChain(child, chain);
+        }
+    }
+}
+
+} // namespace
+
 // PropertyBindingContainer::Node
 // ------------------------------------------------------------------
 
@@ -14,34 +32,71 @@ PropertyBindingContainer::Node::~Node(){
     }
 }
 
-PropertyBindingContainer::Node *PropertyBindingContainer::Node::findNextIdentifier(const std::string &name) const{
+void *PropertyBindingContainer::Node::operator new(size_t size){
+    MemoryAccounting::add(MemoryAccounting::Bindings, size);
+    return ::operator new(size);
+}
+
+void PropertyBindingContainer::Node::operator delete(void *p, size_t size){
+    MemoryAccounting::remove(MemoryAccounting::Bindings, size);
+    ::operator delete(p);
+}
+
+/**
+ * Names are interned by the container, so children are matched by address. Nodes with few children are
+ * scanned, larger ones are looked up through nextIndex.
+ */
+PropertyBindingContainer::Node *PropertyBindingContainer::Node::findNextIdentifier(const std::string *internedName) const{
+    if ( !nextIndex.empty() ){
+        auto it = nextIndex.find(internedName);
+        return it != nextIndex.end() ? it->second : nullptr;
+    }
     for ( auto it = next.begin(); it != next.end(); ++it ){
-        if ( (*it)->name == name ){
+        if ( (*it)->name == internedName ){
             return *it;
         }
     }
     return nullptr;
 }
 
+PropertyBindingContainer::Node *PropertyBindingContainer::Node::addNextIdentifier(const std::string *internedName){
+    Node* node = new Node(internedName);
+    node->parent = this;
+    next.push_back(node);
+
+    if ( !nextIndex.empty() ){
+        nextIndex.emplace(internedName, node);
+    } else if ( next.size() > MaxScannedNodes ){
+        for ( auto it = next.begin(); it != next.end(); ++it )
+            nextIndex.emplace((*it)->name, *it);
+    }
+    return node;
+}
+
 // PropertyBindingContainer
 // ------------------------------------------------------------------
 
-PropertyBindingContainer::PropertyBindingContainer(){
+PropertyBindingContainer::PropertyBindingContainer()
+    : m_identifiersCollected(false)
+{
 }
 
 PropertyBindingContainer::~PropertyBindingContainer(){
+    clearBindingIdentifiers();
 }
 
 void PropertyBindingContainer::addBinding(BaseNode *binding){
     m_bindings.push_back(binding);
+    clearBindingIdentifiers();
 }
 
 void PropertyBindingContainer::setDeclarationCheck(std::function<bool (const std::string&, const std::string &, BaseNode *)> fn){
     m_declarationCheck = fn;
+    clearBindingIdentifiers();
 }
 
 std::string PropertyBindingContainer::bindingIdentifiersToString(const std::string &source) const{
-    auto result = bindingIdentifiers(source);
+    const std::vector<Node*>& result = bindingIdentifiers(source);
 
     if ( result.empty() )
         return "";
@@ -51,15 +106,13 @@ std::string PropertyBindingContainer::bindingIdentifiersToString(const std::stri
         if ( it != result.begin() )
             stringResult += "\n";
         stringResult += bindingIdentifierToString(*it);
-        delete *it;
     }
-    result.clear();
 
     return stringResult;
 }
 
 std::string PropertyBindingContainer::bindingIdentifiersToJs(const std::string &source) const{
-    auto result = bindingIdentifiers(source);
+    const std::vector<Node*>& result = bindingIdentifiers(source);
 
     if ( result.empty() )
         return "";
@@ -69,9 +122,7 @@ std::string PropertyBindingContainer::bindingIdentifiersToJs(const std::string &
         if ( it != result.begin() )
             stringResult += ",";
         stringResult += bindingIdentifierToJs(*it);
-        delete *it;
     }
-    result.clear();
 
     return stringResult + "]";
 }
@@ -92,70 +143,82 @@ std::string PropertyBindingContainer::bindingIdentifiersToJs(const std::string &
                 -> b -> c
       [[this, [y, a, [b, c] ] ], ...]
 */
-std::vector<PropertyBindingContainer::Node *> PropertyBindingContainer::bindingIdentifiers(const std::string& source) const{
-    std::vector<PropertyBindingContainer::Node*> result;
+
+/**
+ * Builds the identifier trie on first use and keeps it until the bindings or the declaration check
+ * change, so both emitters share it. The bindings are parsed from a single source, so \p source is
+ * only read while the trie is built.
+ */
+const std::vector<PropertyBindingContainer::Node *>& PropertyBindingContainer::bindingIdentifiers(const std::string& source) const{
+    if ( m_identifiersCollected )
+        return m_identifiers;
+
+    clearBindingIdentifiers();
+
+    std::vector<BaseNode*> identifierChain;
+    std::string nameBuffer;
 
     for (auto idx = m_bindings.begin(); idx != m_bindings.end(); ++idx){
         BaseNode* node = *idx;
         if (node->isNodeType<MemberExpressionNode>() ){
-            MemberExpressionNode* men = node->as<MemberExpressionNode>();
-            auto identifierChain = men->identifierChain(source);
+            identifierChain.clear();
+            collectIdentifierChain(node, identifierChain);
 
             if ( identifierChain.size() > 1 ){
-                std::string startPoint = identifierChain.front();
+                BaseNode* start = identifierChain.front();
+                nameBuffer.assign(source, start->startByte(), start->endByte() - start->startByte());
+                const std::string* startPoint = internName(nameBuffer);
 
-                bool isDeclaredInScope = m_declarationCheck && m_declarationCheck(source, startPoint, node);
+                bool isDeclaredInScope = m_declarationCheck && m_declarationCheck(source, *startPoint, node);
                 if ( isDeclaredInScope )
                     continue;
-                bool isImport = startPoint == "import";
+                bool isImport = *startPoint == "import";
                 if ( isImport )
                     continue;
 
-                PropertyBindingContainer::Node* foundNode = nullptr;
-                for ( auto fit = result.begin(); fit != result.end(); ++fit ){
-                    if ( (*fit)->name == startPoint ){
-                        foundNode = *fit;
-                        break;
-                    }
+                PropertyBindingContainer::Node* current = nullptr;
+                auto rootIt = m_identifiersIndex.find(startPoint);
+                if ( rootIt == m_identifiersIndex.end() ){
+                    current = new PropertyBindingContainer::Node(startPoint);
+                    m_identifiers.push_back(current);
+                    m_identifiersIndex.emplace(startPoint, current);
+                } else {
+                    current = rootIt->second;
                 }
 
-                if ( !foundNode ){
-                    PropertyBindingContainer::Node* node = new PropertyBindingContainer::Node;
-                    node->name = startPoint;
-                    result.push_back(node);
-                    for ( size_t i = 1; i < identifierChain.size(); ++i ){
-                        PropertyBindingContainer::Node* newNode = new PropertyBindingContainer::Node;
-                        newNode->name = identifierChain[i];
-                        node->next.push_back(newNode);
-                        node = newNode;
-                    }
-                } else {
-                    PropertyBindingContainer::Node* node = foundNode;
-                    for ( size_t i = 1; i < identifierChain.size(); ++i ){
-                        PropertyBindingContainer::Node* nextNode = node->findNextIdentifier(identifierChain[i]);
-                        if ( !nextNode ){
-                            for ( size_t j = i; j < identifierChain.size(); ++j ){
-                                PropertyBindingContainer::Node* newNode = new PropertyBindingContainer::Node;
-                                newNode->name = identifierChain[j];
-                                node->next.push_back(newNode);
-                                node = newNode;
-                            }
-                            break;
-                        } else {
-                            node = nextNode;
-                        }
-                    }
+                for ( size_t i = 1; i < identifierChain.size(); ++i ){
+                    BaseNode* identifier = identifierChain[i];
+                    nameBuffer.assign(source, identifier->startByte(), identifier->endByte() - identifier->startByte());
+                    const std::string* name = internName(nameBuffer);
+
+                    PropertyBindingContainer::Node* nextNode = current->findNextIdentifier(name);
+                    current = nextNode ? nextNode : current->addNextIdentifier(name);
                 }
             }
         }
     }
-    return result;
+
+    m_identifiersCollected = true;
+    return m_identifiers;
+}
+
+void PropertyBindingContainer::clearBindingIdentifiers() const{
+    for ( auto it = m_identifiers.begin(); it != m_identifiers.end(); ++it )
+        delete *it;
+    m_identifiers.clear();
+    m_identifiersIndex.clear();
+    m_names.clear();
+    m_identifiersCollected = false;
+}
+
+const std::string *PropertyBindingContainer::internName(const std::string &name) const{
+    return &*m_names.insert(name).first;
 }
 
 std::string PropertyBindingContainer::bindingIdentifierToString(PropertyBindingContainer::Node *n) const{
     std::string result;
     if ( n->next.size() > 0 ){
-        result = "[" + n->name;
+        result = "[" + *n->name;
 
         for ( auto it = n->next.begin(); it != n->next.end(); ++it ){
             result += "," + bindingIdentifierToString(*it);
@@ -163,7 +226,7 @@ std::string PropertyBindingContainer::bindingIdentifierToString(PropertyBindingC
 
         result += "]";
     } else {
-        result += n->name;
+        result += *n->name;
     }
     return result;
 }
@@ -171,7 +234,7 @@ std::string PropertyBindingContainer::bindingIdentifierToString(PropertyBindingC
 std::string PropertyBindingContainer::bindingIdentifierToJs(PropertyBindingContainer::Node *n) const{
     std::string result;
     if ( n->next.size() > 0 ){
-        result = "[" + n->name;
+        result = "[" + *n->name;
 
         for ( auto it = n->next.begin(); it != n->next.end(); ++it ){
             result += "," + bindingIdentifierPropertyToJs(*it);
@@ -179,7 +242,7 @@ std::string PropertyBindingContainer::bindingIdentifierToJs(PropertyBindingConta
 
         result += "]";
     } else {
-        result += n->name;
+        result += *n->name;
     }
     return result;
 }
@@ -189,9 +252,9 @@ std::string PropertyBindingContainer::bindingIdentifierPropertyToJs(PropertyBind
     if ( n->next.size() > 0 ){
         result = "[";
         if ( n->event.length() > 0 ){
-            result += "{n: '" + n->name + "',e: '" + n->event + "'}";
+            result += "{n: '" + *n->name + "',e: '" + n->event + "'}";
         } else {
-            result += "'" + n->name + "'";
+            result += "'" + *n->name + "'";
         }
 
         for ( auto it = n->next.begin(); it != n->next.end(); ++it ){
@@ -201,9 +264,9 @@ std::string PropertyBindingContainer::bindingIdentifierPropertyToJs(PropertyBind
         result += "]";
     } else {
         if ( n->event.length() > 0 ){
-            result = "{n: '" + n->name + "',e: '" + n->event + "'}";
+            result = "{n: '" + *n->name + "',e: '" + n->event + "'}";
         } else {
-            result = "'" + n->name + "'";
+            result = "'" + *n->name + "'";
         }
     }
     return result;
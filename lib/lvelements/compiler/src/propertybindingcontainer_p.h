@@ -3,6 +3,8 @@
 
 #include <vector>
 #include <functional>
+#include <unordered_map>
+#include <unordered_set>
 #include "live/utf8.h"
 
 namespace lv{ namespace el{
@@ -11,18 +13,25 @@ class BaseNode;
 
 class PropertyBindingContainer{
 
+    DISABLE_COPY(PropertyBindingContainer);
+
 public:
     class Node{
     public:
-        Node() : parent(nullptr){}
+        Node(const std::string* n) : name(n), parent(nullptr){}
 
         ~Node();
-        Node* findNextIdentifier(const std::string& name) const;
 
-        std::string name;
-        std::string event;
-        Node*       parent;
+        static void* operator new(size_t size);
+        static void operator delete(void* p, size_t size);
+        Node* findNextIdentifier(const std::string* internedName) const;
+        Node* addNextIdentifier(const std::string* internedName);
+
+        const std::string* name;
+        std::string        event;
+        Node*              parent;
         std::vector<Node*> next;
+        std::unordered_map<const std::string*, Node*> nextIndex;
     };
 
 public:
@@ -38,13 +47,20 @@ public:
     std::string bindingIdentifiersToJs(const std::string& source) const;
 
 private:
-    std::vector<Node*> bindingIdentifiers(const std::string& source) const;
+    const std::vector<Node*>& bindingIdentifiers(const std::string& source) const;
+    void clearBindingIdentifiers() const;
+    const std::string* internName(const std::string& name) const;
     std::string bindingIdentifierToString(Node* n) const;
     std::string bindingIdentifierToJs(Node* n) const;
     std::string bindingIdentifierPropertyToJs(Node* n) const;
 
     std::function<bool(const std::string&, const std::string&, BaseNode*)> m_declarationCheck;
     std::vector<BaseNode*> m_bindings;
+
+    mutable bool                            m_identifiersCollected;
+    mutable std::vector<Node*>              m_identifiers;
+    mutable std::unordered_map<const std::string*, Node*> m_identifiersIndex;
+    mutable std::unordered_set<std::string> m_names;
 };
 
 inline size_t PropertyBindingContainer::totalStoredBindings() const{
@@ -0,0 +1,549 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 Dinu SV.
+** This file is part of Livekeys Application.
+**
+** GNU Lesser General Public License Usage
+** This file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+****************************************************************************/
+
+#include "live/commandlineparser.h"
+#include "live/fileio.h"
+#include "live/path.h"
+#include "live/directory.h"
+#include "live/mlnode.h"
+#include "live/mlnodetojson.h"
+#include "live/elements/compiler/compiler.h"
+#include "live/elements/compiler/languageparser.h"
+#include "live/elements/compiler/importscanner.h"
+#include "live/elements/compiler/memoryaccounting.h"
+
+#include "languagenodes_p.h"
+#include "languagenodestojs_p.h"
+#include "elementssections_p.h"
+#include "projectgenerator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+
+#ifdef PLATFORM_OS_UNIX
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+// Allocation counting
+// ----------------------------------------------------------------------------
+
+namespace{
+
+std::atomic<size_t> allocationCount(0);
+std::atomic<size_t> allocationBytes(0);
+
+} // namespace
+
+void* operator new(size_t size){
+    ++allocationCount;
+    allocationBytes += size;
+    void* p = std::malloc(size > 0 ? size : 1);
+    if ( !p )
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept{
+    std::free(p);
+}
+
+namespace{
+
+using namespace lv;
+using namespace lv::el;
+
+class BenchInput{
+public:
+    std::string name;
+    std::string path;
+    std::string contents;
+};
+
+/** Measurements for one phase over one input, accumulated across iterations */
+class PhaseResult{
+public:
+    PhaseResult(const std::string& pName) : name(pName), totalNs(0), minNs(0), allocations(0), allocatedBytes(0), runs(0){}
+
+    void add(long long ns, size_t allocs, size_t bytes){
+        totalNs += ns;
+        minNs = (runs == 0 || ns < minNs) ? ns : minNs;
+        allocations += allocs;
+        allocatedBytes += bytes;
+        ++runs;
+    }
+
+    long long meanNs() const{ return runs > 0 ? totalNs / static_cast<long long>(runs) : 0; }
+
+    std::string name;
+    long long   totalNs;
+    long long   minNs;
+    size_t      allocations;
+    size_t      allocatedBytes;
+    size_t      runs;
+};
+
+class InputResult{
+public:
+    std::string              name;
+    size_t                   bytes;
+    size_t                   nodes;
+    std::vector<PhaseResult> phases;
+
+    PhaseResult& phase(const std::string& name){
+        for ( auto& p : phases )
+            if ( p.name == name )
+                return p;
+        phases.push_back(PhaseResult(name));
+        return phases.back();
+    }
+};
+
+/** Runs \p fn once, adding its time and allocations to \p result */
+void measure(PhaseResult& result, const std::function<void()>& fn){
+    size_t allocs = allocationCount;
+    size_t bytes  = allocationBytes;
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto end = std::chrono::steady_clock::now();
+    result.add(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count(),
+        allocationCount - allocs,
+        allocationBytes - bytes
+    );
+}
+
+size_t countNodes(BaseNode* node){
+    size_t count = 1;
+    for ( BaseNode* child : node->children() )
+        count += countNodes(child);
+    return count;
+}
+
+BaseNode::ConversionContext* createContext(BaseNode::ConversionContext::OutputTarget target){
+    BaseNode::ConversionContext* ctx = new BaseNode::ConversionContext;
+    ctx->implicitTypes = {"console", "vlog"};
+    ctx->allowUnresolved = true;
+    ctx->outputTarget = target;
+    return ctx;
+}
+
+Compiler::Ptr createCompiler(Compiler::Config::OutputTarget target){
+    Compiler::Config config(false);
+    config.allowUnresolvedTypes(true);
+    config.outputTarget(target);
+    config.enableFileStatCache(true);
+    Compiler::Ptr compiler = Compiler::create(config);
+    compiler->configureImplicitType("console");
+    compiler->configureImplicitType("vlog");
+    return compiler;
+}
+
+void runInput(const BenchInput& input, InputResult& result, size_t iterations){
+    LanguageParser::Ptr parser = LanguageParser::createForElements();
+    std::string fileName = Path::baseName(input.path);
+
+    Compiler::Ptr compiler = createCompiler(Compiler::Config::JS);
+    Compiler::Ptr tsCompiler = createCompiler(Compiler::Config::TS);
+    Compiler::Ptr dtsCompiler = createCompiler(Compiler::Config::JS_DTS);
+
+    result.name = input.name;
+    result.bytes = input.contents.size();
+    result.nodes = 0;
+
+    for ( size_t i = 0; i < iterations; ++i ){
+        LanguageParser::AST* ast = nullptr;
+        ProgramNode* root = nullptr;
+
+        measure(result.phase("importScan"), [&](){ ImportScanner::scan(input.contents, fileName); });
+        measure(result.phase("parse"), [&](){ ast = parser->parse(input.contents); });
+        measure(result.phase("visit"), [&](){ root = compiler->parseProgramNodes(input.path, fileName, ast); });
+        if ( !root ){
+            LanguageParser::destroy(ast);
+            THROW_EXCEPTION(lv::Exception, Utf8("Failed to parse: %").format(input.path), Exception::toCode("~Parse"));
+        }
+        result.nodes = countNodes(root);
+
+        BaseNode::ConversionContext* ctx = createContext(BaseNode::ConversionContext::JS);
+        measure(result.phase("collectImportTypes"), [&](){ root->collectImportTypes(input.contents, ctx); });
+
+        JSSection* section = new JSSection(0, static_cast<int>(input.contents.size()));
+        measure(result.phase("convert"), [&](){
+            LanguageNodesToJs lnt;
+            lnt.convert(root, input.contents, section->m_children, 0, ctx);
+        });
+
+        std::vector<std::string> flatten;
+        measure(result.phase("flatten"), [&](){ section->flatten(input.contents, flatten); });
+
+        delete section;
+        delete ctx;
+        delete root;
+        LanguageParser::destroy(ast);
+
+        measure(result.phase("compileToTarget.js"), [&](){ compiler->compileToTarget(input.path, input.contents); });
+        measure(result.phase("compileToTarget.ts"), [&](){ tsCompiler->compileToTarget(input.path, input.contents); });
+        measure(result.phase("compileToTarget.js_dts"), [&](){ dtsCompiler->compileToTarget(input.path, input.contents); });
+    }
+}
+
+double perSecond(double amount, long long ns){
+    return ns > 0 ? amount * 1e9 / static_cast<double>(ns) : 0.0;
+}
+
+MLNode toMLNode(const std::vector<InputResult>& results, size_t iterations){
+    MLNode root(MLNode::Object);
+    root["iterations"] = static_cast<MLNode::IntType>(iterations);
+    root["results"] = MLNode(MLNode::Array);
+
+    for ( const InputResult& input : results ){
+        for ( const PhaseResult& phase : input.phases ){
+            MLNode entry(MLNode::Object);
+            entry["input"]          = input.name;
+            entry["phase"]          = phase.name;
+            entry["bytes"]          = static_cast<MLNode::IntType>(input.bytes);
+            entry["nodes"]          = static_cast<MLNode::IntType>(input.nodes);
+            entry["meanNs"]         = static_cast<MLNode::IntType>(phase.meanNs());
+            entry["minNs"]          = static_cast<MLNode::IntType>(phase.minNs);
+            entry["mbPerSec"]       = perSecond(static_cast<double>(input.bytes) / (1024.0 * 1024.0), phase.meanNs());
+            entry["nodesPerSec"]    = perSecond(static_cast<double>(input.nodes), phase.meanNs());
+            entry["allocations"]    = static_cast<MLNode::IntType>(phase.runs > 0 ? phase.allocations / phase.runs : 0);
+            entry["allocatedBytes"] = static_cast<MLNode::IntType>(phase.runs > 0 ? phase.allocatedBytes / phase.runs : 0);
+            root["results"].append(entry);
+        }
+    }
+    root["memory"] = MemoryAccounting::toMLNode();
+    return root;
+}
+
+void printTable(const std::vector<InputResult>& results){
+    std::cout << std::left << std::setw(28) << "input" << std::setw(24) << "phase"
+              << std::right << std::setw(12) << "mean(us)" << std::setw(12) << "MB/s"
+              << std::setw(14) << "nodes/s" << std::setw(12) << "allocs" << std::endl;
+
+    for ( const InputResult& input : results ){
+        for ( const PhaseResult& phase : input.phases ){
+            std::cout << std::left << std::setw(28) << input.name << std::setw(24) << phase.name
+                      << std::right << std::fixed << std::setprecision(1)
+                      << std::setw(12) << static_cast<double>(phase.meanNs()) / 1000.0
+                      << std::setw(12) << perSecond(static_cast<double>(input.bytes) / (1024.0 * 1024.0), phase.meanNs())
+                      << std::setw(14) << std::setprecision(0) << perSecond(static_cast<double>(input.nodes), phase.meanNs())
+                      << std::setw(12) << (phase.runs > 0 ? phase.allocations / phase.runs : 0)
+                      << std::endl;
+        }
+    }
+}
+
+std::vector<size_t> parseSizes(const std::string& value){
+    std::vector<size_t> sizes;
+    for ( const Utf8& part : Utf8(value).split(",") ){
+        if ( !part.isEmpty() )
+            sizes.push_back(static_cast<size_t>(std::stoul(part.data())));
+    }
+    return sizes;
+}
+
+
+// Scaling
+// ----------------------------------------------------------------------------
+
+/** Peak resident set size of this process in kilobytes, 0 where not supported */
+long long peakRssKb(){
+#if defined(PLATFORM_OS_MAC)
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<long long>(usage.ru_maxrss) / 1024;
+#elif defined(PLATFORM_OS_UNIX)
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<long long>(usage.ru_maxrss);
+#else
+    return 0;
+#endif
+}
+
+/** Compiles the generated package, returning the measurements as an object node */
+MLNode compileGeneratedPackage(const std::string& packagePath){
+    MLNode result(MLNode::Object);
+    try{
+        size_t allocs = allocationCount;
+        auto start = std::chrono::steady_clock::now();
+
+        Compiler::Config config;
+        config.enableFileStatCache(true);
+        Compiler::Ptr compiler = Compiler::create(config);
+        compiler->initializePackageImportPaths(packagePath);
+        Compiler::compilePackage(compiler, packagePath);
+
+        auto end = std::chrono::steady_clock::now();
+        result["ns"] = static_cast<MLNode::IntType>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        result["allocations"] = static_cast<MLNode::IntType>(allocationCount - allocs);
+        result["peakRssKb"] = static_cast<MLNode::IntType>(peakRssKb());
+        result["memory"] = MemoryAccounting::toMLNode();
+    } catch ( lv::Exception& e ){
+        result["error"] = e.message();
+    } catch ( std::exception& e ){
+        result["error"] = std::string(e.what());
+    }
+    return result;
+}
+
+/**
+ * Runs compileGeneratedPackage in a child process where possible, so the peak memory of each
+ * step is not carried over from the previous ones.
+ */
+MLNode runIsolated(const std::string& packagePath){
+#ifdef PLATFORM_OS_UNIX
+    int fds[2];
+    if ( pipe(fds) != 0 )
+        return compileGeneratedPackage(packagePath);
+
+    pid_t pid = fork();
+    if ( pid == 0 ){
+        close(fds[0]);
+        std::string json;
+        ml::toJson(compileGeneratedPackage(packagePath), json);
+        size_t written = 0;
+        while ( written < json.size() ){
+            ssize_t w = write(fds[1], json.data() + written, json.size() - written);
+            if ( w <= 0 )
+                break;
+            written += static_cast<size_t>(w);
+        }
+        close(fds[1]);
+        _exit(0);
+    }
+
+    close(fds[1]);
+    std::string json;
+    char buffer[4096];
+    ssize_t r;
+    while ( (r = read(fds[0], buffer, sizeof(buffer))) > 0 )
+        json.append(buffer, static_cast<size_t>(r));
+    close(fds[0]);
+    int status = 0;
+    if ( pid > 0 )
+        waitpid(pid, &status, 0);
+
+    MLNode result;
+    if ( json.empty() ){
+        result = MLNode(MLNode::Object);
+        result["error"] = WIFSIGNALED(status)
+            ? "Compile process terminated by signal " + std::to_string(WTERMSIG(status)) + "."
+            : std::string("Compile process exited without a result.");
+    } else {
+        ml::fromJson(json, result);
+    }
+    return result;
+#else
+    return compileGeneratedPackage(packagePath);
+#endif
+}
+
+/** Generates a package per module count in \p sizes and compiles each of them */
+MLNode runScaling(const std::vector<size_t>& sizes, const std::string& workPath){
+    MLNode results(MLNode::Array);
+
+    for ( size_t size : sizes ){
+        ProjectGenerator::Config config;
+        config.modules = size;
+        ProjectGenerator generator(config);
+
+        std::string stepPath = Path::join(workPath, "scaling" + std::to_string(size));
+        if ( Path::exists(stepPath) )
+            Path::remove(stepPath);
+        std::string packagePath = generator.generate(stepPath);
+
+        MLNode step = runIsolated(packagePath);
+        step["modules"]    = static_cast<MLNode::IntType>(size);
+        step["files"]      = static_cast<MLNode::IntType>(generator.totalFiles());
+        step["components"] = static_cast<MLNode::IntType>(generator.totalComponents());
+        step["bytes"]      = static_cast<MLNode::IntType>(generator.generatedBytes());
+        results.append(step);
+    }
+    return results;
+}
+
+void printScalingTable(const MLNode& results){
+    std::cout << std::right << std::setw(10) << "modules" << std::setw(10) << "files" << std::setw(14) << "bytes"
+              << std::setw(14) << "time(ms)" << std::setw(14) << "us/file" << std::setw(14) << "peakRss(kB)" << std::endl;
+
+    for ( const MLNode& step : results.asArray() ){
+        std::cout << std::setw(10) << step["modules"].asInt() << std::setw(10) << step["files"].asInt()
+                  << std::setw(14) << step["bytes"].asInt();
+        if ( step.hasKey("error") ){
+            std::cout << "  error: " << step["error"].asString() << std::endl;
+            continue;
+        }
+        double ms = static_cast<double>(step["ns"].asInt()) / 1e6;
+        std::cout << std::fixed << std::setprecision(1) << std::setw(14) << ms
+                  << std::setw(14) << ms * 1000.0 / static_cast<double>(step["files"].asInt())
+                  << std::setw(14) << step["peakRssKb"].asInt() << std::endl;
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]){
+    CommandLineParser parser(
+        "Live Elements compiler benchmark. Runs each compiler phase over the test corpus, or compiles generated "
+        "packages of increasing size with --scaling."
+    );
+    parser.setUsage("lvelementscompilerbench [options...]");
+
+    CommandLineParser::Option* iterationsOption = parser.addOption(
+        {"-i", "--iterations"}, "Number of runs per input. Defaults to 10.", "N"
+    );
+    CommandLineParser::Option* dataOption = parser.addOption(
+        {"-d", "--data"}, "Directory with .lv files to benchmark. Defaults to the unit test data.", "path"
+    );
+    CommandLineParser::Option* generateOption = parser.addOption(
+        {"-g", "--generate"}, "Comma separated element counts for generated components. Defaults to 100,1000.", "sizes"
+    );
+    CommandLineParser::Option* filterOption = parser.addOption(
+        {"-f", "--filter"}, "Only run inputs whose name contains this string.", "string"
+    );
+    CommandLineParser::Option* scalingOption = parser.addOption(
+        {"-s", "--scaling"}, "Comma separated module counts. Generates and compiles a package for each, instead of the phase benchmark.", "sizes"
+    );
+    CommandLineParser::Option* workOption = parser.addOption(
+        {"-w", "--workdir"}, "Directory for generated packages. Defaults to a folder in the temporary directory.", "path"
+    );
+    CommandLineParser::Option* poolOption = parser.addFlag(
+        {"--pool-allocator"}, "Allocate tree-sitter parses from thread-local pools instead of malloc."
+    );
+    CommandLineParser::Option* memoryOption = parser.addFlag(
+        {"--memory"}, "Count bytes held by compiler structures, reported in json results. Adds overhead to each allocation."
+    );
+    CommandLineParser::Option* jsonOption = parser.addFlag(
+        {"--json"}, "Print results as json instead of a table."
+    );
+    CommandLineParser::Option* outputOption = parser.addOption(
+        {"-o", "--output"}, "Write json results to this file.", "path"
+    );
+
+    try{
+        parser.parse(argc, argv);
+        if ( parser.isSet(parser.helpOption()) ){
+            std::cout << parser.helpString() << std::endl;
+            return 0;
+        }
+        if ( parser.isSet(poolOption) )
+            MemoryAccounting::setTreeSitterAllocator(MemoryAccounting::PoolAllocator);
+        if ( parser.isSet(memoryOption) )
+            MemoryAccounting::setEnabled(true);
+
+        FileIO fileIO;
+
+        if ( parser.isSet(scalingOption) ){
+            std::string workPath = parser.isSet(workOption)
+                ? parser.value(workOption)
+                : Path::join(Path::temporaryDirectory(), "lvelementscompilerbench");
+
+            MLNode resultNode(MLNode::Object);
+            resultNode["scaling"] = runScaling(parseSizes(parser.value(scalingOption)), workPath);
+
+            std::string json;
+            ml::toJson(resultNode, json);
+            if ( parser.isSet(outputOption) )
+                fileIO.writeToFile(parser.value(outputOption), json);
+            if ( parser.isSet(jsonOption) ){
+                std::cout << json << std::endl;
+            } else {
+                printScalingTable(resultNode["scaling"]);
+            }
+            return 0;
+        }
+
+        size_t iterations = parser.isSet(iterationsOption) ? std::stoul(parser.value(iterationsOption)) : 10;
+        iterations = std::max(iterations, static_cast<size_t>(1));
+
+        std::string dataPath = parser.isSet(dataOption) ? parser.value(dataOption) : LV_ELEMENTS_COMPILER_BENCH_DATA;
+        std::vector<size_t> sizes = parseSizes(parser.isSet(generateOption) ? parser.value(generateOption) : "100,1000");
+        std::string filter = parser.isSet(filterOption) ? parser.value(filterOption) : "";
+
+        std::vector<BenchInput> inputs;
+
+        std::vector<std::string> files;
+        Directory::Iterator dit = Directory::iterate(dataPath);
+        while ( !dit.isEnd() ){
+            std::string path = dit.path();
+            if ( Path::suffix(path) == "lv" && Path::baseName(path).find("Error") == std::string::npos )
+                files.push_back(path);
+            dit.next();
+        }
+        std::sort(files.begin(), files.end());
+        for ( const std::string& path : files ){
+            BenchInput input;
+            input.name = Path::name(path);
+            input.path = path;
+            input.contents = fileIO.readFromFile(path);
+            inputs.push_back(input);
+        }
+
+        for ( size_t size : sizes ){
+            BenchInput input;
+            input.name = "Generated" + std::to_string(size) + ".lv";
+            input.path = Path::join(dataPath, input.name);
+            input.contents = ProjectGenerator::componentSource("Generated" + std::to_string(size), "Container", size, 1);
+            inputs.push_back(input);
+        }
+
+        std::vector<InputResult> results;
+        for ( const BenchInput& input : inputs ){
+            if ( !filter.empty() && input.name.find(filter) == std::string::npos )
+                continue;
+            results.push_back(InputResult());
+            runInput(input, results.back(), iterations);
+        }
+
+        MLNode resultNode = toMLNode(results, iterations);
+        std::string json;
+        ml::toJson(resultNode, json);
+
+        if ( parser.isSet(outputOption) )
+            fileIO.writeToFile(parser.value(outputOption), json);
+
+        if ( parser.isSet(jsonOption) ){
+            std::cout << json << std::endl;
+        } else {
+            printTable(results);
+        }
+
+    } catch ( lv::el::SyntaxException& e ){
+        std::cerr << "Syntax error: " << e.message() << std::endl;
+        return 1;
+    } catch ( lv::Exception& e ){
+        std::cerr << "Error: " << e.message() << std::endl;
+        return 1;
+    } catch ( std::exception& e ){
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,173 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 Dinu SV.
+** This file is part of Livekeys Application.
+**
+** GNU Lesser General Public License Usage
+** This file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+****************************************************************************/
+
+#include "projectgenerator.h"
+#include "live/fileio.h"
+#include "live/path.h"
+#include "live/module.h"
+#include "live/package.h"
+#include "live/exception.h"
+#include "live/utf8.h"
+
+#include <sstream>
+
+/**
+ * \class lv::el::ProjectGenerator
+ * \brief Generates Live Elements packages of a given size for scaling benchmarks
+ *
+ * The package contains Config::modules modules named m0, m1, ... Each module imports the previous
+ * one relatively (import .mN as prev), forming import chains of Config::chainLength modules. Every
+ * module past the first chain link also imports m0 through its absolute path, so m0 becomes a
+ * wide fan-in module. Components extend the first component of the previous module and bind
+ * across their children.
+ */
+
+namespace lv{ namespace el{
+
+namespace{
+
+std::string moduleName(size_t index){
+    return "m" + std::to_string(index);
+}
+
+std::string componentName(size_t file, size_t component){
+    return "C" + std::to_string(file) + "_" + std::to_string(component);
+}
+
+void writeNestedElements(std::stringstream& ss, size_t depth, size_t indent){
+    if ( depth == 0 )
+        return;
+    std::string pad(indent, ' ');
+    ss << pad << "Element{\n";
+    ss << pad << "    number x : parent.x * 2\n";
+    writeNestedElements(ss, depth - 1, indent + 4);
+    ss << pad << "}\n";
+}
+
+} // namespace
+
+ProjectGenerator::ProjectGenerator(const Config &config)
+    : m_config(config)
+    , m_generatedBytes(0)
+{
+}
+
+/**
+ * \brief Writes the package under \p path, returning the package directory
+ */
+std::string ProjectGenerator::generate(const std::string &path){
+    if ( m_config.modules == 0 || m_config.filesPerModule == 0 || m_config.componentsPerFile == 0 ){
+        THROW_EXCEPTION(lv::Exception, "Generated project needs at least one module, file and component.", lv::Exception::toCode("~Config"));
+    }
+
+    FileIO fileIO;
+    m_generatedBytes = 0;
+    std::string packagePath = Path::join(path, m_config.packageName);
+    Path::createDirectories(packagePath);
+
+    fileIO.writeToFile(
+        Path::join(packagePath, Package::fileName),
+        "{\n    \"name\": \"" + m_config.packageName + "\",\n    \"version\": \"1.0.0\"\n}\n"
+    );
+
+    for ( size_t i = 0; i < m_config.modules; ++i ){
+        std::string modulePath = Path::join(packagePath, moduleName(i));
+        Path::createDirectories(modulePath);
+        fileIO.writeToFile(Path::join(modulePath, Module::fileName), "{\n    \"modules\": \"*\"\n}\n");
+
+        for ( size_t j = 0; j < m_config.filesPerModule; ++j ){
+            std::string source = fileSource(i, j);
+            m_generatedBytes += source.size();
+            fileIO.writeToFile(Path::join(modulePath, "F" + std::to_string(j) + ".lv"), source);
+        }
+    }
+
+    return packagePath;
+}
+
+size_t ProjectGenerator::totalFiles() const{
+    return m_config.modules * m_config.filesPerModule;
+}
+
+size_t ProjectGenerator::totalComponents() const{
+    return totalFiles() * m_config.componentsPerFile;
+}
+
+/**
+ * \brief Source for a single component with \p elements children
+ *
+ * Each child declares properties, binds to its previous sibling, handles an event and nests
+ * \p nestingDepth further elements. If \p fanInType is given, each child also holds an
+ * instance of that type.
+ */
+std::string ProjectGenerator::componentSource(
+        const std::string &name,
+        const std::string &base,
+        size_t elements,
+        size_t nestingDepth,
+        const std::string &fanInType)
+{
+    std::stringstream ss;
+    ss << "component " << name << " < " << base << "{\n";
+    ss << "    id: root\n";
+    ss << "    number a : 20\n";
+    ss << "    event changed(value:number)\n\n";
+    for ( size_t i = 0; i < elements; ++i ){
+        ss << "    Element{\n";
+        ss << "        id: e" << i << "\n";
+        if ( i == 0 ){
+            ss << "        number x : root.a\n";
+        } else {
+            ss << "        number x : e" << (i - 1) << ".x + " << i << "\n";
+        }
+        ss << "        string label : \"Item " << i << "\"\n";
+        ss << "        on changed: (value) => {\n";
+        ss << "            this.label = \"Item \" + value\n";
+        ss << "        }\n";
+        if ( !fanInType.empty() ){
+            ss << "        Element shared : " << fanInType << "{\n";
+            ss << "            number a : e" << i << ".x\n";
+            ss << "        }\n";
+        }
+        writeNestedElements(ss, nestingDepth, 8);
+        ss << "    }\n\n";
+    }
+    ss << "}\n";
+    return ss.str();
+}
+
+std::string ProjectGenerator::fileSource(size_t module, size_t file) const{
+    size_t chainLength = m_config.chainLength == 0 ? m_config.modules : m_config.chainLength;
+    bool importsPrevious = module > 0 && module % chainLength != 0;
+    bool importsFanIn    = module > 1;
+
+    std::stringstream ss;
+    if ( importsPrevious )
+        ss << "import ." << moduleName(module - 1) << " as prev\n";
+    if ( importsFanIn )
+        ss << "import " << m_config.packageName << "." << moduleName(0) << " as hub\n";
+    if ( importsPrevious || importsFanIn )
+        ss << "\n";
+
+    for ( size_t k = 0; k < m_config.componentsPerFile; ++k ){
+        std::string base = importsPrevious ? "prev." + componentName(0, 0) : "Element";
+        std::string fanInType = importsFanIn ? "hub." + componentName(0, 0) : "";
+        ss << componentSource(componentName(file, k), base, m_config.elementsPerComponent, m_config.nestingDepth, fanInType);
+        ss << "\n";
+    }
+    return ss.str();
+}
+
+}} // namespace lv, el
@@ -0,0 +1,77 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 Dinu SV.
+** This file is part of Livekeys Application.
+**
+** GNU Lesser General Public License Usage
+** This file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+****************************************************************************/
+
+#ifndef LVPROJECTGENERATOR_H
+#define LVPROJECTGENERATOR_H
+
+#include <string>
+
+namespace lv{ namespace el{
+
+class ProjectGenerator{
+
+public:
+    class Config{
+    public:
+        Config()
+            : packageName("generated")
+            , modules(10)
+            , filesPerModule(5)
+            , componentsPerFile(2)
+            , elementsPerComponent(10)
+            , nestingDepth(2)
+            , chainLength(0)
+        {}
+
+        std::string packageName;
+        /** Number of modules in the package */
+        size_t      modules;
+        size_t      filesPerModule;
+        size_t      componentsPerFile;
+        /** Number of child elements in each component */
+        size_t      elementsPerComponent;
+        /** Number of nested elements under each child */
+        size_t      nestingDepth;
+        /** Length of the relative import chain between modules, 0 chains all modules */
+        size_t      chainLength;
+    };
+
+public:
+    ProjectGenerator(const Config& config = Config());
+
+    std::string generate(const std::string& path);
+
+    size_t totalFiles() const;
+    size_t totalComponents() const;
+    size_t generatedBytes() const{ return m_generatedBytes; }
+
+    static std::string componentSource(
+        const std::string& name,
+        const std::string& base,
+        size_t elements,
+        size_t nestingDepth,
+        const std::string& fanInType = ""
+    );
+
+private:
+    std::string fileSource(size_t module, size_t file) const;
+
+    Config m_config;
+    size_t m_generatedBytes;
+};
+
+}} // namespace lv, el
+
+#endif // LVPROJECTGENERATOR_H
@@ -0,0 +1,80 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 Dinu SV.
+** This file is part of Livekeys Application.
+**
+** GNU Lesser General Public License Usage
+** This file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+****************************************************************************/
+
+#include "live/commandlineparser.h"
+#include "live/exception.h"
+#include "projectgenerator.h"
+
+#include <iostream>
+
+int main(int argc, char* argv[]){
+    lv::CommandLineParser parser("Generates a Live Elements package of a given size, for compiler scaling tests.");
+    parser.setUsage("lvelementsprojectgen [options...] <output path>");
+
+    lv::CommandLineParser::Option* nameOption       = parser.addOption({"-n", "--name"}, "Package name. Defaults to 'generated'.", "string");
+    lv::CommandLineParser::Option* modulesOption    = parser.addOption({"-m", "--modules"}, "Number of modules. Defaults to 10.", "N");
+    lv::CommandLineParser::Option* filesOption      = parser.addOption({"-f", "--files"}, "Files per module. Defaults to 5.", "N");
+    lv::CommandLineParser::Option* componentsOption = parser.addOption({"-c", "--components"}, "Components per file. Defaults to 2.", "N");
+    lv::CommandLineParser::Option* elementsOption   = parser.addOption({"-e", "--elements"}, "Child elements per component. Defaults to 10.", "N");
+    lv::CommandLineParser::Option* depthOption      = parser.addOption({"-d", "--depth"}, "Nesting depth under each child element. Defaults to 2.", "N");
+    lv::CommandLineParser::Option* chainOption      = parser.addOption(
+        {"--chain"}, "Length of relative import chains between modules. Defaults to 0, chaining all modules.", "N"
+    );
+
+    try{
+        parser.parse(argc, argv);
+        if ( parser.isSet(parser.helpOption()) ){
+            std::cout << parser.helpString() << std::endl;
+            return 0;
+        }
+        if ( parser.script().empty() ){
+            THROW_EXCEPTION(lv::Exception, "No output path given.", lv::Exception::toCode("~Arguments"));
+        }
+
+        lv::el::ProjectGenerator::Config config;
+        if ( parser.isSet(nameOption) )
+            config.packageName = parser.value(nameOption);
+        if ( parser.isSet(modulesOption) )
+            config.modules = std::stoul(parser.value(modulesOption));
+        if ( parser.isSet(filesOption) )
+            config.filesPerModule = std::stoul(parser.value(filesOption));
+        if ( parser.isSet(componentsOption) )
+            config.componentsPerFile = std::stoul(parser.value(componentsOption));
+        if ( parser.isSet(elementsOption) )
+            config.elementsPerComponent = std::stoul(parser.value(elementsOption));
+        if ( parser.isSet(depthOption) )
+            config.nestingDepth = std::stoul(parser.value(depthOption));
+        if ( parser.isSet(chainOption) )
+            config.chainLength = std::stoul(parser.value(chainOption));
+
+        lv::el::ProjectGenerator generator(config);
+        std::string packagePath = generator.generate(parser.script());
+
+        std::cout << "Generated " << packagePath << ": "
+                  << config.modules << " modules, "
+                  << generator.totalFiles() << " files, "
+                  << generator.totalComponents() << " components, "
+                  << generator.generatedBytes() << " bytes" << std::endl;
+
+    } catch ( lv::Exception& e ){
+        std::cerr << "Error: " << e.message() << std::endl;
+        return 1;
+    } catch ( std::exception& e ){
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,127 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 Dinu SV.
+**
+** This file is part of Livekeys Application.
+**
+** GNU Lesser General Public License Usage
+** This file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+****************************************************************************/
+
+
+#include "catch_library.h"
+#include "live/elements/compiler/languageparser.h"
+#include "live/elements/compiler/languagequery.h"
+
+using namespace lv;
+using namespace lv::el;
+
+namespace{
+
+const std::string componentSource =
+    "component A < Element{}\n"
+    "component B < Element{}\n"
+    "component C < Element{}\n";
+
+const std::string componentNameQuery = "(component_declaration name: (identifier) @name)";
+
+std::vector<std::string> captureNames(LanguageQuery::Cursor::Ptr cursor){
+    std::vector<std::string> result;
+    while ( cursor->nextMatch() ){
+        for ( uint16_t i = 0; i < cursor->totalMatchCaptures(); ++i ){
+            Utf8::Range range = cursor->captureRange(i);
+            result.push_back(componentSource.substr(range.from(), range.length()));
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+TEST_CASE( "Language Query Test", "[LanguageQuery]" ) {
+    LanguageParser::Ptr parser = LanguageParser::createForElements();
+    LanguageParser::AST* ast = parser->parse(componentSource);
+
+    SECTION("Query Cache"){
+        LanguageQuery::clearCache();
+        REQUIRE(LanguageQuery::totalCachedQueries() == 0);
+
+        LanguageQuery::Ptr query = LanguageQuery::create(parser->language(), componentNameQuery);
+        REQUIRE(LanguageQuery::totalCachedQueries() == 1);
+
+        LanguageQuery::Ptr cachedQuery = LanguageQuery::create(parser->language(), componentNameQuery);
+        REQUIRE(LanguageQuery::totalCachedQueries() == 1);
+        REQUIRE(cachedQuery->captureCount() == 1);
+        REQUIRE(cachedQuery->captureName(0) == "name");
+
+        LanguageQuery::create(parser->language(), "(component_declaration) @component");
+        REQUIRE(LanguageQuery::totalCachedQueries() == 2);
+
+        LanguageQuery::clearCache();
+        REQUIRE(LanguageQuery::totalCachedQueries() == 0);
+
+        // created queries keep their compiled query
+        REQUIRE(captureNames(query->exec(ast)) == std::vector<std::string>{"A", "B", "C"});
+
+        LanguageQuery::create(parser->language(), componentNameQuery);
+        REQUIRE(LanguageQuery::totalCachedQueries() == 1);
+    }
+
+    SECTION("Ranged Then Full Execution"){
+        LanguageQuery::Ptr query = LanguageQuery::create(parser->language(), componentNameQuery);
+
+        uint32_t lineStart = static_cast<uint32_t>(componentSource.find("component B"));
+        uint32_t lineEnd   = static_cast<uint32_t>(componentSource.find('\n', lineStart));
+
+        // each cursor goes back to the pool when released, so the full execution reuses the ranged one
+        REQUIRE(captureNames(query->exec(ast, lineStart, lineEnd)) == std::vector<std::string>{"B"});
+        REQUIRE(captureNames(query->exec(ast)) == std::vector<std::string>{"A", "B", "C"});
+        REQUIRE(captureNames(query->exec(ast, lineStart, lineEnd)) == std::vector<std::string>{"B"});
+    }
+
+    SECTION("Predicate Arguments"){
+        LanguageQuery::Ptr query = LanguageQuery::create(
+            parser->language(),
+            "((component_declaration name: (identifier) @name) (#first? @name \"x\") (#second? @name \"y\" \"z\"))"
+        );
+
+        std::vector<std::vector<std::string> > firstCalls;
+        std::vector<std::vector<std::string> > secondCalls;
+        auto recordArguments = [](std::vector<std::vector<std::string> >& calls){
+            return [&calls](const std::vector<LanguageQuery::PredicateData>& args, void*){
+                std::vector<std::string> values;
+                for ( const LanguageQuery::PredicateData& arg : args ){
+                    values.push_back(arg.m_range.isValid()
+                        ? componentSource.substr(arg.m_range.from(), arg.m_range.length())
+                        : arg.m_value.data()
+                    );
+                }
+                calls.push_back(values);
+                return true;
+            };
+        };
+        query->addPredicate("first?", recordArguments(firstCalls));
+        query->addPredicate("second?", recordArguments(secondCalls));
+
+        LanguageQuery::Cursor::Ptr cursor = query->exec(ast);
+        size_t matches = 0;
+        while ( cursor->nextMatch() ){
+            REQUIRE(query->predicateMatch(cursor));
+            ++matches;
+        }
+
+        REQUIRE(matches == 3);
+        REQUIRE(firstCalls.size() == 3);
+        REQUIRE(secondCalls.size() == 3);
+        REQUIRE(firstCalls[1] == std::vector<std::string>{"B", "x"});
+        REQUIRE(secondCalls[1] == std::vector<std::string>{"B", "y", "z"});
+    }
+
+    LanguageParser::destroy(ast);
+}
@@ -17,9 +17,12 @@
 #include "catch_amalgamated.hpp"
 #include "live/visuallog.h"
 #include "live/applicationcontext.h"
+#include "live/elements/compiler/memoryaccounting.h"
 
 int main(int argc, char *argv[]){
     lv::ApplicationContext::initialize({});
+    // parse tests run on the pool allocator too, it has to be selected before the first parser
+    lv::el::MemoryAccounting::setTreeSitterAllocator(lv::el::MemoryAccounting::PoolAllocator);
     int result = Catch::Session().run( argc, argv );
     return result;
 }
@@ -0,0 +1,185 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 Dinu SV.
+**
+** This file is part of Livekeys Application.
+**
+** GNU Lesser General Public License Usage
+** This file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+****************************************************************************/
+
+
+#include "catch_library.h"
+#include "live/elements/compiler/memoryaccounting.h"
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace lv;
+using namespace lv::el;
+
+TEST_CASE( "Memory Accounting Test", "[MemoryAccounting]" ) {
+    bool wasEnabled = MemoryAccounting::isEnabled();
+
+    SECTION("Category Counters"){
+        MemoryAccounting::setEnabled(true);
+        MemoryAccounting::resetPeaks();
+
+        std::int64_t live = MemoryAccounting::liveBytes(MemoryAccounting::Bindings);
+        std::int64_t allocations = MemoryAccounting::toMLNode()["categories"]["bindings"]["allocations"].asInt();
+
+        MemoryAccounting::add(MemoryAccounting::Bindings, 100);
+        MemoryAccounting::add(MemoryAccounting::Bindings, 50);
+        REQUIRE(MemoryAccounting::liveBytes(MemoryAccounting::Bindings) == live + 150);
+        REQUIRE(MemoryAccounting::peakBytes(MemoryAccounting::Bindings) == live + 150);
+
+        MemoryAccounting::remove(MemoryAccounting::Bindings, 120);
+        REQUIRE(MemoryAccounting::liveBytes(MemoryAccounting::Bindings) == live + 30);
+        REQUIRE(MemoryAccounting::peakBytes(MemoryAccounting::Bindings) == live + 150);
+
+        MemoryAccounting::resetPeaks();
+        REQUIRE(MemoryAccounting::peakBytes(MemoryAccounting::Bindings) == live + 30);
+
+        MemoryAccounting::remove(MemoryAccounting::Bindings, 30);
+        REQUIRE(MemoryAccounting::liveBytes(MemoryAccounting::Bindings) == live);
+
+        MLNode stats = MemoryAccounting::toMLNode();
+        REQUIRE(stats["enabled"].asBool());
+        REQUIRE(stats["categories"]["bindings"]["allocations"].asInt() == allocations + 2);
+    }
+
+    SECTION("Disabled"){
+        MemoryAccounting::setEnabled(false);
+
+        std::int64_t live = MemoryAccounting::liveBytes(MemoryAccounting::Bindings);
+        MemoryAccounting::add(MemoryAccounting::Bindings, 100);
+        REQUIRE(MemoryAccounting::liveBytes(MemoryAccounting::Bindings) == live);
+        MemoryAccounting::remove(MemoryAccounting::Bindings, 100);
+        REQUIRE(MemoryAccounting::liveBytes(MemoryAccounting::Bindings) == live);
+
+        MemoryAccounting::clearFiles();
+        {
+            MemoryAccounting::FileScope scope("disabled.lv");
+            MemoryAccounting::add(MemoryAccounting::Sections, 64);
+        }
+
+        MLNode stats = MemoryAccounting::toMLNode();
+        REQUIRE_FALSE(stats["enabled"].asBool());
+        REQUIRE(stats["files"].size() == 0);
+    }
+
+    SECTION("File Scopes"){
+        MemoryAccounting::setEnabled(true);
+        MemoryAccounting::clearFiles();
+
+        {
+            MemoryAccounting::FileScope a("a.lv");
+            MemoryAccounting::add(MemoryAccounting::Sections, 64);
+            {
+                MemoryAccounting::FileScope b("b.lv");
+                MemoryAccounting::add(MemoryAccounting::Sections, 32);
+                MemoryAccounting::remove(MemoryAccounting::Sections, 32);
+            }
+            MemoryAccounting::add(MemoryAccounting::Sections, 16);
+            MemoryAccounting::remove(MemoryAccounting::Sections, 80);
+        }
+
+        MLNode files = MemoryAccounting::toMLNode()["files"];
+        REQUIRE(files.size() == 2);
+        REQUIRE(files["a.lv"]["allocatedBytes"].asInt() == 80);
+        REQUIRE(files["a.lv"]["peakBytes"].asInt() == 80);
+        REQUIRE(files["b.lv"]["allocatedBytes"].asInt() == 32);
+        REQUIRE(files["b.lv"]["peakBytes"].asInt() == 32);
+
+        MemoryAccounting::clearFiles();
+        REQUIRE(MemoryAccounting::toMLNode()["files"].size() == 0);
+    }
+
+    MemoryAccounting::setEnabled(wasEnabled);
+}
+
+TEST_CASE( "Tree-sitter Pool Allocator Test", "[MemoryAccounting]" ) {
+    REQUIRE(MemoryAccounting::setTreeSitterAllocator(MemoryAccounting::PoolAllocator));
+
+    bool wasEnabled = MemoryAccounting::isEnabled();
+    MemoryAccounting::setEnabled(true);
+
+    std::int64_t live = MemoryAccounting::liveBytes(MemoryAccounting::TreeSitter);
+    MLNode poolStats = MemoryAccounting::treeSitterPoolStats();
+
+    SECTION("Allocate And Reallocate"){
+        char* p = static_cast<char*>(MemoryAccounting::allocateTreeSitterMemory(24));
+        REQUIRE(p != nullptr);
+        std::memset(p, 'a', 24);
+        REQUIRE(MemoryAccounting::liveBytes(MemoryAccounting::TreeSitter) == live + 24);
+
+        // same size class, the block is kept
+        char* q = static_cast<char*>(MemoryAccounting::reallocateTreeSitterMemory(p, 30));
+        REQUIRE(q == p);
+        REQUIRE(MemoryAccounting::liveBytes(MemoryAccounting::TreeSitter) == live + 30);
+
+        // next size class
+        q = static_cast<char*>(MemoryAccounting::reallocateTreeSitterMemory(q, 200));
+        REQUIRE(q != nullptr);
+        REQUIRE(std::string(q, 24) == std::string(24, 'a'));
+        REQUIRE(MemoryAccounting::liveBytes(MemoryAccounting::TreeSitter) == live + 200);
+
+        // above the largest size class
+        q = static_cast<char*>(MemoryAccounting::reallocateTreeSitterMemory(q, 10000));
+        REQUIRE(q != nullptr);
+        REQUIRE(std::string(q, 24) == std::string(24, 'a'));
+        REQUIRE(MemoryAccounting::liveBytes(MemoryAccounting::TreeSitter) == live + 10000);
+
+        MemoryAccounting::freeTreeSitterMemory(q);
+        REQUIRE(MemoryAccounting::liveBytes(MemoryAccounting::TreeSitter) == live);
+
+        MLNode stats = MemoryAccounting::treeSitterPoolStats();
+        REQUIRE(stats["pooledAllocations"].asInt() == poolStats["pooledAllocations"].asInt() + 2);
+        REQUIRE(stats["largeAllocations"].asInt() == poolStats["largeAllocations"].asInt() + 1);
+        REQUIRE(stats["reservedBytes"].asInt() > 0);
+    }
+
+    SECTION("Free On Another Thread"){
+        std::vector<void*> blocks;
+        for ( size_t i = 0; i < 4096; ++i ){
+            void* p = MemoryAccounting::allocateTreeSitterMemory(64);
+            if ( !p )
+                break;
+            std::memset(p, static_cast<int>(i % 256), 64);
+            blocks.push_back(p);
+        }
+        REQUIRE(blocks.size() == 4096);
+        REQUIRE(MemoryAccounting::liveBytes(MemoryAccounting::TreeSitter) == live + 4096 * 64);
+
+        std::thread releaser([&blocks](){
+            for ( void* p : blocks )
+                MemoryAccounting::freeTreeSitterMemory(p);
+        });
+        releaser.join();
+        REQUIRE(MemoryAccounting::liveBytes(MemoryAccounting::TreeSitter) == live);
+
+        // blocks released by the exited thread are reused
+        std::int64_t reserved = MemoryAccounting::treeSitterPoolStats()["reservedBytes"].asInt();
+        blocks.clear();
+        for ( size_t i = 0; i < 4096; ++i )
+            blocks.push_back(MemoryAccounting::allocateTreeSitterMemory(64));
+        REQUIRE(MemoryAccounting::treeSitterPoolStats()["reservedBytes"].asInt() == reserved);
+
+        for ( void* p : blocks )
+            MemoryAccounting::freeTreeSitterMemory(p);
+        REQUIRE(MemoryAccounting::liveBytes(MemoryAccounting::TreeSitter) == live);
+
+        MLNode stats = MemoryAccounting::toMLNode();
+        REQUIRE(stats["treeSitterAllocator"].asString() == "pool");
+        REQUIRE(stats["treeSitterPool"]["refills"].asInt() > poolStats["refills"].asInt());
+    }
+
+    MemoryAccounting::setEnabled(wasEnabled);
+}
@@ -0,0 +1,162 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 Dinu SV.
+**
+** This file is part of Livekeys Application.
+**
+** GNU Lesser General Public License Usage
+** This file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+****************************************************************************/
+
+#include "catch_library.h"
+#include "live/fileio.h"
+#include "live/path.h"
+#include "live/module.h"
+#include "live/package.h"
+
+#include "live/elements/compiler/compiler.h"
+#include "live/elements/compiler/elementsmodule.h"
+#include "live/elements/compiler/modulefile.h"
+#include "live/elements/compiler/languagedescriptors.h"
+#include "live/mlnodetojson.h"
+
+using namespace lv;
+using namespace lv::el;
+
+namespace{
+
+/** Writes a package with a single module 'm' containing \p files, returning the module path */
+std::string writeModule(const std::string& packageName, const std::vector<std::pair<std::string, std::string> >& files){
+    std::string packagePath = Path::join(Path::join(Path::temporaryDirectory(), "lvelementscompilertest"), packageName);
+    if ( Path::exists(packagePath) )
+        Path::remove(packagePath);
+    Path::createDirectories(packagePath);
+
+    FileIO fileIO;
+    fileIO.writeToFile(Path::join(packagePath, Package::fileName), "{\"name\": \"" + packageName + "\", \"version\": \"1.0.0\"}");
+
+    std::string modulePath = Path::join(packagePath, "m");
+    Path::createDirectories(modulePath);
+    fileIO.writeToFile(Path::join(modulePath, Module::fileName), "{\"modules\": \"*\"}");
+    for ( auto it = files.begin(); it != files.end(); ++it )
+        fileIO.writeToFile(Path::join(modulePath, it->first + ".lv"), it->second);
+
+    return modulePath;
+}
+
+} // namespace
+
+TEST_CASE( "Module File Dependency Test", "[Module]" ) {
+    SECTION("Dependency Order"){
+        std::string modulePath = writeModule("dependencyorder", {
+            {"A", "component A < B{}\n"},
+            {"B", "component B < C{}\n"},
+            {"C", "component C < Element{}\n"}
+        });
+
+        Compiler::Ptr compiler = Compiler::create();
+        ElementsModule::Ptr em = Compiler::compileModule(compiler, modulePath);
+
+        const std::vector<ModuleFile*>& order = em->fileDependencyOrder();
+        REQUIRE(order.size() == 3);
+        REQUIRE(order[0]->name() == "C");
+        REQUIRE(order[1]->name() == "B");
+        REQUIRE(order[2]->name() == "A");
+    }
+    SECTION("Cycle Rejection"){
+        std::string modulePath = writeModule("dependencycycle", {
+            {"A", "component A < B{}\n"},
+            {"B", "component B < C{}\n"},
+            {"C", "component C < A{}\n"}
+        });
+
+        Compiler::Ptr compiler = Compiler::create();
+        std::string message;
+        try{
+            Compiler::compileModule(compiler, modulePath);
+        } catch ( lv::Exception& e ){
+            message = e.message();
+        }
+
+        REQUIRE(message.find("dependency cycle") != std::string::npos);
+        REQUIRE(message.find("C -> A -> B -> C") != std::string::npos);
+    }
+}
+
+TEST_CASE( "Module Descriptor Test", "[Module]" ) {
+    ModuleDescriptor::Ptr md = ModuleDescriptor::create("package.module");
+
+    ModuleFileDescriptor::Ptr a = ModuleFileDescriptor::create("A.lv");
+    a->addExport(ExportDescriptor("A", ExportDescriptor::Component));
+    a->addExport(ExportDescriptor("a", ExportDescriptor::Element));
+    a->addDependency(ModuleFileDescriptor::ImportDependency("lv"));
+    a->addDependency(ModuleFileDescriptor::ImportDependency(".other"));
+    md->addModuleFileDescriptor(a);
+
+    ModuleFileDescriptor::Ptr b = ModuleFileDescriptor::create("B.lv");
+    b->addExport(ExportDescriptor("B", ExportDescriptor::Component));
+    md->addModuleFileDescriptor(b);
+
+    md->addModuleLibraryDescriptor(ModuleLibraryDescriptor::create("library"));
+
+    std::string binary;
+    md->toBinary(binary);
+
+    SECTION("Binary Roundtrip"){
+        ModuleDescriptor::Ptr result = ModuleDescriptor::createFromBinary(binary.data(), binary.size());
+
+        std::string expected, actual;
+        ml::toJson(md->toMLNode(), expected);
+        ml::toJson(result->toMLNode(), actual);
+        REQUIRE(actual == expected);
+
+        REQUIRE(result->uri() == "package.module");
+        REQUIRE(result->findExportByName("a").kind() == ExportDescriptor::Element);
+        REQUIRE(result->findFile("B.lv"));
+        REQUIRE(result->findFile("A.lv")->dependencies().size() == 2);
+    }
+    SECTION("Truncated Binary"){
+        for ( size_t size = 0; size < binary.size(); ++size ){
+            REQUIRE_THROWS_AS(ModuleDescriptor::createFromBinary(binary.data(), size), lv::Exception);
+        }
+        std::string extended = binary + '\0';
+        REQUIRE_THROWS_AS(ModuleDescriptor::createFromBinary(extended.data(), extended.size()), lv::Exception);
+    }
+    SECTION("Corrupt Binary"){
+        std::string badMagic = binary;
+        badMagic[0] = static_cast<char>(badMagic[0] ^ 0xFF);
+        REQUIRE_THROWS_AS(ModuleDescriptor::createFromBinary(badMagic.data(), badMagic.size()), lv::Exception);
+
+        // any damaged byte either fails with an exception, or reads a descriptor that round trips
+        const unsigned char replacements[] = {0x00, 0x01, 0x7F, 0xFF};
+        for ( size_t i = 0; i < binary.size(); ++i ){
+            for ( unsigned char replacement : replacements ){
+                std::string corrupt = binary;
+                corrupt[i] = static_cast<char>(replacement);
+
+                ModuleDescriptor::Ptr result;
+                try{
+                    result = ModuleDescriptor::createFromBinary(corrupt.data(), corrupt.size());
+                } catch ( lv::Exception& ){
+                    continue;
+                }
+                REQUIRE(result);
+
+                std::string rewritten;
+                result->toBinary(rewritten);
+                ModuleDescriptor::Ptr reread = ModuleDescriptor::createFromBinary(rewritten.data(), rewritten.size());
+
+                std::string expected, actual;
+                ml::toJson(result->toMLNode(), expected);
+                ml::toJson(reread->toMLNode(), actual);
+                REQUIRE(actual == expected);
+            }
+        }
+    }
+}
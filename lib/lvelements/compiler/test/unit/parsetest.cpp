@@ -22,6 +22,7 @@
 
 #include "live/elements/compiler/languageparser.h"
 #include "live/elements/compiler/compiler.h"
+#include "live/elements/compiler/importscanner.h"
 
 using namespace lv;
 using namespace lv::el;
@@ -178,3 +179,55 @@ TEST_CASE( "Parse Test", "[Parse]" ) {
 
 }
 
+TEST_CASE( "Import Scanner Test", "[Parse]" ) {
+    SECTION("Imports"){
+        std::string contents =
+            "import .\n"
+            "import .module as mod\n"
+            "import @scope.package.module\n"
+            "import {A} from './a.js'\n"
+            "import D from './d.js'\n"
+            "import E, F from './e.js'\n"
+            "// import commented\n"
+            "/* import commented */\n"
+            "import package.module as pm\n"
+            "component X < mod.A{}\n";
+
+        ImportScanner::Result result = ImportScanner::scan(contents, "File");
+        REQUIRE(result.imports.size() == 4);
+        REQUIRE(result.imports[0].uri == ".");
+        REQUIRE(result.imports[0].isRelative);
+        REQUIRE(result.imports[1].uri == ".module");
+        REQUIRE(result.imports[1].as == "mod");
+        REQUIRE(result.imports[1].isRelative);
+        REQUIRE(result.imports[2].uri == "@scope.package.module");
+        REQUIRE(!result.imports[2].isRelative);
+        REQUIRE(result.imports[3].uri == "package.module");
+        REQUIRE(result.imports[3].as == "pm");
+    }
+    SECTION("Exports"){
+        std::string contents =
+            "import language\n"
+            "component A < Element{\n"
+            "    string s: '{ component B'\n"
+            "    fn f(){ return /}[}]/.test(`${ { a: 1 } }`) ? 1 : 2 }\n"
+            "    T`This is `B`text with { and component C`\n"
+            "    T```\n"
+            "        `component D`\n"
+            "    ```\n"
+            "    component E{}\n"
+            "}\n"
+            "component < Element{}\n"
+            "component default {}\n"
+            "instance x X{ instance y Y{} }\n";
+
+        ImportScanner::Result result = ImportScanner::scan(contents, "File");
+        REQUIRE(result.imports.size() == 1);
+        REQUIRE(result.exports.size() == 3);
+        REQUIRE(result.exports[0].name() == "A");
+        REQUIRE(result.exports[0].kind() == ExportDescriptor::Component);
+        REQUIRE(result.exports[1].name() == "File");
+        REQUIRE(result.exports[2].name() == "x");
+        REQUIRE(result.exports[2].kind() == ExportDescriptor::Element);
+    }
+}
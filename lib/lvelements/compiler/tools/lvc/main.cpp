@@ -0,0 +1,455 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 Dinu SV.
+** This file is part of Livekeys Application.
+**
+** GNU Lesser General Public License Usage
+** This file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+****************************************************************************/
+
+#include "live/commandlineparser.h"
+#include "live/visuallog.h"
+#include "live/fileio.h"
+#include "live/path.h"
+#include "live/module.h"
+#include "live/package.h"
+#include "live/mlnodetojson.h"
+#include "live/tracer.h"
+#include "live/elements/compiler/compiler.h"
+#include "live/elements/compiler/elementsmodule.h"
+#include "live/elements/compiler/memoryaccounting.h"
+#include "live/elements/compiler/tracepointexception.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace{
+
+enum ExitCode{
+    Success      = 0,
+    CompileError = 1,
+    UsageError   = 2
+};
+
+/**
+ * A single compile unit. Packages are expanded into their modules, and the modules they import are
+ * added as units of their own, so each module is compiled once, by a single worker.
+ */
+class Target{
+public:
+    enum Type{
+        File,
+        Module
+    };
+
+    Target(Type t, const std::string& p) : type(t), path(p), remainingDependencies(0), skipped(false){}
+
+    Type                type;
+    std::string         path;
+    std::vector<size_t> dependents;
+    size_t              remainingDependencies;
+    bool                skipped;
+};
+
+class BuildContext{
+public:
+    BuildContext() : finished(0), failed(0){}
+
+    lv::MLNode               options;
+    std::vector<Target>      targets;
+    std::deque<size_t>       ready;
+    size_t                   finished;
+    std::vector<std::string> builtModules;
+    std::mutex               scheduleMutex;
+    std::condition_variable  scheduleCondition;
+    std::atomic<size_t>      failed;
+    std::mutex               outputMutex;
+
+    void report(const std::string& message){
+        std::lock_guard<std::mutex> lock(outputMutex);
+        std::cerr << message << std::endl;
+    }
+
+    void addDependency(size_t dependency, size_t dependent){
+        std::vector<size_t>& dependents = targets[dependency].dependents;
+        if ( std::find(dependents.begin(), dependents.end(), dependent) != dependents.end() )
+            return;
+        dependents.push_back(dependent);
+        ++targets[dependent].remainingDependencies;
+    }
+
+    /** Records the result of a target and queues the dependents that are ready. Dependents of a failed target are skipped. */
+    void complete(size_t index, bool compiled){
+        std::lock_guard<std::mutex> lock(scheduleMutex);
+        ++finished;
+
+        if ( compiled ){
+            if ( targets[index].type == Target::Module )
+                builtModules.push_back(targets[index].path);
+            for ( size_t dependent : targets[index].dependents ){
+                if ( --targets[dependent].remainingDependencies == 0 && !targets[dependent].skipped )
+                    ready.push_back(dependent);
+            }
+        } else {
+            std::vector<size_t> failedTargets(1, index);
+            while ( !failedTargets.empty() ){
+                const Target& failedTarget = targets[failedTargets.back()];
+                failedTargets.pop_back();
+                for ( size_t dependent : failedTarget.dependents ){
+                    if ( targets[dependent].skipped )
+                        continue;
+                    targets[dependent].skipped = true;
+                    ++finished;
+                    ++failed;
+                    report(targets[dependent].path + ": error: Not compiled, depends on failed target: " + failedTarget.path);
+                    failedTargets.push_back(dependent);
+                }
+            }
+        }
+
+        scheduleCondition.notify_all();
+    }
+};
+
+void collectTargets(const std::string& path, std::vector<Target>& targets){
+    if ( !lv::Path::exists(path) ){
+        THROW_EXCEPTION(lv::Exception, lv::Utf8("Path not found: %").format(path), lv::Exception::toCode("~Path"));
+    }
+
+    std::string resolved = lv::Path::resolve(path);
+    if ( lv::Path::isFile(resolved) ){
+        targets.push_back(Target(Target::File, resolved));
+    } else if ( lv::Package::existsIn(resolved) ){
+        lv::Package::Ptr package = lv::Package::createFromPath(resolved);
+        auto modules = package->allModules();
+        for ( auto it = modules.begin(); it != modules.end(); ++it )
+            targets.push_back(Target(Target::Module, *it));
+    } else if ( lv::Module::existsIn(resolved) ){
+        targets.push_back(Target(Target::Module, resolved));
+    } else {
+        THROW_EXCEPTION(lv::Exception, lv::Utf8("Path is not a file, module or package: %").format(path), lv::Exception::toCode("~Path"));
+    }
+}
+
+/**
+ * Replaces the collected targets with the modules they import, directly or indirectly, in the order
+ * given by Compiler::scanModuleImports, and links each target to the ones it has to wait for.
+ *
+ * Modules in an import cycle wait for each other in scan order. Files wait for the modules their
+ * module imports, and are dropped if their module is a target already, since compiling the module
+ * compiles them. Files outside of modules wait for all modules, since their imports are only known
+ * when they are compiled.
+ */
+void scheduleTargets(BuildContext& context){
+    lv::el::Compiler::Config config;
+    config.enableFileStatCache(true);
+    if ( context.options.type() == lv::MLNode::Object )
+        config.initialize(context.options);
+    lv::el::Compiler::Ptr scanner = lv::el::Compiler::create(config);
+
+    std::vector<Target> collected;
+    collected.swap(context.targets);
+
+    std::map<std::string, size_t> moduleTargets;
+    std::map<std::string, std::vector<lv::Module::Ptr> > imports;
+    std::vector<std::pair<Target, std::vector<lv::Module::Ptr> > > files;
+    std::set<std::string> filePaths;
+
+    for ( const Target& target : collected ){
+        if ( target.type == Target::File ){
+            if ( !filePaths.insert(target.path).second )
+                continue;
+
+            std::string modulePath = lv::Path::parent(target.path);
+            std::vector<lv::Module::Ptr> order;
+            if ( lv::Module::existsIn(modulePath) && !lv::Module::findPackageFrom(modulePath).empty() ){
+                try{
+                    lv::Module::Ptr module = lv::Module::createFromPath(modulePath);
+                    scanner->initializePackageImportPaths(module->package());
+                    order = lv::el::Compiler::scanModuleImports(scanner, module, &imports);
+                } catch ( lv::Exception& ){
+                    // compiled like a file outside of modules, which reports the error
+                    order.clear();
+                }
+            }
+
+            // the last module in the scan is the file's own module
+            for ( size_t i = 0; i + 1 < order.size(); ++i ){
+                if ( moduleTargets.insert(std::make_pair(lv::Path::resolve(order[i]->path()), context.targets.size())).second )
+                    context.targets.push_back(Target(Target::Module, order[i]->path()));
+            }
+            files.push_back(std::make_pair(target, order));
+            continue;
+        }
+
+        std::vector<lv::Module::Ptr> order;
+        try{
+            lv::Module::Ptr module = lv::Module::createFromPath(target.path);
+            scanner->initializePackageImportPaths(module->package());
+            order = lv::el::Compiler::scanModuleImports(scanner, module, &imports);
+        } catch ( lv::Exception& ){
+            // compiled without dependencies, which reports the error
+            if ( moduleTargets.insert(std::make_pair(lv::Path::resolve(target.path), context.targets.size())).second )
+                context.targets.push_back(target);
+            continue;
+        }
+
+        for ( const lv::Module::Ptr& m : order ){
+            if ( moduleTargets.insert(std::make_pair(lv::Path::resolve(m->path()), context.targets.size())).second )
+                context.targets.push_back(Target(Target::Module, m->path()));
+        }
+    }
+
+    size_t totalModules = context.targets.size();
+    for ( size_t i = 0; i < totalModules; ++i ){
+        for ( const lv::Module::Ptr& imported : imports[context.targets[i].path] ){
+            auto it = moduleTargets.find(lv::Path::resolve(imported->path()));
+            if ( it == moduleTargets.end() || it->second == i )
+                continue;
+            if ( it->second < i )
+                context.addDependency(it->second, i);
+            else
+                context.addDependency(i, it->second);
+        }
+    }
+
+    std::map<std::string, size_t> lastFileInModule;
+    for ( auto& file : files ){
+        std::string modulePath = lv::Path::parent(file.first.path);
+        bool inModule = !file.second.empty();
+        if ( inModule && moduleTargets.find(lv::Path::resolve(modulePath)) != moduleTargets.end() )
+            continue;
+
+        size_t index = context.targets.size();
+        context.targets.push_back(file.first);
+
+        if ( inModule ){
+            for ( size_t i = 0; i + 1 < file.second.size(); ++i ){
+                auto it = moduleTargets.find(lv::Path::resolve(file.second[i]->path()));
+                if ( it != moduleTargets.end() )
+                    context.addDependency(it->second, index);
+            }
+        } else {
+            for ( size_t i = 0; i < totalModules; ++i )
+                context.addDependency(i, index);
+            modulePath.clear();
+        }
+
+        // files of the same module, or outside of modules, are compiled one after the other
+        auto last = lastFileInModule.find(modulePath);
+        if ( last != lastFileInModule.end() )
+            context.addDependency(last->second, index);
+        lastFileInModule[modulePath] = index;
+    }
+
+    for ( size_t i = 0; i < context.targets.size(); ++i ){
+        if ( context.targets[i].remainingDependencies == 0 )
+            context.ready.push_back(i);
+    }
+}
+
+void compileTarget(lv::el::Compiler::Ptr compiler, const Target& target){
+    if ( target.type == Target::File ){
+        std::string packagePath = lv::Module::findPackageFrom(lv::Path::parent(target.path));
+        if ( !packagePath.empty() )
+            compiler->initializePackageImportPaths(packagePath);
+        lv::el::Compiler::compile(compiler, target.path);
+    } else {
+        lv::Module::Ptr module = lv::Module::createFromPath(target.path);
+        compiler->initializePackageImportPaths(module->package());
+        lv::el::Compiler::compileModule(compiler, target.path);
+    }
+}
+
+/**
+ * Compiles targets as their dependencies finish, until there are none left. Each worker uses its
+ * own compiler, which loads the modules built by other workers from their descriptors.
+ */
+void runWorker(BuildContext* context){
+    lv::el::Compiler::Ptr compiler(nullptr);
+    size_t markedModules = 0;
+
+    while ( true ){
+        size_t index;
+        std::vector<std::string> builtModules;
+        {
+            std::unique_lock<std::mutex> lock(context->scheduleMutex);
+            context->scheduleCondition.wait(lock, [context](){
+                return !context->ready.empty() || context->finished == context->targets.size();
+            });
+            if ( context->ready.empty() )
+                return;
+
+            index = context->ready.front();
+            context->ready.pop_front();
+            builtModules.assign(context->builtModules.begin() + static_cast<std::ptrdiff_t>(markedModules), context->builtModules.end());
+        }
+
+        const Target& target = context->targets[index];
+        bool compiled = false;
+        try{
+            if ( !compiler ){
+                lv::el::Compiler::Config config;
+                config.enableFileStatCache(true);
+                if ( context->options.type() == lv::MLNode::Object )
+                    config.initialize(context->options);
+                compiler = lv::el::Compiler::create(config);
+            }
+            for ( const std::string& modulePath : builtModules )
+                compiler->markModuleBuilt(modulePath);
+            markedModules += builtModules.size();
+
+            compileTarget(compiler, target);
+            compiled = true;
+
+        } catch ( lv::el::SyntaxException& e ){
+            ++context->failed;
+            auto location = e.parsedLocation();
+            auto start = location.range().start();
+            if ( start.hasLine() && !location.filePath().empty() ){
+                context->report(
+                    lv::Utf8("%:%:%: error: %").format(location.filePath(), start.line(), start.column(), e.message()).data()
+                );
+            } else {
+                context->report(target.path + ": error: " + e.message());
+            }
+        } catch ( lv::Exception& e ){
+            ++context->failed;
+            context->report(target.path + ": error: " + e.message());
+        } catch ( std::exception& e ){
+            ++context->failed;
+            context->report(target.path + ": error: " + e.what());
+        }
+
+        context->complete(index, compiled);
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]){
+    lv::CommandLineParser parser(
+        "Live Elements compiler. Compiles files, modules or packages without going through node."
+    );
+    parser.setUsage("lvc [options...] <file|module|package> [paths ...]");
+
+    lv::CommandLineParser::Option* jobsOption = parser.addOption(
+        {"-j", "--jobs"}, "Number of modules to compile in parallel. Defaults to the number of cores.", "N"
+    );
+    lv::CommandLineParser::Option* configOption = parser.addOption(
+        {"-c", "--config"}, "Json file with compiler options, same as the ones passed to the node compiler.", "path"
+    );
+    lv::CommandLineParser::Option* traceOption = parser.addOption(
+        {"-t", "--trace"}, "Write a chrome://tracing file of the build to the given path.", "path"
+    );
+    lv::CommandLineParser::Option* poolOption = parser.addFlag(
+        {"--pool-allocator"}, "Allocate parse trees from per thread pools, reducing malloc contention between jobs."
+    );
+
+    BuildContext context;
+    size_t jobs = std::max(1u, std::thread::hardware_concurrency());
+
+    try{
+        parser.parse(argc, argv);
+
+        if ( parser.isSet(parser.helpOption()) ){
+            std::cout << parser.helpString() << std::endl;
+            return Success;
+        }
+        if ( parser.isSet(parser.versionOption()) ){
+            std::cout << "lvc " << LV_ELEMENTS_COMPILER_VERSION << std::endl;
+            return Success;
+        }
+
+        if ( parser.isSet(jobsOption) ){
+            int value = std::stoi(parser.value(jobsOption));
+            if ( value < 1 ){
+                THROW_EXCEPTION(lv::Exception, "Number of jobs needs to be at least 1.", lv::Exception::toCode("~Arguments"));
+            }
+            jobs = static_cast<size_t>(value);
+        }
+        if ( parser.isSet(poolOption) )
+            lv::el::MemoryAccounting::setTreeSitterAllocator(lv::el::MemoryAccounting::PoolAllocator);
+        if ( parser.isSet(configOption) ){
+            lv::FileIO fileIO;
+            lv::ml::fromJson(fileIO.readFromFile(parser.value(configOption)), context.options);
+        }
+
+        std::vector<std::string> paths;
+        if ( !parser.script().empty() )
+            paths.push_back(parser.script());
+        paths.insert(paths.end(), parser.scriptArguments().begin(), parser.scriptArguments().end());
+        if ( paths.empty() ){
+            THROW_EXCEPTION(lv::Exception, "No file, module or package given to compile.", lv::Exception::toCode("~Arguments"));
+        }
+
+        for ( const std::string& path : paths )
+            collectTargets(path, context.targets);
+
+    } catch ( lv::Exception& e ){
+        std::cerr << "lvc: error: " << e.message() << std::endl;
+        return UsageError;
+    } catch ( std::exception& e ){
+        std::cerr << "lvc: error: " << e.what() << std::endl;
+        return UsageError;
+    }
+
+    if ( parser.isSet(traceOption) ){
+#ifndef LV_ENABLE_TRACING
+        std::cerr << "lvc: warning: tracing is not compiled in, build with ENABLE_TRACING to record a trace." << std::endl;
+#endif
+        lv::Tracer::start();
+    }
+
+    try{
+        scheduleTargets(context);
+    } catch ( lv::Exception& e ){
+        std::cerr << "lvc: error: " << e.message() << std::endl;
+        if ( parser.isSet(traceOption) )
+            lv::Tracer::stop();
+        return CompileError;
+    }
+
+    jobs = std::min(jobs, context.targets.size());
+
+    if ( jobs <= 1 ){
+        runWorker(&context);
+    } else {
+        std::vector<std::thread> workers;
+        for ( size_t i = 0; i < jobs; ++i )
+            workers.push_back(std::thread(runWorker, &context));
+        for ( auto& worker : workers )
+            worker.join();
+    }
+
+    if ( parser.isSet(traceOption) ){
+        lv::Tracer::stop();
+        try{
+            lv::Tracer::save(parser.value(traceOption));
+        } catch ( lv::Exception& e ){
+            std::cerr << "lvc: error: " << e.message() << std::endl;
+        }
+    }
+
+    size_t failed = context.failed;
+    if ( failed > 0 ){
+        std::cerr << "lvc: " << failed << " of " << context.targets.size() << " targets failed." << std::endl;
+        return CompileError;
+    }
+
+    return Success;
+}
@@ -0,0 +1,549 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 Dinu SV.
+** This file is part of Livekeys Application.
+**
+** GNU Lesser General Public License Usage
+** This file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+****************************************************************************/
+
+#include "compilerdaemon.h"
+#include "live/path.h"
+#include "live/module.h"
+#include "live/package.h"
+#include "live/visuallog.h"
+#include "live/mlnodetojson.h"
+#include "live/filestatcache.h"
+#include "live/elements/compiler/compiler.h"
+#include "live/elements/compiler/elementsmodule.h"
+#include "live/elements/compiler/modulefile.h"
+#include "live/elements/compiler/tracepointexception.h"
+#include "live/elements/compiler/memoryaccounting.h"
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <vector>
+
+#ifdef PLATFORM_OS_UNIX
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#endif
+
+namespace lv{ namespace el{
+
+namespace{
+
+class RequestException : public lv::Exception{
+public:
+    RequestException(const std::string& message, int rpcCode)
+        : lv::Exception(message, 0), rpcCode(rpcCode){}
+
+    int rpcCode;
+};
+
+MLNode createError(int code, const std::string& message, const MLNode& data = MLNode()){
+    MLNode error(MLNode::Object);
+    error["code"] = code;
+    error["message"] = message;
+    if ( !data.isNull() )
+        error["data"] = data;
+    return error;
+}
+
+MLNode createErrorData(lv::Exception& e){
+    MLNode data(MLNode::Object);
+    data["message"] = e.message();
+    data["code"] = static_cast<MLNode::IntType>(e.code());
+    return data;
+}
+
+// the daemon's working directory is unrelated to the client's, so relative paths are rejected
+const std::string& requirePath(const MLNode& params){
+    if ( params.type() != MLNode::Object || !params.hasKey("path") || params["path"].type() != MLNode::String )
+        throw RequestException("Expected params: {path: String}.", CompilerDaemon::InvalidParams);
+    const std::string& path = params["path"].asString();
+    if ( !Path::isAbsolute(path) )
+        throw RequestException("Expected an absolute path: " + path, CompilerDaemon::InvalidParams);
+    return path;
+}
+
+// requests are small, a client sending more than this without a line break is dropped
+const size_t MaxMessageSize = 16 * 1024 * 1024;
+
+#ifdef PLATFORM_OS_UNIX
+
+bool writeAll(int fd, const std::string& data){
+    size_t written = 0;
+    while ( written < data.size() ){
+        ssize_t result = ::write(fd, data.data() + written, data.size() - written);
+        if ( result < 0 && errno == EINTR )
+            continue;
+        if ( result <= 0 )
+            return false;
+        written += static_cast<size_t>(result);
+    }
+    return true;
+}
+
+sockaddr_un socketAddress(const std::string& socketPath){
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if ( socketPath.size() >= sizeof(address.sun_path) ){
+        THROW_EXCEPTION(lv::Exception, Utf8("Socket path is too long: %").format(socketPath), lv::Exception::toCode("~Path"));
+    }
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size());
+    return address;
+}
+
+#endif
+
+} // namespace
+
+/// \private
+class CompilerDaemonPrivate{
+
+public:
+    CompilerDaemonPrivate(const MLNode& options, bool watch)
+        : defaultOptions(options)
+        , watchFiles(watch)
+        , running(false)
+        , requests(0)
+        , compiles(0)
+        , errors(0)
+        , startTime(std::chrono::steady_clock::now())
+    {}
+
+    Compiler::Ptr compilerFor(const MLNode& params);
+
+    MLNode compile(const MLNode& params);
+    MLNode compileModule(const MLNode& params);
+    MLNode invalidate(const MLNode& params);
+    MLNode stats();
+
+    MLNode defaultOptions;
+    bool   watchFiles;
+
+    std::atomic<bool> running;
+    std::map<std::string, Compiler::Ptr> compilers;
+
+    size_t requests;
+    size_t compiles;
+    size_t errors;
+    std::chrono::steady_clock::time_point startTime;
+};
+
+/**
+ * Returns the compiler for the options in \p params, creating it if there's none yet. Clients using the
+ * same options share the same compiler.
+ */
+Compiler::Ptr CompilerDaemonPrivate::compilerFor(const MLNode &params){
+    const MLNode& options = (params.type() == MLNode::Object && params.hasKey("options")) ? params["options"] : defaultOptions;
+
+    std::string key;
+    ml::toJson(options, key);
+
+    auto it = compilers.find(key);
+    if ( it != compilers.end() )
+        return it->second;
+
+    Compiler::Config config;
+    config.enableFileStatCache(true);
+    if ( options.type() == MLNode::Object )
+        config.initialize(options);
+    if ( watchFiles )
+        config.enableFileStatCache(true, true);
+
+    Compiler::Ptr compiler = Compiler::create(config);
+    compilers[key] = compiler;
+
+    vlog("lvcompilerd").v() << "CompilerDaemon: Created compiler for options: " << key;
+
+    return compiler;
+}
+
+MLNode CompilerDaemonPrivate::compile(const MLNode &params){
+    std::string path = requirePath(params);
+    if ( !Path::exists(path) ){
+        THROW_EXCEPTION(lv::Exception, Utf8("Compiler: Script file not found: \'%\'.").format(path), lv::Exception::toCode("~File"));
+    }
+
+    Compiler::Ptr compiler = compilerFor(params);
+    std::string scriptFile = Path::resolveCached(path);
+
+    std::string packagePath = Module::findPackageFrom(Path::parent(scriptFile));
+    if ( !packagePath.empty() )
+        compiler->initializePackageImportPaths(packagePath);
+
+    ElementsModule::Ptr elemMod = Compiler::compile(compiler, scriptFile);
+    ++compiles;
+
+    MLNode result(MLNode::Object);
+    result["path"] = scriptFile;
+    ModuleFile* mf = elemMod->moduleFileBypath(scriptFile);
+    if ( mf )
+        result["output"] = Path::toUnixSeparator(mf->jsFilePath());
+    return result;
+}
+
+MLNode CompilerDaemonPrivate::compileModule(const MLNode &params){
+    std::string modulePath = requirePath(params);
+    if ( !Path::exists(modulePath) || !Module::existsIn(modulePath) ){
+        THROW_EXCEPTION(lv::Exception, Utf8("Compiler: Module path not found: \'%\'.").format(modulePath), lv::Exception::toCode("~Path"));
+    }
+
+    Compiler::Ptr compiler = compilerFor(params);
+
+    Module::Ptr module = Module::createFromPath(modulePath);
+    Package::Ptr package = Package::createFromPath(module->package());
+    if ( package )
+        compiler->initializePackageImportPaths(package->path());
+
+    ElementsModule::Ptr elemMod = Compiler::compileModule(compiler, modulePath);
+    ++compiles;
+
+    MLNode result(MLNode::Object);
+    result["path"] = modulePath;
+    if ( elemMod )
+        result["output"] = compiler->moduleBuildPath(elemMod->module());
+    return result;
+}
+
+/**
+ * Invalidates cached state for \p params.path in all compilers. Without a path, all compilers are
+ * dropped and will be recreated on the next request.
+ */
+MLNode CompilerDaemonPrivate::invalidate(const MLNode &params){
+    MLNode result(MLNode::Object);
+
+    if ( params.type() == MLNode::Object && params.hasKey("path") ){
+        std::string path = requirePath(params);
+        for ( auto it = compilers.begin(); it != compilers.end(); ++it )
+            it->second->invalidate(path);
+        result["path"] = path;
+    } else {
+        result["compilers"] = static_cast<MLNode::IntType>(compilers.size());
+        compilers.clear();
+        Path::clearResolveCache();
+    }
+
+    return result;
+}
+
+/**
+ * Returns request counts, cache stats of each compiler and memory accounting. Per file memory stats
+ * cover the files compiled since the previous stats request, so they don't grow with the daemon's uptime.
+ */
+MLNode CompilerDaemonPrivate::stats(){
+    auto uptime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime);
+
+    MLNode result(MLNode::Object);
+    result["uptimeMs"] = static_cast<MLNode::IntType>(uptime.count());
+    result["requests"] = static_cast<MLNode::IntType>(requests);
+    result["compiles"] = static_cast<MLNode::IntType>(compiles);
+    result["errors"]   = static_cast<MLNode::IntType>(errors);
+
+    MLNode compilerStats(MLNode::Array);
+    for ( auto it = compilers.begin(); it != compilers.end(); ++it ){
+        MLNode cs(MLNode::Object);
+        cs["options"] = it->first;
+
+        FileStatCache* fsc = it->second->fileStatCache();
+        if ( fsc ){
+            MLNode cacheStats(MLNode::Object);
+            cacheStats["hits"] = static_cast<MLNode::IntType>(fsc->hits());
+            cacheStats["misses"] = static_cast<MLNode::IntType>(fsc->misses());
+            cacheStats["watching"] = fsc->isWatching();
+            cs["fileStatCache"] = cacheStats;
+        }
+        compilerStats.append(cs);
+    }
+    result["compilers"] = compilerStats;
+    result["memory"] = MemoryAccounting::toMLNode();
+    MemoryAccounting::clearFiles();
+
+    return result;
+}
+
+
+// class CompilerDaemon
+// ----------------------------------------------------------------------------
+
+CompilerDaemon::CompilerDaemon(const MLNode &defaultOptions, bool watchFiles)
+    : m_d(new CompilerDaemonPrivate(defaultOptions, watchFiles))
+{
+}
+
+CompilerDaemon::~CompilerDaemon(){
+    delete m_d;
+}
+
+/**
+ * \brief Parses a single JSON-RPC message and returns the serialized response
+ *
+ * Returns an empty string for notifications, which don't get a response.
+ */
+std::string CompilerDaemon::handleMessage(const std::string &message){
+    MLNode response;
+    MLNode request;
+    try{
+        ml::fromJson(message, request);
+        response = handleRequest(request);
+    } catch ( lv::Exception& e ){
+        ++m_d->errors;
+        response = MLNode(MLNode::Object);
+        response["jsonrpc"] = "2.0";
+        response["id"] = MLNode();
+        response["error"] = createError(CompilerDaemon::ParseError, "Parse error: " + e.message());
+    }
+
+    std::string result;
+    if ( !response.isNull() )
+        ml::toJson(response, result);
+    return result;
+}
+
+/**
+ * \brief Runs a JSON-RPC request and returns the response object
+ *
+ * Supported methods are \c compile, \c compileModule, \c invalidate, \c stats and \c shutdown.
+ * Notifications (requests without an id) are run as well, but return a null node instead of a
+ * response.
+ */
+MLNode CompilerDaemon::handleRequest(const MLNode &request){
+    ++m_d->requests;
+
+    bool isNotification =
+        request.type() == MLNode::Object && !request.hasKey("id") &&
+        request.hasKey("method") && request["method"].type() == MLNode::String;
+
+    MLNode response(MLNode::Object);
+    response["jsonrpc"] = "2.0";
+    response["id"] = (request.type() == MLNode::Object && request.hasKey("id")) ? request["id"] : MLNode();
+
+    try{
+        if ( request.type() != MLNode::Object || !request.hasKey("method") || request["method"].type() != MLNode::String )
+            throw RequestException("Invalid request.", CompilerDaemon::InvalidRequest);
+
+        const std::string& method = request["method"].asString();
+        MLNode params = request.hasKey("params") ? request["params"] : MLNode(MLNode::Object);
+
+        if ( method == "compile" ){
+            response["result"] = m_d->compile(params);
+        } else if ( method == "compileModule" ){
+            response["result"] = m_d->compileModule(params);
+        } else if ( method == "invalidate" ){
+            response["result"] = m_d->invalidate(params);
+        } else if ( method == "stats" ){
+            response["result"] = m_d->stats();
+        } else if ( method == "shutdown" ){
+            stop();
+            response["result"] = true;
+        } else {
+            throw RequestException("Method not found: " + method, CompilerDaemon::MethodNotFound);
+        }
+
+    } catch ( RequestException& e ){
+        ++m_d->errors;
+        response["error"] = createError(e.rpcCode, e.message());
+    } catch ( lv::el::SyntaxException& e ){
+        ++m_d->errors;
+        MLNode data = createErrorData(e);
+        MLNode source(MLNode::Object);
+        source["file"]   = e.parsedLocation().filePath();
+        source["line"]   = static_cast<MLNode::IntType>(e.parsedLocation().range().start().line());
+        source["column"] = static_cast<MLNode::IntType>(e.parsedLocation().range().start().column());
+        source["offset"] = static_cast<MLNode::IntType>(e.parsedLocation().range().start().offset());
+        data["source"] = source;
+        response["error"] = createError(CompilerDaemon::CompileError, e.message(), data);
+    } catch ( lv::Exception& e ){
+        ++m_d->errors;
+        response["error"] = createError(CompilerDaemon::CompileError, e.message(), createErrorData(e));
+    } catch ( std::exception& e ){
+        ++m_d->errors;
+        response["error"] = createError(CompilerDaemon::CompileError, e.what());
+    }
+
+    return isNotification ? MLNode() : response;
+}
+
+/**
+ * \brief Listens on \p socketPath and serves requests until stop() is called
+ *
+ * Requests are handled one at a time on the calling thread, so a long compile delays the requests of
+ * all other clients. Clients sending a message longer than 16MB are disconnected.
+ *
+ * Throws if the socket cannot be created, or if another daemon is already listening on it.
+ */
+void CompilerDaemon::listen(const std::string &socketPath){
+#ifdef PLATFORM_OS_UNIX
+    sockaddr_un address = socketAddress(socketPath);
+
+    if ( Path::exists(socketPath) ){
+        int probe = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        bool inUse = probe >= 0 && ::connect(probe, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+        if ( probe >= 0 )
+            ::close(probe);
+        if ( inUse ){
+            THROW_EXCEPTION(lv::Exception, Utf8("Another daemon is listening on: %").format(socketPath), lv::Exception::toCode("~Socket"));
+        }
+        ::unlink(socketPath.c_str());
+    }
+
+    int server = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if ( server < 0 ){
+        THROW_EXCEPTION(lv::Exception, Utf8("Failed to create socket: %").format(std::strerror(errno)), lv::Exception::toCode("~Socket"));
+    }
+
+    // only the owner may connect, the socket is created with these permissions so there's no window
+    // where other users can reach it
+    mode_t previousMask = ::umask(0077);
+    int bound = ::bind(server, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    int bindErrno = errno;
+    ::umask(previousMask);
+    errno = bindErrno;
+
+    if ( bound != 0 || ::chmod(socketPath.c_str(), S_IRUSR | S_IWUSR) != 0 || ::listen(server, 16) != 0 ){
+        std::string error = std::strerror(errno);
+        ::close(server);
+        if ( bound == 0 )
+            ::unlink(socketPath.c_str());
+        THROW_EXCEPTION(lv::Exception, Utf8("Failed to listen on \'%\': %").format(socketPath, error), lv::Exception::toCode("~Socket"));
+    }
+
+    vlog("lvcompilerd").i() << "CompilerDaemon: Listening on " << socketPath;
+
+    std::vector<pollfd> fds;
+    std::map<int, std::string> buffers;
+
+    pollfd serverPoll;
+    serverPoll.fd = server;
+    serverPoll.events = POLLIN;
+    serverPoll.revents = 0;
+    fds.push_back(serverPoll);
+
+    m_d->running = true;
+    while ( m_d->running ){
+        if ( ::poll(fds.data(), static_cast<nfds_t>(fds.size()), -1) < 0 ){
+            if ( errno == EINTR )
+                continue;
+            break;
+        }
+
+        std::vector<int> closed;
+        for ( size_t i = 1; i < fds.size(); ++i ){
+            if ( !fds[i].revents )
+                continue;
+
+            char chunk[4096];
+            ssize_t length = ::read(fds[i].fd, chunk, sizeof(chunk));
+            if ( length < 0 && errno == EINTR )
+                continue;
+            if ( length <= 0 ){
+                closed.push_back(fds[i].fd);
+                continue;
+            }
+
+            std::string& buffer = buffers[fds[i].fd];
+            buffer.append(chunk, static_cast<size_t>(length));
+
+            bool writeFailed = false;
+            size_t lineEnd;
+            while ( (lineEnd = buffer.find('\n')) != std::string::npos ){
+                std::string message = buffer.substr(0, lineEnd);
+                buffer.erase(0, lineEnd + 1);
+                if ( message.find_first_not_of(" \t\r") == std::string::npos )
+                    continue;
+                std::string response = handleMessage(message);
+                if ( !response.empty() && !writeAll(fds[i].fd, response + "\n") ){
+                    writeFailed = true;
+                    break;
+                }
+            }
+
+            if ( writeFailed ){
+                closed.push_back(fds[i].fd);
+            } else if ( buffer.size() > MaxMessageSize ){
+                vlog("lvcompilerd").w() << "CompilerDaemon: Closing client, message exceeds " << MaxMessageSize << " bytes.";
+                closed.push_back(fds[i].fd);
+            }
+        }
+
+        if ( fds[0].revents & POLLIN ){
+            int client = ::accept(server, nullptr, nullptr);
+            if ( client >= 0 ){
+                pollfd clientPoll;
+                clientPoll.fd = client;
+                clientPoll.events = POLLIN;
+                clientPoll.revents = 0;
+                fds.push_back(clientPoll);
+            }
+        }
+
+        for ( int fd : closed ){
+            ::close(fd);
+            buffers.erase(fd);
+            for ( auto it = fds.begin(); it != fds.end(); ++it ){
+                if ( it->fd == fd ){
+                    fds.erase(it);
+                    break;
+                }
+            }
+        }
+    }
+
+    for ( size_t i = 1; i < fds.size(); ++i )
+        ::close(fds[i].fd);
+    ::close(server);
+    ::unlink(socketPath.c_str());
+    m_d->running = false;
+
+    vlog("lvcompilerd").i() << "CompilerDaemon: Stopped.";
+#else
+    MARK_UNUSED(socketPath);
+    THROW_EXCEPTION(lv::Exception, "CompilerDaemon: Unix domain sockets are not supported on this platform.", lv::Exception::toCode("~Platform"));
+#endif
+}
+
+/**
+ * \brief Stops listening after the current request. Safe to call from a signal handler.
+ */
+void CompilerDaemon::stop(){
+    m_d->running = false;
+}
+
+bool CompilerDaemon::isRunning() const{
+    return m_d->running;
+}
+
+/**
+ * \brief Returns a per-user socket path
+ *
+ * Uses the user's runtime directory when there is one, otherwise the temporary directory with the
+ * user id in the socket name.
+ */
+std::string CompilerDaemon::defaultSocketPath(){
+#ifdef PLATFORM_OS_UNIX
+    const char* runtimeDir = std::getenv("XDG_RUNTIME_DIR");
+    if ( runtimeDir && *runtimeDir && Path::isDir(runtimeDir) )
+        return Path::join(runtimeDir, "lvcompilerd.sock");
+    return Path::join(Path::temporaryDirectory(), "lvcompilerd-" + std::to_string(::getuid()) + ".sock");
+#else
+    return Path::join(Path::temporaryDirectory(), "lvcompilerd.sock");
+#endif
+}
+
+}} // namespace lv, el
@@ -0,0 +1,68 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 Dinu SV.
+** This file is part of Livekeys Application.
+**
+** GNU Lesser General Public License Usage
+** This file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+****************************************************************************/
+
+#ifndef LVCOMPILERDAEMON_H
+#define LVCOMPILERDAEMON_H
+
+#include "live/lvbaseglobal.h"
+#include "live/mlnode.h"
+
+#include <string>
+
+namespace lv{ namespace el{
+
+class CompilerDaemonPrivate;
+
+/**
+ * \class lv::el::CompilerDaemon
+ * \brief Keeps compilers resident and serves JSON-RPC requests over a Unix domain socket
+ *
+ * Requests are newline delimited JSON-RPC 2.0 messages, and each gets a single line response.
+ * Notifications get no response. Compilers are shared between clients that use the same compiler
+ * options. Requests are served one at a time, in the order they are read.
+ */
+class CompilerDaemon{
+
+    DISABLE_COPY(CompilerDaemon);
+
+public:
+    enum ErrorCode{
+        ParseError     = -32700,
+        InvalidRequest = -32600,
+        MethodNotFound = -32601,
+        InvalidParams  = -32602,
+        CompileError   = -32000
+    };
+
+public:
+    CompilerDaemon(const MLNode& defaultOptions = MLNode(), bool watchFiles = false);
+    ~CompilerDaemon();
+
+    std::string handleMessage(const std::string& message);
+    MLNode handleRequest(const MLNode& request);
+
+    void listen(const std::string& socketPath);
+    void stop();
+    bool isRunning() const;
+
+    static std::string defaultSocketPath();
+
+private:
+    CompilerDaemonPrivate* m_d;
+};
+
+}} // namespace lv, el
+
+#endif // LVCOMPILERDAEMON_H
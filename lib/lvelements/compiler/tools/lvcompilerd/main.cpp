@@ -0,0 +1,115 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 Dinu SV.
+** This file is part of Livekeys Application.
+**
+** GNU Lesser General Public License Usage
+** This file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+****************************************************************************/
+
+#include "compilerdaemon.h"
+#include "live/commandlineparser.h"
+#include "live/visuallog.h"
+#include "live/fileio.h"
+#include "live/mlnodetojson.h"
+#include "live/tracer.h"
+#include "live/elements/compiler/memoryaccounting.h"
+
+#include <csignal>
+#include <iostream>
+
+namespace{
+
+lv::el::CompilerDaemon* runningDaemon = nullptr;
+
+void stopDaemon(int){
+    if ( runningDaemon )
+        runningDaemon->stop();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]){
+    lv::CommandLineParser parser(
+        "Live Elements compiler daemon. Keeps compilers resident and serves newline delimited "
+        "JSON-RPC requests (compile, compileModule, invalidate, stats, shutdown) over a Unix domain socket. "
+        "Requests take absolute paths and are served one at a time, so a long compile delays other clients."
+    );
+    parser.setUsage("lvcompilerd [options...]");
+
+    lv::CommandLineParser::Option* socketOption = parser.addOption(
+        {"-s", "--socket"}, "Socket path to listen on, created accessible only to the current user. Defaults to lvcompilerd.sock in "
+        "the user's runtime directory, or to lvcompilerd-<uid>.sock in the temporary directory.", "path"
+    );
+    lv::CommandLineParser::Option* configOption = parser.addOption(
+        {"-c", "--config"}, "Json file with the compiler options used by requests that don't specify any.", "path"
+    );
+    lv::CommandLineParser::Option* watchOption = parser.addFlag(
+        {"-w", "--watch"}, "Watch source files, so file stats stay cached between requests."
+    );
+    lv::CommandLineParser::Option* traceOption = parser.addOption(
+        {"-t", "--trace"}, "Record a chrome://tracing file of compiler activity, written on shutdown.", "path"
+    );
+
+    try{
+        parser.parse(argc, argv);
+
+        if ( parser.isSet(parser.helpOption()) ){
+            std::cout << parser.helpString() << std::endl;
+            return 0;
+        }
+        if ( parser.isSet(parser.versionOption()) ){
+            std::cout << "lvcompilerd " << LV_ELEMENTS_COMPILER_VERSION << std::endl;
+            return 0;
+        }
+
+        // served by the stats request, requests are handled one at a time so counting is cheap
+        lv::el::MemoryAccounting::setEnabled(true);
+
+        lv::MLNode defaultOptions;
+        if ( parser.isSet(configOption) ){
+            lv::FileIO fileIO;
+            lv::ml::fromJson(fileIO.readFromFile(parser.value(configOption)), defaultOptions);
+        }
+
+        std::string socketPath = parser.isSet(socketOption)
+            ? parser.value(socketOption)
+            : lv::el::CompilerDaemon::defaultSocketPath();
+
+        if ( parser.isSet(traceOption) ){
+#ifndef LV_ENABLE_TRACING
+            std::cerr << "Warning: Tracing is not compiled in, build with ENABLE_TRACING to record a trace." << std::endl;
+#endif
+            lv::Tracer::start();
+        }
+
+        lv::el::CompilerDaemon daemon(defaultOptions, parser.isSet(watchOption));
+        runningDaemon = &daemon;
+
+        std::signal(SIGINT, stopDaemon);
+        std::signal(SIGTERM, stopDaemon);
+#ifdef PLATFORM_OS_UNIX
+        std::signal(SIGPIPE, SIG_IGN);
+#endif
+
+        daemon.listen(socketPath);
+        runningDaemon = nullptr;
+
+        if ( parser.isSet(traceOption) ){
+            lv::Tracer::stop();
+            lv::Tracer::save(parser.value(traceOption));
+        }
+
+    } catch ( lv::Exception& e ){
+        std::cerr << "Error: " << e.message() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}